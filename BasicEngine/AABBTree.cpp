@@ -0,0 +1,1110 @@
+#include "AABBTree.h"
+#include "Collision.h"
+#include <algorithm>
+
+AABBTree::AABBTree(const float margin)
+	:m_root(NO_INDEX),
+	m_freeNode(NO_INDEX),
+	m_count(0),
+	m_margin(margin)
+{
+	if (m_margin < 0.0f)
+	{
+		m_margin = 0.0f;
+	}
+}
+
+AABBTree::~AABBTree()
+{
+	clear();
+}
+
+//=============================================================================
+// Function: const int getHeight() const
+// Description:
+// Gets the height of the tree.
+// Output:
+// const int
+// Returns the height, 0 for a tree with one leaf or none.
+//=============================================================================
+const int AABBTree::getHeight() const
+{
+	int height = 0;
+
+	if (m_root != NO_INDEX)
+	{
+		height = m_nodes[m_root].m_height;
+	}
+
+	return height;
+}
+
+//=============================================================================
+// Function: const int getCount() const
+// Description:
+// Gets the number of entities stored.
+// Output:
+// const int
+// Returns the entity count.
+//=============================================================================
+const int AABBTree::getCount() const
+{
+	return m_count;
+}
+
+//=============================================================================
+// Function: void search(const Rectangle&,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Searches the branches whose boxes reach the area and visits the
+// entities that collide with it.
+// Parameters:
+// const Rectangle& searchArea - The area to search inside.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call. The
+// search stops as soon as it returns false.
+//=============================================================================
+void AABBTree::search(const Rectangle& searchArea,
+	ISpatialVisitor<EntityData>& visitor) const
+{
+	if (m_root != NO_INDEX)
+	{
+		search(m_root, getBounds(searchArea), searchArea, visitor);
+	}
+}
+
+//=============================================================================
+// Function: void search(const Line&,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Searches the branches whose boxes the line crosses and visits
+// the entities the line touches.
+// Parameters:
+// const Line& searchLine - The line to search along.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call. The
+// search stops as soon as it returns false.
+//=============================================================================
+void AABBTree::search(const Line& searchLine,
+	ISpatialVisitor<EntityData>& visitor) const
+{
+	if (m_root != NO_INDEX)
+	{
+		search(m_root, searchLine, visitor);
+	}
+}
+
+//=============================================================================
+// Function: void addEntity(const EntityData&)
+// Description:
+// Adds the entity as a leaf with a grown box.
+// Parameters:
+// const EntityData& entity - The entity to add.
+//=============================================================================
+void AABBTree::addEntity(const EntityData& entity)
+{
+	int leaf = createNode();
+
+	TreeNode& node = m_nodes[leaf];
+
+	node.m_data = entity;
+	node.m_box = getBounds(entity.m_size);
+	node.m_box.m_minX -= m_margin;
+	node.m_box.m_minY -= m_margin;
+	node.m_box.m_maxX += m_margin;
+	node.m_box.m_maxY += m_margin;
+
+	m_leafLookup[entity.m_id] = leaf;
+	m_count++;
+
+	insertLeaf(leaf);
+}
+
+//=============================================================================
+// Function: void removeEntity(const EntityData&)
+// Description:
+// Finds the entity's leaf and removes it from the tree.
+// Parameters:
+// const EntityData& entity - The entity to remove.
+//=============================================================================
+void AABBTree::removeEntity(const EntityData& entity)
+{
+	auto lookup = m_leafLookup.find(entity.m_id);
+
+	if (lookup != m_leafLookup.end())
+	{
+		int leaf = lookup->second;
+
+		m_leafLookup.erase(lookup);
+
+		removeLeaf(leaf);
+		releaseNode(leaf);
+
+		m_count--;
+	}
+}
+
+//=============================================================================
+// Function: void moveEntity(const EntityData&, const Rectangle&)
+// Description:
+// Moves an entity to a new size. While it stays inside its leaf's
+// grown box only the size is updated, otherwise the leaf is taken
+// out and put back in with a new box. The old size isn't needed.
+// Parameters:
+// const EntityData& entity - The entity at its old size.
+// const Rectangle& size - The new size.
+//=============================================================================
+void AABBTree::moveEntity(const EntityData& entity,
+	const Rectangle& size)
+{
+	auto lookup = m_leafLookup.find(entity.m_id);
+
+	if (lookup != m_leafLookup.end())
+	{
+		int leaf = lookup->second;
+
+		TreeNode& node = m_nodes[leaf];
+		TreeBox bounds = getBounds(size);
+
+		node.m_data.m_size = size;
+		node.m_data.m_flags = entity.m_flags;
+
+		if (!node.m_box.contains(bounds))
+		{
+			removeLeaf(leaf);
+
+			m_nodes[leaf].m_box = TreeBox(bounds.m_minX - m_margin,
+				bounds.m_minY - m_margin,
+				bounds.m_maxX + m_margin,
+				bounds.m_maxY + m_margin);
+
+			insertLeaf(leaf);
+		}
+	}
+}
+
+//=============================================================================
+// Function: bool raycast(const Line&,
+// RaycastHit&,
+// const ISpatialFilter<EntityData>*) const
+// Description:
+// Finds the first entity the ray hits. Children are visited in the
+// order the ray reaches their boxes, and boxes the ray reaches after
+// the closest hit so far are skipped.
+// Parameters:
+// const Line& ray - The ray to cast, from its start to its end.
+// RaycastHit& hit - Set to the closest hit.
+// const ISpatialFilter<EntityData> *filter - Skips the entities it
+// doesn't accept. NULL accepts everything.
+// Output:
+// bool
+// Returns true if something was hit.
+//=============================================================================
+bool AABBTree::raycast(const Line& ray,
+	RaycastHit& hit,
+	const ISpatialFilter<EntityData> *filter) const
+{
+	bool found = false;
+
+	float time = 0.0f;
+
+	if (m_root != NO_INDEX &&
+		segmentEntersBox(m_nodes[m_root].m_box, ray, time))
+	{
+		raycast(m_root, time, ray, filter, hit, found);
+	}
+
+	return found;
+}
+
+//=============================================================================
+// Function: void nearest(const Vector2D&,
+// const int,
+// vector<EntityData>&) const
+// Description:
+// Finds the entities whose centers are closest to the point. A
+// center is always inside its leaf's box, so branches farther away
+// than everything kept are skipped.
+// Parameters:
+// const Vector2D& point - The point to search from.
+// const int count - The most entities to find.
+// vector<EntityData>& nearest - Filled with the entities, closest
+// first. It's cleared first.
+//=============================================================================
+void AABBTree::nearest(const Vector2D& point,
+	const int count,
+	std::vector<EntityData>& nearest) const
+{
+	nearest.clear();
+
+	if (0 < count && m_root != NO_INDEX)
+	{
+		this->nearest(m_root, point, count, nearest);
+
+		sortNearest(point, nearest);
+	}
+}
+
+//=============================================================================
+// Function: void withinRadius(const Vector2D&,
+// const float,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Visits every entity whose center is within the radius of the
+// point, skipping the branches entirely outside of it.
+// Parameters:
+// const Vector2D& point - The center of the circle.
+// const float radius - The radius of the circle.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call. The
+// search stops as soon as it returns false.
+//=============================================================================
+void AABBTree::withinRadius(const Vector2D& point,
+	const float radius,
+	ISpatialVisitor<EntityData>& visitor) const
+{
+	if (m_root != NO_INDEX)
+	{
+		withinRadius(m_root, point, radius * radius, visitor);
+	}
+}
+
+//=============================================================================
+// Function: void forEachOverlappingPair(ISpatialPairVisitor<EntityData>&) const
+// Description:
+// Visits every pair of overlapping entities once by pairing up the
+// two sides of each branch wherever their boxes meet.
+// Parameters:
+// ISpatialPairVisitor<EntityData>& visitor - The visitor to call.
+// The search stops as soon as it returns false.
+//=============================================================================
+void AABBTree::forEachOverlappingPair(ISpatialPairVisitor<EntityData>& visitor) const
+{
+	if (m_root != NO_INDEX)
+	{
+		findPairs(m_root, visitor);
+	}
+}
+
+//=============================================================================
+// Function: ISpatialIndex<EntityData>* createSnapshot() const
+// Description:
+// Creates a read-only copy of the tree.
+// Output:
+// ISpatialIndex<EntityData>*
+// Returns the snapshot. The caller owns it.
+//=============================================================================
+ISpatialIndex<EntityData>* AABBTree::createSnapshot() const
+{
+	AABBTree *snapshot = new AABBTree(m_margin);
+
+	updateSnapshot(*snapshot);
+
+	return snapshot;
+}
+
+//=============================================================================
+// Function: void updateSnapshot(ISpatialIndex<EntityData>&) const
+// Description:
+// Copies the node pool into a snapshot, leaving out the id lookup
+// since a snapshot is only ever searched.
+// Parameters:
+// ISpatialIndex<EntityData>& snapshot - A snapshot from
+// createSnapshot.
+//=============================================================================
+void AABBTree::updateSnapshot(ISpatialIndex<EntityData>& snapshot) const
+{
+	AABBTree& tree = static_cast<AABBTree&>(snapshot);
+
+	tree.m_nodes = m_nodes;
+	tree.m_leafLookup.clear();
+
+	tree.m_root = m_root;
+	tree.m_freeNode = m_freeNode;
+	tree.m_count = m_count;
+}
+
+//=============================================================================
+// Function: void clear()
+// Description:
+// Removes every entity.
+//=============================================================================
+void AABBTree::clear()
+{
+	m_nodes.clear();
+	m_leafLookup.clear();
+
+	m_root = NO_INDEX;
+	m_freeNode = NO_INDEX;
+	m_count = 0;
+}
+
+//=============================================================================
+// Function: const int createNode()
+// Description:
+// Gets a node from the pool, reusing a released one if possible.
+// Output:
+// const int
+// Returns the index of the node.
+//=============================================================================
+const int AABBTree::createNode()
+{
+	int node = m_freeNode;
+
+	if (node != NO_INDEX)
+	{
+		m_freeNode = m_nodes[node].m_parent;
+
+		m_nodes[node] = TreeNode();
+	}
+	else
+	{
+		node = (int)m_nodes.size();
+
+		m_nodes.emplace_back(TreeNode());
+	}
+
+	return node;
+}
+
+//=============================================================================
+// Function: void releaseNode(const int)
+// Description:
+// Puts a node back on the free list.
+// Parameters:
+// const int node - The node to release.
+//=============================================================================
+void AABBTree::releaseNode(const int node)
+{
+	m_nodes[node].m_parent = m_freeNode;
+	m_nodes[node].m_height = -1;
+
+	m_freeNode = node;
+}
+
+//=============================================================================
+// Function: const bool isLeaf(const int) const
+// Description:
+// Checks if a node holds an entity.
+// Parameters:
+// const int node - The node to check.
+// Output:
+// const bool
+// Returns true if the node is a leaf.
+//=============================================================================
+const bool AABBTree::isLeaf(const int node) const
+{
+	return m_nodes[node].m_left == NO_INDEX;
+}
+
+//=============================================================================
+// Function: void insertLeaf(const int)
+// Description:
+// Links a leaf into the tree. Starting at the root it walks towards
+// whichever side grows the least by taking the leaf, and stops
+// where pairing the leaf with the current node is cheaper than
+// going further down. The cost is the perimeter of the boxes, which
+// keeps boxes small so searches reach fewer of them.
+// Parameters:
+// const int leaf - The leaf to insert. Its box has to be set.
+//=============================================================================
+void AABBTree::insertLeaf(const int leaf)
+{
+	if (m_root == NO_INDEX)
+	{
+		m_root = leaf;
+		m_nodes[leaf].m_parent = NO_INDEX;
+	}
+	else
+	{
+		TreeBox leafBox = m_nodes[leaf].m_box;
+
+		int sibling = m_root;
+
+		bool done = false;
+
+		while (!isLeaf(sibling) && !done)
+		{
+			const TreeNode& node = m_nodes[sibling];
+
+			TreeBox combined = node.m_box;
+			combined.add(leafBox);
+
+			float combinedPerimeter = combined.getPerimeter();
+
+			// Pairing with this node makes one new branch around both.
+			float cost = 2.0f * combinedPerimeter;
+
+			// Going further down grows this node's box either way.
+			float inheritedCost = 2.0f * (combinedPerimeter - node.m_box.getPerimeter());
+
+			float childCosts[2] = { 0.0f, 0.0f };
+			int children[2] = { node.m_left, node.m_right };
+
+			for (int i = 0; i < 2; i++)
+			{
+				const TreeNode& child = m_nodes[children[i]];
+
+				TreeBox childCombined = child.m_box;
+				childCombined.add(leafBox);
+
+				childCosts[i] = childCombined.getPerimeter() + inheritedCost;
+
+				if (!isLeaf(children[i]))
+				{
+					childCosts[i] -= child.m_box.getPerimeter();
+				}
+			}
+
+			if (cost < childCosts[0] && cost < childCosts[1])
+			{
+				done = true;
+			}
+			else if (childCosts[0] < childCosts[1])
+			{
+				sibling = children[0];
+			}
+			else
+			{
+				sibling = children[1];
+			}
+		}
+
+		int oldParent = m_nodes[sibling].m_parent;
+		int newParent = createNode();
+
+		TreeNode& branch = m_nodes[newParent];
+
+		branch.m_parent = oldParent;
+		branch.m_left = sibling;
+		branch.m_right = leaf;
+		branch.m_height = m_nodes[sibling].m_height + 1;
+		branch.m_box = m_nodes[sibling].m_box;
+		branch.m_box.add(leafBox);
+
+		if (oldParent != NO_INDEX)
+		{
+			replaceChild(oldParent, sibling, newParent);
+		}
+		else
+		{
+			m_root = newParent;
+		}
+
+		m_nodes[sibling].m_parent = newParent;
+		m_nodes[leaf].m_parent = newParent;
+
+		refitFrom(oldParent);
+	}
+}
+
+//=============================================================================
+// Function: void removeLeaf(const int)
+// Description:
+// Unlinks a leaf from the tree. Its parent branch goes away and the
+// leaf's sibling takes its place. The leaf itself isn't released.
+// Parameters:
+// const int leaf - The leaf to remove.
+//=============================================================================
+void AABBTree::removeLeaf(const int leaf)
+{
+	if (leaf == m_root)
+	{
+		m_root = NO_INDEX;
+	}
+	else
+	{
+		int parent = m_nodes[leaf].m_parent;
+		int grandParent = m_nodes[parent].m_parent;
+		int sibling = m_nodes[parent].m_left;
+
+		if (sibling == leaf)
+		{
+			sibling = m_nodes[parent].m_right;
+		}
+
+		if (grandParent != NO_INDEX)
+		{
+			replaceChild(grandParent, parent, sibling);
+		}
+		else
+		{
+			m_root = sibling;
+		}
+
+		m_nodes[sibling].m_parent = grandParent;
+
+		releaseNode(parent);
+
+		refitFrom(grandParent);
+	}
+
+	m_nodes[leaf].m_parent = NO_INDEX;
+}
+
+//=============================================================================
+// Function: void refitFrom(const int)
+// Description:
+// Walks from a branch up to the root, balancing each branch and
+// fixing its box and height.
+// Parameters:
+// const int node - The branch to start from. NO_INDEX does nothing.
+//=============================================================================
+void AABBTree::refitFrom(const int node)
+{
+	int current = node;
+
+	while (current != NO_INDEX)
+	{
+		current = balance(current);
+
+		TreeNode& branch = m_nodes[current];
+		const TreeNode& left = m_nodes[branch.m_left];
+		const TreeNode& right = m_nodes[branch.m_right];
+
+		iMax(branch.m_height, left.m_height, right.m_height);
+		branch.m_height++;
+
+		branch.m_box = left.m_box;
+		branch.m_box.add(right.m_box);
+
+		current = branch.m_parent;
+	}
+}
+
+//=============================================================================
+// Function: const int balance(const int)
+// Description:
+// Rotates a branch if one side is more than a level taller than
+// the other. The taller child moves up into the branch's place, and
+// the branch takes the shorter of that child's children.
+// Parameters:
+// const int node - The branch to balance.
+// Output:
+// const int
+// Returns the node now in the branch's place.
+//=============================================================================
+const int AABBTree::balance(const int node)
+{
+	int top = node;
+
+	if (!isLeaf(node) && 2 <= m_nodes[node].m_height)
+	{
+		int left = m_nodes[node].m_left;
+		int right = m_nodes[node].m_right;
+
+		int difference = m_nodes[right].m_height - m_nodes[left].m_height;
+
+		if (1 < difference || difference < -1)
+		{
+			// The child to move up and the child the branch keeps.
+			int raised = right;
+			int kept = left;
+
+			if (difference < -1)
+			{
+				raised = left;
+				kept = right;
+			}
+
+			int tall = m_nodes[raised].m_left;
+			int shorter = m_nodes[raised].m_right;
+
+			if (m_nodes[tall].m_height < m_nodes[shorter].m_height)
+			{
+				tall = m_nodes[raised].m_right;
+				shorter = m_nodes[raised].m_left;
+			}
+
+			int parent = m_nodes[node].m_parent;
+
+			m_nodes[raised].m_parent = parent;
+			m_nodes[node].m_parent = raised;
+
+			if (parent != NO_INDEX)
+			{
+				replaceChild(parent, node, raised);
+			}
+			else
+			{
+				m_root = raised;
+			}
+
+			// The raised child keeps its taller child and takes the
+			// branch, and the branch takes the shorter one.
+			m_nodes[raised].m_left = node;
+			m_nodes[raised].m_right = tall;
+
+			m_nodes[node].m_left = kept;
+			m_nodes[node].m_right = shorter;
+			m_nodes[shorter].m_parent = node;
+
+			TreeNode& branch = m_nodes[node];
+
+			branch.m_box = m_nodes[kept].m_box;
+			branch.m_box.add(m_nodes[shorter].m_box);
+			iMax(branch.m_height, m_nodes[kept].m_height, m_nodes[shorter].m_height);
+			branch.m_height++;
+
+			TreeNode& raisedNode = m_nodes[raised];
+
+			raisedNode.m_box = branch.m_box;
+			raisedNode.m_box.add(m_nodes[tall].m_box);
+			iMax(raisedNode.m_height, branch.m_height, m_nodes[tall].m_height);
+			raisedNode.m_height++;
+
+			top = raised;
+		}
+	}
+
+	return top;
+}
+
+//=============================================================================
+// Function: void replaceChild(const int, const int, const int)
+// Description:
+// Swaps one of a branch's children for another node.
+// Parameters:
+// const int parent - The branch.
+// const int oldChild - The child being replaced.
+// const int newChild - The node taking its place.
+//=============================================================================
+void AABBTree::replaceChild(const int parent,
+	const int oldChild,
+	const int newChild)
+{
+	if (m_nodes[parent].m_left == oldChild)
+	{
+		m_nodes[parent].m_left = newChild;
+	}
+	else
+	{
+		m_nodes[parent].m_right = newChild;
+	}
+}
+
+//=============================================================================
+// Function: const bool search(const int,
+// const TreeBox&,
+// const Rectangle&,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Visits the entities under a node that collide with the area.
+// Parameters:
+// const int node - The node to search.
+// const TreeBox& area - The padded bounding box of the area.
+// const Rectangle& searchArea - The area to search inside.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call.
+// Output:
+// const bool
+// Returns false if the visitor stopped the search.
+//=============================================================================
+const bool AABBTree::search(const int node,
+	const TreeBox& area,
+	const Rectangle& searchArea,
+	ISpatialVisitor<EntityData>& visitor) const
+{
+	const TreeNode& treeNode = m_nodes[node];
+
+	if (treeNode.m_box.overlaps(area))
+	{
+		if (isLeaf(node))
+		{
+			if (rectIntersectRect(searchArea, treeNode.m_data.m_size) &&
+				!visitor.visit(treeNode.m_data))
+			{
+				return false;
+			}
+		}
+		else if (!search(treeNode.m_left, area, searchArea, visitor) ||
+			!search(treeNode.m_right, area, searchArea, visitor))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+// Function: const bool search(const int,
+// const Line&,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Visits the entities under a node that the line touches.
+// Parameters:
+// const int node - The node to search.
+// const Line& searchLine - The line to search along.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call.
+// Output:
+// const bool
+// Returns false if the visitor stopped the search.
+//=============================================================================
+const bool AABBTree::search(const int node,
+	const Line& searchLine,
+	ISpatialVisitor<EntityData>& visitor) const
+{
+	const TreeNode& treeNode = m_nodes[node];
+
+	float time = 0.0f;
+
+	if (segmentEntersBox(treeNode.m_box, searchLine, time))
+	{
+		if (isLeaf(node))
+		{
+			if (lineInRect(treeNode.m_data.m_size, searchLine) &&
+				!visitor.visit(treeNode.m_data))
+			{
+				return false;
+			}
+		}
+		else if (!search(treeNode.m_left, searchLine, visitor) ||
+			!search(treeNode.m_right, searchLine, visitor))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+// Function: void raycast(const int,
+// const float,
+// const Line&,
+// const ISpatialFilter<EntityData>*,
+// RaycastHit&,
+// bool&) const
+// Description:
+// Checks the entity in a leaf, or the children of a branch in the
+// order the ray reaches them. Skipped if the ray only reaches the
+// node after the closest hit so far.
+// Parameters:
+// const int node - The node to check.
+// const float enterTime - When the ray reaches the node's box.
+// const Line& ray - The ray to cast.
+// const ISpatialFilter<EntityData> *filter - The filter, or NULL.
+// RaycastHit& hit - The closest hit so far.
+// bool& found - Whether anything has been hit so far.
+//=============================================================================
+void AABBTree::raycast(const int node,
+	const float enterTime,
+	const Line& ray,
+	const ISpatialFilter<EntityData> *filter,
+	RaycastHit& hit,
+	bool& found) const
+{
+	if (!found || enterTime <= hit.m_time)
+	{
+		const TreeNode& treeNode = m_nodes[node];
+
+		if (isLeaf(node))
+		{
+			checkRayHit(treeNode.m_data, ray, filter, hit, found);
+		}
+		else
+		{
+			int first = treeNode.m_left;
+			int second = treeNode.m_right;
+
+			float firstTime = 0.0f;
+			float secondTime = 0.0f;
+
+			bool firstHit = segmentEntersBox(m_nodes[first].m_box, ray, firstTime);
+			bool secondHit = segmentEntersBox(m_nodes[second].m_box, ray, secondTime);
+
+			if (firstHit && secondHit && secondTime < firstTime)
+			{
+				raycast(second, secondTime, ray, filter, hit, found);
+				raycast(first, firstTime, ray, filter, hit, found);
+			}
+			else
+			{
+				if (firstHit)
+				{
+					raycast(first, firstTime, ray, filter, hit, found);
+				}
+
+				if (secondHit)
+				{
+					raycast(second, secondTime, ray, filter, hit, found);
+				}
+			}
+		}
+	}
+}
+
+//=============================================================================
+// Function: void nearest(const int,
+// const Vector2D&,
+// const int,
+// vector<EntityData>&) const
+// Description:
+// Offers the entity in a leaf to the nearest search, or visits the
+// children of a branch closest first while they could still hold
+// something closer.
+// Parameters:
+// const int node - The node to search.
+// const Vector2D& point - The point to search from.
+// const int count - The most entities to find.
+// vector<EntityData>& nearest - The heap of entities kept so far.
+//=============================================================================
+void AABBTree::nearest(const int node,
+	const Vector2D& point,
+	const int count,
+	std::vector<EntityData>& nearest) const
+{
+	const TreeNode& treeNode = m_nodes[node];
+
+	if (isLeaf(node))
+	{
+		keepNearest(treeNode.m_data, point, count, nearest);
+	}
+	else
+	{
+		int first = treeNode.m_left;
+		int second = treeNode.m_right;
+
+		float firstDistance = getBoxDistance(m_nodes[first].m_box, point);
+		float secondDistance = getBoxDistance(m_nodes[second].m_box, point);
+
+		if (secondDistance < firstDistance)
+		{
+			std::swap(first, second);
+			std::swap(firstDistance, secondDistance);
+		}
+
+		if (canBeNearer(firstDistance, point, count, nearest))
+		{
+			this->nearest(first, point, count, nearest);
+		}
+
+		if (canBeNearer(secondDistance, point, count, nearest))
+		{
+			this->nearest(second, point, count, nearest);
+		}
+	}
+}
+
+//=============================================================================
+// Function: const bool withinRadius(const int,
+// const Vector2D&,
+// const float,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Visits the entities under a node whose centers are within the
+// radius.
+// Parameters:
+// const int node - The node to search.
+// const Vector2D& point - The center of the circle.
+// const float radiusSquared - The radius of the circle, squared.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call.
+// Output:
+// const bool
+// Returns false if the visitor stopped the search.
+//=============================================================================
+const bool AABBTree::withinRadius(const int node,
+	const Vector2D& point,
+	const float radiusSquared,
+	ISpatialVisitor<EntityData>& visitor) const
+{
+	const TreeNode& treeNode = m_nodes[node];
+
+	if (getBoxDistance(treeNode.m_box, point) <= radiusSquared)
+	{
+		if (isLeaf(node))
+		{
+			if (centerDistance(treeNode.m_data, point) <= radiusSquared &&
+				!visitor.visit(treeNode.m_data))
+			{
+				return false;
+			}
+		}
+		else if (!withinRadius(treeNode.m_left, point, radiusSquared, visitor) ||
+			!withinRadius(treeNode.m_right, point, radiusSquared, visitor))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+// Function: const bool findPairs(const int,
+// ISpatialPairVisitor<EntityData>&) const
+// Description:
+// Visits the overlapping pairs under a branch: the pairs inside
+// each side, then the pairs split between the two sides.
+// Parameters:
+// const int node - The node to search.
+// ISpatialPairVisitor<EntityData>& visitor - The visitor to call.
+// Output:
+// const bool
+// Returns false if the visitor stopped the search.
+//=============================================================================
+const bool AABBTree::findPairs(const int node,
+	ISpatialPairVisitor<EntityData>& visitor) const
+{
+	bool keepGoing = true;
+
+	if (!isLeaf(node))
+	{
+		const TreeNode& treeNode = m_nodes[node];
+
+		keepGoing = findPairs(treeNode.m_left, visitor) &&
+			findPairs(treeNode.m_right, visitor) &&
+			findCrossPairs(treeNode.m_left, treeNode.m_right, visitor);
+	}
+
+	return keepGoing;
+}
+
+//=============================================================================
+// Function: const bool findCrossPairs(const int,
+// const int,
+// ISpatialPairVisitor<EntityData>&) const
+// Description:
+// Visits the overlapping pairs with one entity under each node.
+// The larger branch is split until both sides are leafs, and any
+// two nodes whose boxes don't meet are skipped.
+// Parameters:
+// const int first - The first node.
+// const int second - The second node.
+// ISpatialPairVisitor<EntityData>& visitor - The visitor to call.
+// Output:
+// const bool
+// Returns false if the visitor stopped the search.
+//=============================================================================
+const bool AABBTree::findCrossPairs(const int first,
+	const int second,
+	ISpatialPairVisitor<EntityData>& visitor) const
+{
+	bool keepGoing = true;
+
+	const TreeNode& firstNode = m_nodes[first];
+	const TreeNode& secondNode = m_nodes[second];
+
+	if (firstNode.m_box.overlaps(secondNode.m_box))
+	{
+		bool firstLeaf = isLeaf(first);
+		bool secondLeaf = isLeaf(second);
+
+		if (firstLeaf && secondLeaf)
+		{
+			keepGoing = !pairOverlaps(firstNode.m_data, secondNode.m_data) ||
+				visitor.visit(firstNode.m_data, secondNode.m_data);
+		}
+		else if (secondLeaf ||
+			(!firstLeaf && secondNode.m_box.getPerimeter() < firstNode.m_box.getPerimeter()))
+		{
+			keepGoing = findCrossPairs(firstNode.m_left, second, visitor) &&
+				findCrossPairs(firstNode.m_right, second, visitor);
+		}
+		else
+		{
+			keepGoing = findCrossPairs(first, secondNode.m_left, visitor) &&
+				findCrossPairs(first, secondNode.m_right, visitor);
+		}
+	}
+
+	return keepGoing;
+}
+
+//=============================================================================
+// Function: const TreeBox getBounds(const Rectangle&)
+// Description:
+// Gets the bounding box of a rectangle, padded by a pixel to cover
+// corner rounding.
+// Parameters:
+// const Rectangle& size - The rectangle to bound.
+// Output:
+// const TreeBox
+// Returns the padded box.
+//=============================================================================
+const AABBTree::TreeBox AABBTree::getBounds(const Rectangle& size)
+{
+	return TreeBox(size.getMinX() - 1.0f,
+		size.getMinY() - 1.0f,
+		size.getMaxX() + 1.0f,
+		size.getMaxY() + 1.0f);
+}
+
+//=============================================================================
+// Function: const float getBoxDistance(const TreeBox&, const Vector2D&)
+// Description:
+// Gets the squared distance from a point to the closest point in a
+// box.
+// Parameters:
+// const TreeBox& box - The box to measure to.
+// const Vector2D& point - The point to measure from.
+// Output:
+// const float
+// Returns the squared distance, 0 if the point is inside.
+//=============================================================================
+const float AABBTree::getBoxDistance(const TreeBox& box,
+	const Vector2D& point)
+{
+	float x = 0.0f;
+	float y = 0.0f;
+
+	fMax(x, box.m_minX - point.m_x, point.m_x - box.m_maxX);
+	fMax(y, box.m_minY - point.m_y, point.m_y - box.m_maxY);
+	fMax(x, x, 0.0f);
+	fMax(y, y, 0.0f);
+
+	return (x * x) + (y * y);
+}
+
+//=============================================================================
+// Function: const bool segmentEntersBox(const TreeBox&,
+// const Line&,
+// float&)
+// Description:
+// Checks if a line segment touches a box using the slab test.
+// Parameters:
+// const TreeBox& box - The box to check.
+// const Line& line - The segment, from its start to its end.
+// float& time - Set to how far along the segment it enters the box,
+// 0 if it starts inside.
+// Output:
+// const bool
+// Returns true if the segment touches the box.
+//=============================================================================
+const bool AABBTree::segmentEntersBox(const TreeBox& box,
+	const Line& line,
+	float& time)
+{
+	float origin[2] = { line.m_start.m_x, line.m_start.m_y };
+	float direction[2] = { line.m_end.m_x - line.m_start.m_x, line.m_end.m_y - line.m_start.m_y };
+	float minimum[2] = { box.m_minX, box.m_minY };
+	float maximum[2] = { box.m_maxX, box.m_maxY };
+
+	float enter = 0.0f;
+	float exit = 1.0f;
+	bool miss = false;
+
+	for (int axis = 0; axis < 2 && !miss; axis++)
+	{
+		if (direction[axis] == 0.0f)
+		{
+			miss = origin[axis] < minimum[axis] || maximum[axis] < origin[axis];
+		}
+		else
+		{
+			float entry = (minimum[axis] - origin[axis]) / direction[axis];
+			float leave = (maximum[axis] - origin[axis]) / direction[axis];
+
+			if (leave < entry)
+			{
+				std::swap(entry, leave);
+			}
+
+			fMax(enter, enter, entry);
+			fMin(exit, exit, leave);
+
+			miss = exit < enter;
+		}
+	}
+
+	time = enter;
+
+	return !miss;
+}
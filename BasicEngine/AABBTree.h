@@ -0,0 +1,211 @@
+#pragma once
+//==========================================================================================
+// File Name: AABBTree.h
+// Author: Brian Blackmon
+// Date Created: 11/11/2019
+// Purpose:
+// A dynamic bounding volume tree. Every entity is a leaf holding a
+// box grown by a margin around it, and every branch holds the box
+// around its two children. Nothing depends on fixed space, so
+// clustered entities just make a deeper part of the tree, and
+// rotations on the way back up from an insert or remove keep it
+// balanced. An entity that moves inside its grown box only has its
+// size updated, so small jitter never touches the tree.
+// Nodes live in a single pool and refer to each other by index.
+//==========================================================================================
+#include "ISpatialIndex.h"
+#include "BBMath.h"
+#include <vector>
+#include <unordered_map>
+#include <cfloat>
+
+class AABBTree : public ISpatialIndex<EntityData>
+{
+public:
+	// How far a leaf's box is grown past its entity on every side.
+	static constexpr float FAT_MARGIN = 8.0f;
+
+	AABBTree(const float margin = FAT_MARGIN);
+	virtual ~AABBTree();
+
+	const int getHeight() const;
+	const int getCount() const;
+
+	using ISpatialIndex<EntityData>::search;
+	using ISpatialIndex<EntityData>::withinRadius;
+
+	virtual void search(const Rectangle& searchArea,
+		ISpatialVisitor<EntityData>& visitor) const;
+	virtual void search(const Line& searchLine,
+		ISpatialVisitor<EntityData>& visitor) const;
+
+	virtual void addEntity(const EntityData& entity);
+	virtual void removeEntity(const EntityData& entity);
+	virtual void moveEntity(const EntityData& entity,
+		const Rectangle& size);
+
+	virtual bool raycast(const Line& ray,
+		RaycastHit& hit,
+		const ISpatialFilter<EntityData> *filter = NULL) const;
+
+	virtual void nearest(const Vector2D& point,
+		const int count,
+		std::vector<EntityData>& nearest) const;
+	virtual void withinRadius(const Vector2D& point,
+		const float radius,
+		ISpatialVisitor<EntityData>& visitor) const;
+
+	virtual void forEachOverlappingPair(ISpatialPairVisitor<EntityData>& visitor) const;
+
+	virtual ISpatialIndex<EntityData>* createSnapshot() const;
+	virtual void updateSnapshot(ISpatialIndex<EntityData>& snapshot) const;
+
+	virtual void clear();
+
+private:
+	static const int NO_INDEX = -1;
+
+	struct TreeBox
+	{
+		TreeBox()
+			:m_minX(FLT_MAX),
+			m_minY(FLT_MAX),
+			m_maxX(-FLT_MAX),
+			m_maxY(-FLT_MAX)
+		{
+
+		}
+
+		TreeBox(const float minX,
+			const float minY,
+			const float maxX,
+			const float maxY)
+			:m_minX(minX),
+			m_minY(minY),
+			m_maxX(maxX),
+			m_maxY(maxY)
+		{
+
+		}
+
+		void add(const TreeBox& box)
+		{
+			fMin(m_minX, m_minX, box.m_minX);
+			fMin(m_minY, m_minY, box.m_minY);
+			fMax(m_maxX, m_maxX, box.m_maxX);
+			fMax(m_maxY, m_maxY, box.m_maxY);
+		}
+
+		const bool contains(const TreeBox& box) const
+		{
+			return m_minX <= box.m_minX &&
+				box.m_maxX <= m_maxX &&
+				m_minY <= box.m_minY &&
+				box.m_maxY <= m_maxY;
+		}
+
+		const bool overlaps(const TreeBox& box) const
+		{
+			return m_minX <= box.m_maxX &&
+				box.m_minX <= m_maxX &&
+				m_minY <= box.m_maxY &&
+				box.m_minY <= m_maxY;
+		}
+
+		const float getPerimeter() const
+		{
+			return 2.0f * ((m_maxX - m_minX) + (m_maxY - m_minY));
+		}
+
+		float m_minX;
+		float m_minY;
+		float m_maxX;
+		float m_maxY;
+	};
+
+	struct TreeNode
+	{
+		TreeNode()
+			:m_data(NO_INDEX, Rectangle()),
+			m_parent(NO_INDEX),
+			m_left(NO_INDEX),
+			m_right(NO_INDEX),
+			m_height(0)
+		{
+
+		}
+
+		TreeBox m_box;
+
+		// Only set on leafs.
+		EntityData m_data;
+
+		// m_parent also links to the next free node once the node is
+		// released.
+		int m_parent;
+		int m_left;
+		int m_right;
+
+		// Leafs are 0 and released nodes are -1.
+		int m_height;
+	};
+
+	std::vector<TreeNode> m_nodes;
+	std::unordered_map<int, int> m_leafLookup;
+
+	int m_root;
+	int m_freeNode;
+	int m_count;
+
+	float m_margin;
+
+	const int createNode();
+	void releaseNode(const int node);
+
+	const bool isLeaf(const int node) const;
+
+	void insertLeaf(const int leaf);
+	void removeLeaf(const int leaf);
+	void refitFrom(const int node);
+	const int balance(const int node);
+	void replaceChild(const int parent,
+		const int oldChild,
+		const int newChild);
+
+	const bool search(const int node,
+		const TreeBox& area,
+		const Rectangle& searchArea,
+		ISpatialVisitor<EntityData>& visitor) const;
+	const bool search(const int node,
+		const Line& searchLine,
+		ISpatialVisitor<EntityData>& visitor) const;
+
+	void raycast(const int node,
+		const float enterTime,
+		const Line& ray,
+		const ISpatialFilter<EntityData> *filter,
+		RaycastHit& hit,
+		bool& found) const;
+
+	void nearest(const int node,
+		const Vector2D& point,
+		const int count,
+		std::vector<EntityData>& nearest) const;
+	const bool withinRadius(const int node,
+		const Vector2D& point,
+		const float radiusSquared,
+		ISpatialVisitor<EntityData>& visitor) const;
+
+	const bool findPairs(const int node,
+		ISpatialPairVisitor<EntityData>& visitor) const;
+	const bool findCrossPairs(const int first,
+		const int second,
+		ISpatialPairVisitor<EntityData>& visitor) const;
+
+	static const TreeBox getBounds(const Rectangle& size);
+	static const float getBoxDistance(const TreeBox& box,
+		const Vector2D& point);
+	static const bool segmentEntersBox(const TreeBox& box,
+		const Line& line,
+		float& time);
+};
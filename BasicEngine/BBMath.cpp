@@ -165,3 +165,36 @@ void iMin(int& value, const int a, const int b)
 		value = b;
 	}
 }
+
+//=============================================================================
+// Function: unsigned int mortonCode(const unsigned short,
+// const unsigned short)
+// Description:
+// Interleaves the bits of two coordinates into a Z-order code.
+// Points that are close to each other end up with codes that are
+// close to each other, so sorting by the code groups them by area.
+// Parameters:
+// const unsigned short x - The x coordinate.
+// const unsigned short y - The y coordinate.
+// Output:
+// unsigned int
+// Returns the code with x in the even bits and y in the odd bits.
+//=============================================================================
+unsigned int mortonCode(const unsigned short x, const unsigned short y)
+{
+	unsigned int spreadX = x;
+	unsigned int spreadY = y;
+
+	// Spread the 16 bits out so there's a zero between each of them.
+	spreadX = (spreadX | (spreadX << 8)) & 0x00FF00FF;
+	spreadX = (spreadX | (spreadX << 4)) & 0x0F0F0F0F;
+	spreadX = (spreadX | (spreadX << 2)) & 0x33333333;
+	spreadX = (spreadX | (spreadX << 1)) & 0x55555555;
+
+	spreadY = (spreadY | (spreadY << 8)) & 0x00FF00FF;
+	spreadY = (spreadY | (spreadY << 4)) & 0x0F0F0F0F;
+	spreadY = (spreadY | (spreadY << 2)) & 0x33333333;
+	spreadY = (spreadY | (spreadY << 1)) & 0x55555555;
+
+	return spreadX | (spreadY << 1);
+}
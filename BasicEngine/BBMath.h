@@ -17,4 +17,6 @@ void fMax(float& value, const float a, const float b);
 void iMax(int& value, const int a, const int b);
 
 void fMin(float& value, const float a, const float b);
-void iMin(int& value, const int a, const int b);
\ No newline at end of file
+void iMin(int& value, const int a, const int b);
+
+unsigned int mortonCode(const unsigned short x, const unsigned short y);
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "Rotation.h"
 #include "BBMath.h"
 #include <vector>
+#include <cmath>
+#include <cfloat>
 
 //=============================================================================
 // Function: bool pointInRect(const Rectangle&, const Vector2D&)
@@ -23,7 +25,7 @@ bool pointInRect(const Rectangle& rect,
 {
 	bool inside = false;
 
-	Vector2D rotatedPoint = rotatePoint(rect.getCenter(), point, -rect.getRotation());
+	Vector2D rotatedPoint = rotatePoint(rect.getCenter(), point, rect.getRotationVector().inverse());
 
 	float leftX = rect.getCenter().m_x - ((float)rect.getWidth() / 2.0f);
 	float rightX = rect.getCenter().m_x + ((float)rect.getWidth() / 2.0f);
@@ -56,27 +58,11 @@ bool pointInRect(const Rectangle& rect,
 bool lineInRect(const Rectangle& rect,
 	const Line& line)
 {
-	bool inside = false;
-
-	Line top(rect.getTopLeft(), rect.getTopRight());
-	Line bottom(rect.getBottomLeft(), rect.getBottomRight());
-	Line right(rect.getTopRight(), rect.getBottomRight());
-	Line left(rect.getTopLeft(), rect.getBottomLeft());
-
-	if (pointInRect(rect, line.m_start) &&
-		pointInRect(rect, line.m_end))
-	{
-		inside = true;
-	}
-	else if (linesIntersect(line, top) ||
-		linesIntersect(line, bottom) ||
-		linesIntersect(line, right) ||
-		linesIntersect(line, left))
-	{
-		inside = true;
-	}
+	float enter = 0.0f;
+	float exit = 0.0f;
+	Vector2D normal;
 
-	return inside;
+	return segmentIntersectRect(rect, line, enter, exit, normal);
 }
 
 //=============================================================================
@@ -109,7 +95,8 @@ bool rectInsideRect(const Rectangle& a, const Rectangle& b)
 //=============================================================================
 // Function: bool rectIntersectRect(const Rectangle&, const Rectangle&)
 // Description:
-// Checks to see if two rectangles are colliding or not.
+// Checks to see if two rectangles are colliding or not. Rotated
+// rectangles go through the separating axis test.
 // Parameters:
 // const Rectangle& a - The first rect to check.
 // const Rectangle& b - The second rect to check.
@@ -142,100 +129,449 @@ bool rectIntersectRect(const Rectangle& a,
 	}
 	else
 	{
-		inside = false;
+		Vector2D translation;
+
+		inside = rectIntersectRect(a, b, translation);
+	}
+
+	return inside;
+}
+
+//=============================================================================
+// Function: void projectCorners(const Vector2D*,
+// const Vector2D&,
+// float&,
+// float&)
+// Description:
+// Projects a rectangle's corners onto an axis.
+// Parameters:
+// const Vector2D *corners - The four corners.
+// const Vector2D& axis - The axis to project onto.
+// float& min - Set to the lowest projection.
+// float& max - Set to the highest projection.
+//=============================================================================
+static void projectCorners(const Vector2D *corners,
+	const Vector2D& axis,
+	float& min,
+	float& max)
+{
+	min = (corners[0].m_x * axis.m_x) + (corners[0].m_y * axis.m_y);
+	max = min;
+
+	for (int i = 1; i < 4; i++)
+	{
+		float projection = (corners[i].m_x * axis.m_x) + (corners[i].m_y * axis.m_y);
+
+		fMin(min, min, projection);
+		fMax(max, max, projection);
+	}
+}
+
+//=============================================================================
+// Function: void getCorners(const Rectangle&, Vector2D*)
+// Description:
+// Gets a rectangle's corners, starting at the top left and going
+// around through the top right.
+// Parameters:
+// const Rectangle& rect - The rect to get the corners of.
+// Vector2D *corners - Set to the four corners.
+//=============================================================================
+static void getCorners(const Rectangle& rect,
+	Vector2D *corners)
+{
+	corners[0] = rect.getTopLeft();
+	corners[1] = rect.getTopRight();
+	corners[2] = rect.getBottomRight();
+	corners[3] = rect.getBottomLeft();
+}
+
+//=============================================================================
+// Function: bool findSeparation(const Vector2D*,
+// const Vector2D*,
+// Vector2D&,
+// float&,
+// float&,
+// int&)
+// Description:
+// Runs the separating axis test on two sets of corners. Both sets
+// are projected onto the normal of every side, and if any of them
+// has a gap between the projections, they don't collide. Otherwise
+// the side a can be pushed out past the soonest gives the shortest
+// way to pull them apart.
+// The corners of a rotated rectangle are rounded, so its sides
+// aren't always exactly parallel and every side is checked. The
+// normals aren't normalized. The overlaps are compared squared and
+// divided by the normal's squared length instead, so there's no sqrt.
+// Parameters:
+// const Vector2D *aCorners - The first rect's corners.
+// const Vector2D *bCorners - The second rect's corners.
+// Vector2D& axis - Set to the normal a has to move along to get out
+// of b. It isn't normalized.
+// float& overlap - Set to how far a has to move, measured along the
+// unnormalized axis.
+// float& length - Set to the axis's squared length.
+// int& side - Set to the side the axis is the normal of. 0 to 3 are
+// a's sides and 4 to 7 are b's, in corner order. -1 if both rects
+// are points.
+// Output:
+// bool
+// Returns true if the corners collide, including only touching.
+//=============================================================================
+static bool findSeparation(const Vector2D *aCorners,
+	const Vector2D *bCorners,
+	Vector2D& axis,
+	float& overlap,
+	float& length,
+	int& side)
+{
+	const int CORNER_COUNT = 4;
+
+	const Vector2D *corners[2] = { aCorners, bCorners };
 
-		// Find the closest corners
-		const int CORNER_COUNT = 4;
+	bool inside = true;
+	bool tested = false;
+
+	// The smallest overlap so far, as overlap^2 / |normal|^2.
+	float smallestDepth = FLT_MAX;
 
-		Vector2D aCorners[CORNER_COUNT]{ a.getTopLeft(),
-		a.getTopRight(),
-		a.getBottomRight(),
-		a.getBottomLeft() };
+	axis = Vector2D(1.0f, 0.0f);
+	overlap = 0.0f;
+	length = 1.0f;
+	side = -1;
 
-		Vector2D bCorners[CORNER_COUNT]{ b.getTopLeft(),
-		b.getTopRight(),
-		b.getBottomRight(),
-		b.getBottomLeft() };
+	for (int current = 0; current < (2 * CORNER_COUNT) && inside; current++)
+	{
+		const Vector2D *rectCorners = corners[current / CORNER_COUNT];
 
-		int aClosestIndex = 0;
-		int bClosestIndex = 0;
+		int start = current % CORNER_COUNT;
+		int end = (start + 1) % CORNER_COUNT;
 
-		float aDistance = 
-			totalDistance(aCorners[aClosestIndex], b.getCenter());
-		float bDistance =
-			totalDistance(bCorners[aClosestIndex], a.getCenter());
+		Vector2D normal(rectCorners[start].m_y - rectCorners[end].m_y,
+			rectCorners[end].m_x - rectCorners[start].m_x);
 
-		for (int i = 0; i < CORNER_COUNT; i++)
+		float normalLength = (normal.m_x * normal.m_x) + (normal.m_y * normal.m_y);
+
+		// Rectangles with no width or height have sides with no length.
+		if (0.0f < normalLength)
 		{
-			if (totalDistance(aCorners[i], b.getCenter()) < aDistance)
+			float aMin = 0.0f;
+			float aMax = 0.0f;
+			float bMin = 0.0f;
+			float bMax = 0.0f;
+
+			projectCorners(aCorners, normal, aMin, aMax);
+			projectCorners(bCorners, normal, bMin, bMax);
+
+			tested = true;
+
+			if (aMax < bMin || bMax < aMin)
 			{
-				aDistance = totalDistance(aCorners[i], b.getCenter());
-				aClosestIndex = i;
+				inside = false;
 			}
-
-			if (totalDistance(bCorners[i], a.getCenter()) < bDistance)
+			else
 			{
-				bDistance = totalDistance(bCorners[i], a.getCenter());
-				bClosestIndex = i;
+				// a can leave either way along the normal, so take the
+				// shorter one. Moving back is the same as using the
+				// flipped normal.
+				float push = bMax - aMin;
+
+				if (aMax - bMin < push)
+				{
+					push = aMax - bMin;
+					normal = Vector2D(-normal.m_x, -normal.m_y);
+				}
+
+				float depth = (push * push) / normalLength;
+
+				if (depth < smallestDepth)
+				{
+					smallestDepth = depth;
+					overlap = push;
+					length = normalLength;
+					axis = normal;
+					side = current;
+				}
 			}
 		}
-		
-		int aNextIndex = aClosestIndex + 1;
-		int aPrevIndex = aClosestIndex - 1;
+	}
 
-		int bNextIndex = bClosestIndex + 1;
-		int bPrevIndex = bClosestIndex - 1;
+	if (!tested)
+	{
+		// Both are points, so they only collide if they're the same one.
+		inside = aCorners[0] == bCorners[0];
+	}
 
-		if (aPrevIndex < 0)
-		{
-			aPrevIndex = CORNER_COUNT - 1;
-		}
+	return inside;
+}
 
-		if (CORNER_COUNT <= aNextIndex)
-		{
-			aNextIndex = 0;
-		}
+//=============================================================================
+// Function: bool rectIntersectRect(const Rectangle&,
+// const Rectangle&,
+// Vector2D&)
+// Description:
+// Checks two rectangles with the separating axis test, and finds the
+// shortest way to pull them apart if they collide. Rectangles that
+// only touch collide, with no translation.
+// Parameters:
+// const Rectangle& a - The first rect to check.
+// const Rectangle& b - The second rect to check.
+// Vector2D& translation - Set to the smallest move that takes a out
+// of b if they collide.
+// Output:
+// bool
+// Returns true if the rectangles collide.
+// Returns false if the rectangles don't collide.
+//=============================================================================
+bool rectIntersectRect(const Rectangle& a,
+	const Rectangle& b,
+	Vector2D& translation)
+{
+	Vector2D aCorners[4];
+	Vector2D bCorners[4];
+
+	getCorners(a, aCorners);
+	getCorners(b, bCorners);
+
+	Vector2D axis;
+	float overlap = 0.0f;
+	float length = 1.0f;
+	int side = 0;
 
-		if (bPrevIndex < 0)
+	bool inside = findSeparation(aCorners, bCorners, axis, overlap, length, side);
+
+	if (inside)
+	{
+		float scale = overlap / length;
+
+		translation = Vector2D(axis.m_x * scale, axis.m_y * scale);
+	}
+
+	return inside;
+}
+
+//=============================================================================
+// Function: const Vector2D getTranslation() const
+// Description:
+// Gets the move that takes the first rect out of the second.
+// Output:
+// const Vector2D
+// Returns the normal scaled by the depth.
+//=============================================================================
+const Vector2D CollisionManifold::getTranslation() const
+{
+	return Vector2D(m_normal.m_x * m_depth, m_normal.m_y * m_depth);
+}
+
+//=============================================================================
+// Function: int clipPolygon(const Vector2D*,
+// const int,
+// const Vector2D&,
+// const float,
+// Vector2D*)
+// Description:
+// Cuts off the part of a convex polygon that's past a line. A corner
+// is kept if its projection onto the normal is at most the offset,
+// and wherever a side crosses the line, the crossing point is added.
+// Parameters:
+// const Vector2D *points - The polygon's corners, in order.
+// const int count - How many corners there are.
+// const Vector2D& normal - The normal of the line, pointing out of the
+// part to keep.
+// const float offset - The line's projection onto the normal.
+// Vector2D *clipped - Set to the corners that are left. Needs room for
+// one more than count.
+// Output:
+// int
+// Returns how many corners are left.
+//=============================================================================
+static int clipPolygon(const Vector2D *points,
+	const int count,
+	const Vector2D& normal,
+	const float offset,
+	Vector2D *clipped)
+{
+	int kept = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		const Vector2D& current = points[i];
+		const Vector2D& next = points[(i + 1) % count];
+
+		float currentDistance = (current.m_x * normal.m_x) + (current.m_y * normal.m_y) - offset;
+		float nextDistance = (next.m_x * normal.m_x) + (next.m_y * normal.m_y) - offset;
+
+		if (currentDistance <= 0.0f)
 		{
-			bPrevIndex = CORNER_COUNT - 1;
+			clipped[kept++] = current;
 		}
-		
-		if (CORNER_COUNT <= bNextIndex)
+
+		if ((currentDistance < 0.0f && 0.0f < nextDistance) ||
+			(nextDistance < 0.0f && 0.0f < currentDistance))
 		{
-			bNextIndex = 0;
+			float time = currentDistance / (currentDistance - nextDistance);
+
+			clipped[kept++] = Vector2D(current.m_x + ((next.m_x - current.m_x) * time),
+				current.m_y + ((next.m_y - current.m_y) * time));
 		}
+	}
 
-		Line aPrev(aCorners[aClosestIndex], aCorners[aPrevIndex]);
-		Line aNext(aCorners[aClosestIndex], aCorners[aNextIndex]);
-		
-		Line bPrev(bCorners[bClosestIndex], bCorners[bPrevIndex]);
-		Line bNext(bCorners[bClosestIndex], bCorners[bNextIndex]);
+	return kept;
+}
+
+//=============================================================================
+// Function: bool getManifold(const Rectangle&,
+// const Rectangle&,
+// CollisionManifold&)
+// Description:
+// Works out everything about how two rectangles collide in one go,
+// so the response and anything else that cares can share it.
+// The separating axis test gives the normal and depth. For the
+// contact points, a's corners are clipped against each of b's sides,
+// which leaves the area they share. Its two ends across the normal
+// are the contacts, taking the one deepest into b where there's a
+// tie, so they're always inside both rects.
+// Parameters:
+// const Rectangle& a - The first rect, the one the normal moves.
+// const Rectangle& b - The second rect.
+// CollisionManifold& manifold - Set to how they collide.
+// Output:
+// bool
+// Returns true if the rectangles collide, including only touching.
+//=============================================================================
+bool getManifold(const Rectangle& a,
+	const Rectangle& b,
+	CollisionManifold& manifold)
+{
+	// Each side cut can add a corner, so four sides at most double it.
+	const int MAX_CORNERS = 8;
 
-		if (pointInRect(b, aCorners[aClosestIndex]) ||
-			pointInRect(a, bCorners[bClosestIndex]))
+	manifold = CollisionManifold();
+
+	Vector2D aCorners[4];
+	Vector2D bCorners[4];
+
+	getCorners(a, aCorners);
+	getCorners(b, bCorners);
+
+	Vector2D axis;
+	float overlap = 0.0f;
+	float length = 1.0f;
+	int side = 0;
+
+	if (findSeparation(aCorners, bCorners, axis, overlap, length, side))
+	{
+		manifold.m_colliding = true;
+
+		if (side < 0)
 		{
-			inside = true;
+			// Two points in the same spot.
+			manifold.m_contacts[0] = aCorners[0];
+			manifold.m_contactCount = 1;
 		}
-		else 
+		else
 		{
-			if (linesIntersect(aPrev, bPrev) ||
-				linesIntersect(aNext, bPrev) ||
-				linesIntersect(aPrev, bNext) ||
-				linesIntersect(aNext, bNext))
+			float axisLength = sqrt(length);
+
+			manifold.m_normal = Vector2D(axis.m_x / axisLength, axis.m_y / axisLength);
+			manifold.m_depth = overlap / axisLength;
+
+			Vector2D shared[MAX_CORNERS];
+			Vector2D clipped[MAX_CORNERS];
+
+			int count = 4;
+
+			for (int i = 0; i < 4; i++)
+			{
+				shared[i] = aCorners[i];
+			}
+
+			for (int i = 0; i < 4 && 0 < count; i++)
+			{
+				Vector2D edge = bCorners[(i + 1) % 4] - bCorners[i];
+				Vector2D outward(edge.m_y, -edge.m_x);
+
+				count = clipPolygon(shared, count, outward,
+					(outward.m_x * bCorners[i].m_x) + (outward.m_y * bCorners[i].m_y),
+					clipped);
+
+				for (int j = 0; j < count; j++)
+				{
+					shared[j] = clipped[j];
+				}
+			}
+
+			if (0 < count)
 			{
-				inside = true;
+				Vector2D tangent(-manifold.m_normal.m_y, manifold.m_normal.m_x);
+
+				int first = 0;
+				int last = 0;
+
+				float firstAlong = FLT_MAX;
+				float firstDepth = FLT_MAX;
+				float lastAlong = -FLT_MAX;
+				float lastDepth = FLT_MAX;
+
+				for (int i = 0; i < count; i++)
+				{
+					float along = (shared[i].m_x * tangent.m_x) + (shared[i].m_y * tangent.m_y);
+					float depth = (shared[i].m_x * manifold.m_normal.m_x) + (shared[i].m_y * manifold.m_normal.m_y);
+
+					if (along < firstAlong || (along == firstAlong && depth < firstDepth))
+					{
+						first = i;
+						firstAlong = along;
+						firstDepth = depth;
+					}
+
+					if (lastAlong < along || (along == lastAlong && depth < lastDepth))
+					{
+						last = i;
+						lastAlong = along;
+						lastDepth = depth;
+					}
+				}
+
+				manifold.m_contacts[manifold.m_contactCount++] = shared[first];
+
+				if (!(shared[first] == shared[last]))
+				{
+					manifold.m_contacts[manifold.m_contactCount++] = shared[last];
+				}
+			}
+			else
+			{
+				// Rounding can leave nothing when they only just touch, so
+				// fall back to a's corner furthest into b.
+				int deepest = 0;
+				float deepestDepth = FLT_MAX;
+
+				for (int i = 0; i < 4; i++)
+				{
+					float depth = (aCorners[i].m_x * manifold.m_normal.m_x) + (aCorners[i].m_y * manifold.m_normal.m_y);
+
+					if (depth < deepestDepth)
+					{
+						deepest = i;
+						deepestDepth = depth;
+					}
+				}
+
+				manifold.m_contacts[0] = aCorners[deepest];
+				manifold.m_contactCount = 1;
 			}
 		}
 	}
 
-	return inside;
+	return manifold.m_colliding;
 }
 
 //=============================================================================
 // Function: Vector2D intersectPoint(const Rectangle&, const Line&)
 // Description:
-// Gets the intersection point between a rect and a line.
+// Gets the intersection point between a rect and a line. That's
+// where the line enters the rect, or where it leaves if it starts
+// inside. A line that's entirely inside gives its start.
 // Parameters:
 // const Rectangle& rect - The rect to check.
 // const Line& line - The line to check.
@@ -246,54 +582,23 @@ bool rectIntersectRect(const Rectangle& a,
 //=============================================================================
 Vector2D intersectPoint(const Rectangle& rect, const Line& line)
 {
-	if (lineInRect(rect, line))
-	{
-		Vector2D closestPoint(0.0f, 0.0f);
-
-		Line top(rect.getTopLeft(), rect.getTopRight());
-		Line bottom(rect.getBottomLeft(), rect.getBottomRight());
-		Line right(rect.getTopRight(), rect.getBottomRight());
-		Line left(rect.getTopLeft(), rect.getBottomLeft());
+	float enter = 0.0f;
+	float exit = 0.0f;
+	Vector2D normal;
 
-		if (linesIntersect(line, top))
-		{
-			closestPoint = intersectPoint(line, top);
-		}
+	if (segmentIntersectRect(rect, line, enter, exit, normal))
+	{
+		float time = enter;
 
-		if (linesIntersect(line, bottom))
+		if (time == 0.0f && exit < 1.0f)
 		{
-			Vector2D otherPoint = intersectPoint(line, bottom);
-
-			if (totalDistance(line.m_start, otherPoint) <
-				totalDistance(line.m_start, closestPoint))
-			{
-				closestPoint = otherPoint;
-			}
+			time = exit;
 		}
 
-		if (linesIntersect(line, left))
-		{
-			Vector2D otherPoint = intersectPoint(line, left);
-
-			if (totalDistance(line.m_start, otherPoint) <
-				totalDistance(line.m_start, closestPoint))
-			{
-				closestPoint = otherPoint;
-			}
-		}
+		Vector2D delta = line.m_end - line.m_start;
 
-		if (linesIntersect(line, right))
-		{
-			Vector2D otherPoint = intersectPoint(line, right);
-
-			if (totalDistance(line.m_start, otherPoint) <
-				totalDistance(line.m_start, closestPoint))
-			{
-				closestPoint = otherPoint;
-			}
-		}
-
-		return closestPoint;
+		return Vector2D(line.m_start.m_x + (delta.m_x * time),
+			line.m_start.m_y + (delta.m_y * time));
 	}
 
 	return Vector2D(-1.0f, -1.0f);
@@ -392,184 +697,351 @@ Vector2D intersectPoint(const Rectangle& a,
 // Function: Vector2D overlapAmount(const Rectangle& a,
 // const Rectangle& b)
 // Description:
-// Gets the amount of overlap between two rectangles.
+// Gets the smallest move that takes a out of b, from the separating
+// axis test.
 // Parameters:
 // const Rectangle& a - The first rectangle to check.
 // const Rectangle& b - The second rectangle to check.
 // Output:
 // Vector2D
-// Returns a vector with the amount of x overlap and y overlap.
-// If no overlap, returns a negative vector.
+// Returns the move to make with a.
+// If no overlap, or they only touch, returns a zero vector.
 //=============================================================================
 Vector2D overlapAmount(const Rectangle& a,
 	const Rectangle& b)
 {
-	float xOverlap = -1.0f;
-	float yOverlap = -1.0f;
+	Vector2D translation(0.0f, 0.0f);
 
-	if (rectIntersectRect(a, b))
-	{
-		Line aTop(a.getTopLeft(), a.getTopRight());
-		Line aRight(a.getTopRight(), a.getBottomRight());
-		Line aBottom(a.getBottomLeft(), a.getBottomRight());
-		Line aLeft(a.getTopLeft(), a.getBottomLeft());
+	rectIntersectRect(a, b, translation);
 
-		Vector2D aCenter = a.getCenter();
-		Vector2D bCenter = b.getCenter();
+	return translation;
+}
 
-		Line closestLine = aTop;
-		float closestDistance = distanceFromPoint(closestLine, bCenter);
+//=============================================================================
+// Function: bool clipToSlabs(const float*,
+// const float*,
+// const float*,
+// const float*,
+// float&,
+// float&,
+// int&,
+// float&)
+// Description:
+// Clips a moving point against a box, one axis at a time. Each axis
+// narrows the times the point is between the box's two sides on it,
+// and it misses once nothing is left.
+// Parameters:
+// const float *origin - Where the point starts, x then y.
+// const float *direction - How far it moves by time 1.
+// const float *boxMin - The box's smallest x and y.
+// const float *boxMax - The box's largest x and y.
+// float& enter - Set to when it's inside on both axes. Negative if it
+// starts inside, and -FLT_MAX if it doesn't move.
+// float& exit - Set to when it leaves, or 1 if it's still inside.
+// int& enterAxis - Set to the axis it enters across.
+// float& enterSide - Set to -1 if it enters through the low side of
+// that axis and 1 for the high side.
+// Output:
+// bool
+// Returns true if the point is in the box at some time from 0 to 1.
+//=============================================================================
+static bool clipToSlabs(const float *origin,
+	const float *direction,
+	const float *boxMin,
+	const float *boxMax,
+	float& enter,
+	float& exit,
+	int& enterAxis,
+	float& enterSide)
+{
+	bool miss = false;
 
-		if (distanceFromPoint(aRight, bCenter) <
-			closestDistance)
-		{
-			closestLine = aRight;
-			closestDistance = distanceFromPoint(closestLine, bCenter);
-		}
+	enter = -FLT_MAX;
+	exit = 1.0f;
+	enterAxis = 0;
+	enterSide = 0.0f;
 
-		if (distanceFromPoint(aBottom, bCenter) <
-			closestDistance)
+	for (int axis = 0; axis < 2 && !miss; axis++)
+	{
+		if (direction[axis] == 0.0f)
 		{
-			closestLine = aBottom;
-			closestDistance = distanceFromPoint(closestLine, bCenter);
+			// Parallel to the slab, so it has to start between the sides.
+			miss = origin[axis] < boxMin[axis] || boxMax[axis] < origin[axis];
 		}
-
-		if (distanceFromPoint(aLeft, bCenter) <
-			closestDistance)
+		else
 		{
-			closestLine = aLeft;
-			closestDistance = distanceFromPoint(closestLine, bCenter);
+			float near = (boxMin[axis] - origin[axis]) / direction[axis];
+			float far = (boxMax[axis] - origin[axis]) / direction[axis];
+			float side = -1.0f;
+
+			if (far < near)
+			{
+				float swap = near;
+				near = far;
+				far = swap;
+				side = 1.0f;
+			}
+
+			if (enter < near)
+			{
+				enter = near;
+				enterAxis = axis;
+				enterSide = side;
+			}
+
+			if (far < exit)
+			{
+				exit = far;
+			}
+
+			miss = exit < enter || exit < 0.0f;
 		}
+	}
 
-		Vector2D closestPoint = closestPointToPoint(closestLine, bCenter);
+	return !miss && enter <= 1.0f;
+}
 
-		Line bTop(b.getTopLeft(), b.getTopRight());
-		Line bRight(b.getTopRight(), b.getBottomRight());
-		Line bBottom(b.getBottomLeft(), b.getBottomRight());
-		Line bLeft(b.getTopLeft(), b.getBottomLeft());
+//=============================================================================
+// Function: bool segmentIntersectRect(const Rectangle&,
+// const Line&,
+// float&,
+// float&,
+// Vector2D&)
+// Description:
+// Clips a line segment against a rect with the slab test. Each axis
+// narrows the part of the segment between the rect's two sides, and
+// the segment misses once nothing is left. Rotated rects are exact,
+// since the segment is turned into the rect's own space with its
+// stored rotation first. There's no sqrt and no edge lines.
+// Parameters:
+// const Rectangle& rect - The rect to check.
+// const Line& segment - The segment, running from its start to its
+// end.
+// float& enterTime - Set to how far along the segment it enters the
+// rect, from 0 at the start to 1 at the end. 0 if it starts inside.
+// float& exitTime - Set to how far along it leaves the rect. 1 if it
+// ends inside.
+// Vector2D& normal - Set to the normal of the side it enters
+// through.
+// Output:
+// bool
+// Returns true if the segment touches the rect.
+// Returns false if it misses.
+//=============================================================================
+bool segmentIntersectRect(const Rectangle& rect,
+	const Line& segment,
+	float& enterTime,
+	float& exitTime,
+	Vector2D& normal)
+{
+	bool hit = false;
 
-		float bX = b.getMaxX();
+	Vector2D center = rect.getCenter();
+	Vector2D start = segment.m_start - center;
+	Vector2D delta = segment.m_end - segment.m_start;
 
-		if (aCenter.m_x <= bCenter.m_x)
-		{
-			bX = b.getMinX();
+	float radSine = 0.0f;
+	float radCosine = 1.0f;
 
-		}
+	if (rect.getRotation() != 0.0f)
+	{
+		RotationVector inverse = rect.getRotationVector().inverse();
 
-		Line bFirstX(Vector2D(-1.0f, -1.0f), Vector2D(-1.0f, -1.0f));
-		Line bSecondX(Vector2D(-1.0f, -1.0f), Vector2D(-1.0f, -1.0f));
+		radSine = inverse.m_sine;
+		radCosine = inverse.m_cosine;
 
-		if (bTop.m_start.m_x == bX ||
-			bTop.m_end.m_x == bX)
-		{
-			bFirstX = bTop;
-		}
+		start = Vector2D((start.m_x * radCosine) - (start.m_y * radSine),
+			(start.m_x * radSine) + (start.m_y * radCosine));
+		delta = Vector2D((delta.m_x * radCosine) - (delta.m_y * radSine),
+			(delta.m_x * radSine) + (delta.m_y * radCosine));
+	}
 
-		if (bRight.m_start.m_x == bX ||
-			bRight.m_end.m_x == bX)
-		{
-			if (bFirstX.m_start.m_x == -1.0f)
-			{
-				bFirstX = bRight;
-			}
-			else
-			{
-				bSecondX = bRight;
-			}
-		}
+	float halfWidth = (float)rect.getWidth() / 2.0f;
+	float halfHeight = (float)rect.getHeight() / 2.0f;
 
-		if (bBottom.m_start.m_x == bX ||
-			bBottom.m_end.m_x == bX)
-		{
-			if (bFirstX.m_start.m_x == -1.0f)
-			{
-				bFirstX = bBottom;
-			}
-			else
-			{
-				bSecondX = bBottom;
-			}
-		}
+	float boxMin[2] = { -halfWidth, -halfHeight };
+	float boxMax[2] = { halfWidth, halfHeight };
+	float origin[2] = { start.m_x, start.m_y };
+	float direction[2] = { delta.m_x, delta.m_y };
 
-		if (bLeft.m_start.m_x == bX ||
-			bLeft.m_end.m_x == bX)
-		{
-			bSecondX = bLeft;
-		}
+	float enter = 0.0f;
+	float exit = 0.0f;
+	int enterAxis = 0;
+	float enterSide = 0.0f;
 
-		Line closeLineStartToBX(closestLine.m_start, Vector2D(bX, closestLine.m_start.m_y));
-		Line closeLineEndToBX(closestLine.m_end, Vector2D(bX, closestLine.m_end.m_y));
+	if (clipToSlabs(origin, direction, boxMin, boxMax, enter, exit, enterAxis, enterSide))
+	{
+		hit = true;
+
+		fMax(enterTime, enter, 0.0f);
+		exitTime = exit;
+
+		Vector2D localNormal(0.0f, 0.0f);
 
-		if (totalDistance(closeLineStartToBX) < totalDistance(closeLineEndToBX))
+		if (enterAxis == 0)
 		{
-			xOverlap = (closeLineEndToBX.m_end.m_x - closeLineEndToBX.m_start.m_x);
+			localNormal.m_x = enterSide;
 		}
 		else
 		{
-			xOverlap = (closeLineStartToBX.m_end.m_x - closeLineStartToBX.m_start.m_x);
+			localNormal.m_y = enterSide;
 		}
 
-		float bY = b.getMaxY();
+		// Turn the normal back out of the rect's space.
+		normal = Vector2D((localNormal.m_x * radCosine) + (localNormal.m_y * radSine),
+			(localNormal.m_y * radCosine) - (localNormal.m_x * radSine));
+	}
 
-		if (aCenter.m_y <= bCenter.m_y)
-		{
-			bY = b.getMinY();
+	return hit;
+}
 
-		}
+//=============================================================================
+// Function: bool rayIntersectRect(const Rectangle&,
+// const Line&,
+// float&,
+// Vector2D&)
+// Description:
+// Finds where a ray first enters a rect. A ray that starts inside the
+// rect hits it right away.
+// Parameters:
+// const Rectangle& rect - The rect to check.
+// const Line& ray - The ray, running from its start to its end.
+// float& time - Set to how far along the ray the hit is, from 0 at
+// the start to 1 at the end.
+// Vector2D& normal - Set to the normal of the side that was hit.
+// Output:
+// bool
+// Returns true if the ray hits the rect.
+// Returns false if it misses.
+//=============================================================================
+bool rayIntersectRect(const Rectangle& rect,
+	const Line& ray,
+	float& time,
+	Vector2D& normal)
+{
+	float exit = 0.0f;
 
-		Line bFirstY(Vector2D(-1.0f, -1.0f), Vector2D(-1.0f, -1.0f));
-		Line bSecondY(Vector2D(-1.0f, -1.0f), Vector2D(-1.0f, -1.0f));
+	return segmentIntersectRect(rect, ray, time, exit, normal);
+}
 
-		if (bTop.m_start.m_y == bY ||
-			bTop.m_end.m_y == bY)
-		{
-			bFirstY = bTop;
-		}
+//=============================================================================
+// Function: void getSweepBounds(const Rectangle&, float*, float*)
+// Description:
+// Gets the box a rect is swept as. Unrotated rects use their rounded
+// corners, the same ones rectIntersectRect checks, and rotated rects
+// use the box around their corners.
+// Parameters:
+// const Rectangle& rect - The rect to get the box of.
+// float *boxMin - Set to the smallest x and y.
+// float *boxMax - Set to the largest x and y.
+//=============================================================================
+static void getSweepBounds(const Rectangle& rect,
+	float *boxMin,
+	float *boxMax)
+{
+	if (rect.getRotation() == 0.0f)
+	{
+		Vector2D topLeft = rect.getTopLeft();
+		Vector2D bottomRight = rect.getBottomRight();
 
-		if (bRight.m_start.m_y == bY ||
-			bRight.m_end.m_y == bY)
-		{
-			if (bFirstY.m_start.m_y == -1.0f)
-			{
-				bFirstY = bRight;
-			}
-			else
-			{
-				bSecondY = bRight;
-			}
-		}
+		boxMin[0] = topLeft.m_x;
+		boxMin[1] = topLeft.m_y;
+		boxMax[0] = bottomRight.m_x;
+		boxMax[1] = bottomRight.m_y;
+	}
+	else
+	{
+		boxMin[0] = rect.getMinX();
+		boxMin[1] = rect.getMinY();
+		boxMax[0] = rect.getMaxX();
+		boxMax[1] = rect.getMaxY();
+	}
+}
 
-		if (bBottom.m_start.m_y == bY ||
-			bBottom.m_end.m_y == bY)
-		{
-			if (bFirstY.m_start.m_y == -1.0f)
-			{
-				bFirstY = bBottom;
-			}
-			else
-			{
-				bSecondY = bBottom;
-			}
-		}
+//=============================================================================
+// Function: bool sweepRectRect(const Rectangle&,
+// const Vector2D&,
+// const Rectangle&,
+// float&,
+// Vector2D&)
+// Description:
+// Finds when a moving rect first touches another one. The target's
+// box is grown by the mover's box around its center, so the mover
+// can be treated as its center point and clipped with the slab test.
+// Rects that already overlap aren't counted, so the mover can move
+// back out of them, and neither are rects it only meets edge to
+// edge, so it can slide across the seams between them.
+// Parameters:
+// const Rectangle& moving - The rect that's moving, where it starts.
+// const Vector2D& movement - How far it moves.
+// const Rectangle& target - The rect it might hit.
+// float& time - Set to how far along the movement it touches, from
+// 0 at the start to 1 at the end.
+// Vector2D& normal - Set to the normal of the target's side it hits.
+// Output:
+// bool
+// Returns true if the rect hits the target during the movement.
+// Returns false if it misses or already overlaps it.
+//=============================================================================
+bool sweepRectRect(const Rectangle& moving,
+	const Vector2D& movement,
+	const Rectangle& target,
+	float& time,
+	Vector2D& normal)
+{
+	bool hit = false;
 
-		if (bLeft.m_start.m_y == bY ||
-			bLeft.m_end.m_y == bY)
-		{
-			bSecondY = bLeft;
-		}
+	float movingMin[2];
+	float movingMax[2];
+	float boxMin[2];
+	float boxMax[2];
+
+	getSweepBounds(moving, movingMin, movingMax);
+	getSweepBounds(target, boxMin, boxMax);
+
+	float origin[2] = { moving.getCenter().m_x, moving.getCenter().m_y };
+	float direction[2] = { movement.m_x, movement.m_y };
+
+	for (int axis = 0; axis < 2; axis++)
+	{
+		boxMin[axis] -= origin[axis] - movingMin[axis];
+		boxMax[axis] += movingMax[axis] - origin[axis];
+	}
+
+	float enter = 0.0f;
+	float exit = 0.0f;
+	int enterAxis = 0;
+	float enterSide = 0.0f;
+
+	if (clipToSlabs(origin, direction, boxMin, boxMax, enter, exit, enterAxis, enterSide) &&
+		0.0f <= enter)
+	{
+		// It has to overlap on the other axis too, or be moving into
+		// it. A rect sliding along the top of a row of tiles meets the
+		// next tile's side with no overlap, and mustn't stop at the
+		// seam.
+		int otherAxis = 1 - enterAxis;
+		float other = origin[otherAxis] + (direction[otherAxis] * enter);
+
+		hit = (boxMin[otherAxis] < other || 0.0f < direction[otherAxis]) &&
+			(other < boxMax[otherAxis] || direction[otherAxis] < 0.0f);
+	}
+
+	if (hit)
+	{
+		time = enter;
 
-		Line closeLineStartToBY(closestLine.m_start, Vector2D(closestLine.m_start.m_x, bY));
-		Line closeLineEndToBY(closestLine.m_end, Vector2D(closestLine.m_end.m_x, bY));
+		normal = Vector2D(0.0f, 0.0f);
 
-		if (totalDistance(closeLineStartToBY) < totalDistance(closeLineEndToBY))
+		if (enterAxis == 0)
 		{
-			yOverlap = (closeLineEndToBY.m_end.m_y - closeLineEndToBY.m_start.m_y);
+			normal.m_x = enterSide;
 		}
 		else
 		{
-			yOverlap = (closeLineStartToBY.m_end.m_y - closeLineStartToBY.m_start.m_y);
+			normal.m_y = enterSide;
 		}
 	}
 
-	return Vector2D(xOverlap, yOverlap);
+	return hit;
 }
\ No newline at end of file
@@ -10,6 +10,33 @@
 #include "Rectangle.h"
 #include "Line.h"
 
+struct CollisionManifold
+{
+	static const int MAX_CONTACTS = 2;
+
+	CollisionManifold()
+		: m_colliding(false),
+		m_normal(0.0f, 0.0f),
+		m_depth(0.0f),
+		m_contactCount(0)
+	{
+	}
+
+	const Vector2D getTranslation() const;
+
+	bool m_colliding;
+
+	// Points from the second rect toward the first, with a length of 1.
+	// Moving the first rect along it by the depth separates them.
+	Vector2D m_normal;
+	float m_depth;
+
+	// The two ends of the area the rects share, across the normal. Only
+	// one if it comes down to a single point.
+	Vector2D m_contacts[MAX_CONTACTS];
+	int m_contactCount;
+};
+
 bool pointInRect(const Rectangle& rect,
 	const Vector2D& point);
 
@@ -22,6 +49,14 @@ bool rectInsideRect(const Rectangle& a,
 bool rectIntersectRect(const Rectangle& a,
 	const Rectangle& b);
 
+bool rectIntersectRect(const Rectangle& a,
+	const Rectangle& b,
+	Vector2D& translation);
+
+bool getManifold(const Rectangle& a,
+	const Rectangle& b,
+	CollisionManifold& manifold);
+
 Vector2D intersectPoint(const Rectangle& rect,
 	const Line& line);
 
@@ -29,4 +64,21 @@ Vector2D intersectPoint(const Rectangle& a,
 	const Rectangle& b);
 
 Vector2D overlapAmount(const Rectangle& a,
-	const Rectangle& b);
\ No newline at end of file
+	const Rectangle& b);
+
+bool segmentIntersectRect(const Rectangle& rect,
+	const Line& segment,
+	float& enter,
+	float& exit,
+	Vector2D& normal);
+
+bool rayIntersectRect(const Rectangle& rect,
+	const Line& ray,
+	float& time,
+	Vector2D& normal);
+
+bool sweepRectRect(const Rectangle& moving,
+	const Vector2D& movement,
+	const Rectangle& target,
+	float& time,
+	Vector2D& normal);
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "LogLocator.h"
 #include "Camera2D.h"
 #include "PhysicsSystem.h"
+#include <algorithm>
 
 Game::Game(const string loadPath)
 	:m_window(NULL),
@@ -217,18 +218,42 @@ bool Game::init(const string loadPath)
 
 		if (ResourceManager::initialized())
 		{
-			int width = 10000;
-			int height = 10000;
+			// The world the map is expected to fill. The hashed quad
+			// trees keep working past it, but the cells are sized from
+			// it, and the other index types are bounded by it.
+			const int WORLD_WIDTH = 10000;
+			const int WORLD_HEIGHT = 10000;
+
+			// Four cells across the world makes each cell about two
+			// screens wide, so a viewport search only reaches the few
+			// cells around the camera, while each cell's tree still
+			// holds enough to be worth splitting.
+			const int CELLS_ACROSS = 4;
+
+			// Split a node past ten entities and stop ten levels down,
+			// the limits the systems have always been built with.
+			const int MAX_OBJECTS = 10;
+			const int MAX_LEVELS = 10;
+
+			Rectangle worldBounds(Vector2D((float)(WORLD_WIDTH / 2), (float)(WORLD_HEIGHT / 2)),
+				WORLD_WIDTH,
+				WORLD_HEIGHT);
+
+			int cellSize = std::max(WORLD_WIDTH, WORLD_HEIGHT) / CELLS_ACROSS;
 
 			m_renderSystem =
-				new RenderSystem(Rectangle(Vector2D((float)(width / 2), (float)(height / 2)), width, height),
-					10, 
-					10);
+				new RenderSystem(worldBounds,
+					MAX_OBJECTS, 
+					MAX_LEVELS,
+					INDEX_HASHED_QUADTREE,
+					cellSize);
 
 			m_physicsSystem =
-				new PhysicsSystem(10,
-					10,
-					Rectangle(Vector2D((float)(width / 2), (float)(height / 2)), width, height));
+				new PhysicsSystem(MAX_LEVELS,
+					MAX_OBJECTS,
+					worldBounds,
+					INDEX_HASHED_QUADTREE,
+					cellSize);
 
 			Rectangle size(Vector2D(1280.0f / 2.0f, 720.0f / 2.0f), 1280, 720);
 
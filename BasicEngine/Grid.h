@@ -3,25 +3,937 @@
 // File Name: Grid.h
 // Author: Brian Blackmon
 // Date Created: 10/25/2019
-// Purpose: 
-// A grid storage class. It holds items in a linked grid.
+// Purpose:
+// A uniform grid storage class. Every entity is linked into each
+// cell its bounds cover. The links live in a shared slab so adding
+// and removing reuse old links instead of allocating.
+// Data needs an int m_id and a Rectangle m_size, like EntityData.
 //==========================================================================================
 #include <vector>
-#include "Node.h"
-#include "Rectangle.h"
+#include "ISpatialIndex.h"
+#include "Collision.h"
+#include "BBMath.h"
+#include <cfloat>
 
 template <class Data>
-class Grid
+class Grid : public ISpatialIndex<Data>
 {
 public:
-	Grid(const int width,
-		const int height,
+	Grid(const Rectangle& bounds,
 		const int cellWidth,
 		const int cellHeight)
+		:m_freeLink(NO_INDEX),
+		m_originX(bounds.getMinX()),
+		m_originY(bounds.getMinY()),
+		m_cellWidth(cellWidth),
+		m_cellHeight(cellHeight),
+		m_columns(1),
+		m_rows(1)
 	{
+		if (m_cellWidth <= 0)
+		{
+			m_cellWidth = 1;
+		}
 
+		if (m_cellHeight <= 0)
+		{
+			m_cellHeight = 1;
+		}
+
+		m_columns = (bounds.getWidth() + m_cellWidth - 1) / m_cellWidth;
+		m_rows = (bounds.getHeight() + m_cellHeight - 1) / m_cellHeight;
+
+		if (m_columns <= 0)
+		{
+			m_columns = 1;
+		}
+
+		if (m_rows <= 0)
+		{
+			m_rows = 1;
+		}
+
+		m_grid.assign(m_columns * m_rows, (int)NO_INDEX);
+	}
+
+	virtual ~Grid()
+	{
+
+	}
+
+	using ISpatialIndex<Data>::search;
+	using ISpatialIndex<Data>::withinRadius;
+
+	//=============================================================================
+	// Function: const int getColumns() const
+	// Description:
+	// Gets the number of columns in the grid.
+	// Output:
+	// const int
+	// Returns the column count.
+	//=============================================================================
+	const int getColumns() const
+	{
+		return m_columns;
+	}
+
+	//=============================================================================
+	// Function: const int getRows() const
+	// Description:
+	// Gets the number of rows in the grid.
+	// Output:
+	// const int
+	// Returns the row count.
+	//=============================================================================
+	const int getRows() const
+	{
+		return m_rows;
+	}
+
+	//=============================================================================
+	// Function: void search(const Rectangle&,
+	// ISpatialVisitor<Data>&) const
+	// Description:
+	// Searches the cells under the area for entities inside it.
+	// An entity is only reported from the first cell it shares with
+	// the search, so entities spanning cells aren't duplicated.
+	// Parameters:
+	// const Rectangle& searchArea - The area to search inside.
+	// ISpatialVisitor<Data>& visitor - The visitor to call. The search
+	// stops as soon as it returns false.
+	//=============================================================================
+	virtual void search(const Rectangle& searchArea,
+		ISpatialVisitor<Data>& visitor) const
+	{
+		CellRange area = getCellRange(searchArea);
+
+		for (int row = area.m_minRow; row <= area.m_maxRow; row++)
+		{
+			for (int column = area.m_minColumn; column <= area.m_maxColumn; column++)
+			{
+				int link = m_grid[getCellIndex(column, row)];
+
+				while (link != NO_INDEX)
+				{
+					const Data& entity = m_links[link].m_data;
+
+					if (isReferenceCell(entity.m_size, area, column, row) &&
+						rectIntersectRect(entity.m_size, searchArea) &&
+						!visitor.visit(entity))
+					{
+						return;
+					}
+
+					link = m_links[link].m_next;
+				}
+			}
+		}
+	}
+
+	//=============================================================================
+	// Function: void search(const Line&,
+	// ISpatialVisitor<Data>&) const
+	// Description:
+	// Searches the cells under the bounding box of the line for
+	// entities the line touches. Long diagonal lines visit more cells
+	// than they cross, which is fine for the short movement lines
+	// this is used for.
+	// Parameters:
+	// const Line& searchLine - The line to search along.
+	// ISpatialVisitor<Data>& visitor - The visitor to call. The search
+	// stops as soon as it returns false.
+	//=============================================================================
+	virtual void search(const Line& searchLine,
+		ISpatialVisitor<Data>& visitor) const
+	{
+		CellRange area = getCellRange(searchLine);
+
+		for (int row = area.m_minRow; row <= area.m_maxRow; row++)
+		{
+			for (int column = area.m_minColumn; column <= area.m_maxColumn; column++)
+			{
+				int link = m_grid[getCellIndex(column, row)];
+
+				while (link != NO_INDEX)
+				{
+					const Data& entity = m_links[link].m_data;
+
+					if (isReferenceCell(entity.m_size, area, column, row) &&
+						lineInRect(entity.m_size, searchLine) &&
+						!visitor.visit(entity))
+					{
+						return;
+					}
+
+					link = m_links[link].m_next;
+				}
+			}
+		}
+	}
+
+	//=============================================================================
+	// Function: void addEntity(const Data&)
+	// Description:
+	// Links the entity into every cell its bounds cover.
+	// Parameters:
+	// const Data& entity - The entity to add.
+	//=============================================================================
+	virtual void addEntity(const Data& entity)
+	{
+		CellRange range = getCellRange(entity.m_size);
+
+		for (int row = range.m_minRow; row <= range.m_maxRow; row++)
+		{
+			for (int column = range.m_minColumn; column <= range.m_maxColumn; column++)
+			{
+				int cell = getCellIndex(column, row);
+				int link = createLink(entity);
+
+				m_links[link].m_next = m_grid[cell];
+				m_grid[cell] = link;
+			}
+		}
+	}
+
+	//=============================================================================
+	// Function: void removeEntity(const Data&)
+	// Description:
+	// Unlinks the entity from every cell its bounds cover.
+	// Parameters:
+	// const Data& entity - The entity to remove. The size has to
+	// match the size it was added or last moved with.
+	//=============================================================================
+	virtual void removeEntity(const Data& entity)
+	{
+		CellRange range = getCellRange(entity.m_size);
+
+		for (int row = range.m_minRow; row <= range.m_maxRow; row++)
+		{
+			for (int column = range.m_minColumn; column <= range.m_maxColumn; column++)
+			{
+				int cell = getCellIndex(column, row);
+
+				int previous = NO_INDEX;
+				int link = m_grid[cell];
+
+				while (link != NO_INDEX)
+				{
+					if (m_links[link].m_data.m_id == entity.m_id)
+					{
+						if (previous == NO_INDEX)
+						{
+							m_grid[cell] = m_links[link].m_next;
+						}
+						else
+						{
+							m_links[previous].m_next = m_links[link].m_next;
+						}
+
+						releaseLink(link);
+						break;
+					}
+
+					previous = link;
+					link = m_links[link].m_next;
+				}
+			}
+		}
+	}
+
+	//=============================================================================
+	// Function: void moveEntity(const Data&, const Rectangle&)
+	// Description:
+	// Moves the entity to its new size. If it still covers the same
+	// cells the links are updated in place.
+	// Parameters:
+	// const Data& entity - The entity at its old size.
+	// const Rectangle& size - The new size.
+	//=============================================================================
+	virtual void moveEntity(const Data& entity,
+		const Rectangle& size)
+	{
+		CellRange oldRange = getCellRange(entity.m_size);
+		CellRange newRange = getCellRange(size);
+
+		if (oldRange.m_minColumn == newRange.m_minColumn &&
+			oldRange.m_maxColumn == newRange.m_maxColumn &&
+			oldRange.m_minRow == newRange.m_minRow &&
+			oldRange.m_maxRow == newRange.m_maxRow)
+		{
+			for (int row = newRange.m_minRow; row <= newRange.m_maxRow; row++)
+			{
+				for (int column = newRange.m_minColumn; column <= newRange.m_maxColumn; column++)
+				{
+					int link = m_grid[getCellIndex(column, row)];
+
+					while (link != NO_INDEX)
+					{
+						if (m_links[link].m_data.m_id == entity.m_id)
+						{
+							m_links[link].m_data = entity;
+							m_links[link].m_data.m_size = size;
+							break;
+						}
+
+						link = m_links[link].m_next;
+					}
+				}
+			}
+		}
+		else
+		{
+			removeEntity(entity);
+
+			Data moved = entity;
+			moved.m_size = size;
+
+			addEntity(moved);
+		}
+	}
+
+	//=============================================================================
+	// Function: bool raycast(const Line&,
+	// RaycastHit&,
+	// const ISpatialFilter<Data>*) const
+	// Description:
+	// Finds the first entity the ray hits by stepping through the
+	// cells in the order the ray crosses them. Once the closest hit
+	// is before the ray leaves the current cell nothing further
+	// along can be closer, so the walk stops there.
+	// Parameters:
+	// const Line& ray - The ray to cast, from its start to its end.
+	// RaycastHit& hit - Set to the closest hit.
+	// const ISpatialFilter<Data> *filter - Skips the entities it
+	// doesn't accept. NULL accepts everything.
+	// Output:
+	// bool
+	// Returns true if something was hit.
+	//=============================================================================
+	virtual bool raycast(const Line& ray,
+		RaycastHit& hit,
+		const ISpatialFilter<Data> *filter = NULL) const
+	{
+		bool found = false;
+
+		float startX = ray.m_start.m_x - m_originX;
+		float startY = ray.m_start.m_y - m_originY;
+		float deltaX = ray.m_end.m_x - ray.m_start.m_x;
+		float deltaY = ray.m_end.m_y - ray.m_start.m_y;
+
+		int column = getCell(startX, m_cellWidth, m_columns);
+		int row = getCell(startY, m_cellHeight, m_rows);
+
+		// Points off the grid belong to the edge cells, so an axis
+		// stops stepping once it reaches the edge.
+		int columnStep = 0;
+		float columnTime = 0.0f;
+		float nextColumn = FLT_MAX;
+
+		if (0.0f < deltaX)
+		{
+			columnStep = 1;
+			columnTime = (float)m_cellWidth / deltaX;
+
+			if (column < m_columns - 1)
+			{
+				nextColumn = ((float)((column + 1) * m_cellWidth) - startX) / deltaX;
+			}
+		}
+		else if (deltaX < 0.0f)
+		{
+			columnStep = -1;
+			columnTime = (float)m_cellWidth / -deltaX;
+
+			if (0 < column)
+			{
+				nextColumn = ((float)(column * m_cellWidth) - startX) / deltaX;
+			}
+		}
+
+		int rowStep = 0;
+		float rowTime = 0.0f;
+		float nextRow = FLT_MAX;
+
+		if (0.0f < deltaY)
+		{
+			rowStep = 1;
+			rowTime = (float)m_cellHeight / deltaY;
+
+			if (row < m_rows - 1)
+			{
+				nextRow = ((float)((row + 1) * m_cellHeight) - startY) / deltaY;
+			}
+		}
+		else if (deltaY < 0.0f)
+		{
+			rowStep = -1;
+			rowTime = (float)m_cellHeight / -deltaY;
+
+			if (0 < row)
+			{
+				nextRow = ((float)(row * m_cellHeight) - startY) / deltaY;
+			}
+		}
+
+		bool done = false;
+
+		while (!done)
+		{
+			int link = m_grid[getCellIndex(column, row)];
+
+			while (link != NO_INDEX)
+			{
+				this->checkRayHit(m_links[link].m_data, ray, filter, hit, found);
+
+				link = m_links[link].m_next;
+			}
+
+			float exitTime = nextColumn;
+
+			fMin(exitTime, nextColumn, nextRow);
+
+			if (1.0f <= exitTime ||
+				(found && hit.m_time <= exitTime))
+			{
+				done = true;
+			}
+			else if (nextColumn < nextRow)
+			{
+				column += columnStep;
+				nextColumn += columnTime;
+
+				if (column == 0 || column == m_columns - 1)
+				{
+					nextColumn = FLT_MAX;
+				}
+			}
+			else
+			{
+				row += rowStep;
+				nextRow += rowTime;
+
+				if (row == 0 || row == m_rows - 1)
+				{
+					nextRow = FLT_MAX;
+				}
+			}
+		}
+
+		return found;
+	}
+
+	//=============================================================================
+	// Function: void nearest(const Vector2D&,
+	// const int,
+	// vector<Data>&) const
+	// Description:
+	// Finds the entities whose centers are closest to the point by
+	// searching rings of cells outwards from the point's cell. Each
+	// entity is only counted in the cell holding its center. Once
+	// everything kept is closer than the nearest unsearched side of
+	// the rings, nothing further out can beat it.
+	// Parameters:
+	// const Vector2D& point - The point to search from.
+	// const int count - The most entities to find.
+	// vector<Data>& nearest - Filled with the entities, closest
+	// first. It's cleared first.
+	//=============================================================================
+	virtual void nearest(const Vector2D& point,
+		const int count,
+		std::vector<Data>& nearest) const
+	{
+		nearest.clear();
+
+		if (0 < count)
+		{
+			float pointX = point.m_x - m_originX;
+			float pointY = point.m_y - m_originY;
+
+			int column = getCell(pointX, m_cellWidth, m_columns);
+			int row = getCell(pointY, m_cellHeight, m_rows);
+
+			bool done = false;
+			int ring = 0;
+
+			while (!done)
+			{
+				CellRange block;
+
+				block.m_minColumn = column - ring;
+				block.m_maxColumn = column + ring;
+				block.m_minRow = row - ring;
+				block.m_maxRow = row + ring;
+
+				for (int ringRow = block.m_minRow; ringRow <= block.m_maxRow; ringRow++)
+				{
+					if (0 <= ringRow && ringRow < m_rows)
+					{
+						// Rows inside the ring only have their two end cells on it.
+						int step = block.m_maxColumn - block.m_minColumn;
+
+						if (ringRow == block.m_minRow || ringRow == block.m_maxRow || step == 0)
+						{
+							step = 1;
+						}
+
+						for (int ringColumn = block.m_minColumn; ringColumn <= block.m_maxColumn; ringColumn += step)
+						{
+							if (0 <= ringColumn && ringColumn < m_columns)
+							{
+								int link = m_grid[getCellIndex(ringColumn, ringRow)];
+
+								while (link != NO_INDEX)
+								{
+									const Data& entity = m_links[link].m_data;
+
+									if (isCenterCell(entity.m_size, ringColumn, ringRow))
+									{
+										this->keepNearest(entity, point, count, nearest);
+									}
+
+									link = m_links[link].m_next;
+								}
+							}
+						}
+					}
+				}
+
+				// Find how close an unsearched cell could be. Sides at the
+				// edge of the grid have nothing past them.
+				float gap = FLT_MAX;
+
+				if (0 < block.m_minColumn)
+				{
+					fMin(gap, gap, pointX - (float)(block.m_minColumn * m_cellWidth));
+				}
+
+				if (block.m_maxColumn < m_columns - 1)
+				{
+					fMin(gap, gap, (float)((block.m_maxColumn + 1) * m_cellWidth) - pointX);
+				}
+
+				if (0 < block.m_minRow)
+				{
+					fMin(gap, gap, pointY - (float)(block.m_minRow * m_cellHeight));
+				}
+
+				if (block.m_maxRow < m_rows - 1)
+				{
+					fMin(gap, gap, (float)((block.m_maxRow + 1) * m_cellHeight) - pointY);
+				}
+
+				if (gap == FLT_MAX)
+				{
+					done = true;
+				}
+				else
+				{
+					fMax(gap, gap, 0.0f);
+
+					done = !this->canBeNearer(gap * gap, point, count, nearest);
+				}
+
+				ring++;
+			}
+
+			this->sortNearest(point, nearest);
+		}
+	}
+
+	//=============================================================================
+	// Function: void withinRadius(const Vector2D&,
+	// const float,
+	// ISpatialVisitor<Data>&) const
+	// Description:
+	// Visits every entity whose center is within the radius of the
+	// point. Only the cells under the circle's bounds are searched and
+	// each entity is only reported from the cell holding its center.
+	// Parameters:
+	// const Vector2D& point - The center of the circle.
+	// const float radius - The radius of the circle.
+	// ISpatialVisitor<Data>& visitor - The visitor to call. The search
+	// stops as soon as it returns false.
+	//=============================================================================
+	virtual void withinRadius(const Vector2D& point,
+		const float radius,
+		ISpatialVisitor<Data>& visitor) const
+	{
+		CellRange area = getCellRange(point.m_x - radius,
+			point.m_y - radius,
+			point.m_x + radius,
+			point.m_y + radius);
+
+		float radiusSquared = radius * radius;
+
+		for (int row = area.m_minRow; row <= area.m_maxRow; row++)
+		{
+			for (int column = area.m_minColumn; column <= area.m_maxColumn; column++)
+			{
+				int link = m_grid[getCellIndex(column, row)];
+
+				while (link != NO_INDEX)
+				{
+					const Data& entity = m_links[link].m_data;
+
+					if (isCenterCell(entity.m_size, column, row) &&
+						this->centerDistance(entity, point) <= radiusSquared &&
+						!visitor.visit(entity))
+					{
+						return;
+					}
+
+					link = m_links[link].m_next;
+				}
+			}
+		}
+	}
+
+	//=============================================================================
+	// Function: void forEachOverlappingPair(ISpatialPairVisitor<Data>&) const
+	// Description:
+	// Visits every pair of overlapping entities by testing the
+	// entities that share a cell. A pair is only reported from the
+	// first cell the two share, so pairs spanning cells aren't
+	// duplicated.
+	// Parameters:
+	// ISpatialPairVisitor<Data>& visitor - The visitor to call. The
+	// search stops as soon as it returns false.
+	//=============================================================================
+	virtual void forEachOverlappingPair(ISpatialPairVisitor<Data>& visitor) const
+	{
+		for (int row = 0; row < m_rows; row++)
+		{
+			for (int column = 0; column < m_columns; column++)
+			{
+				int link = m_grid[getCellIndex(column, row)];
+
+				while (link != NO_INDEX)
+				{
+					const Data& entity = m_links[link].m_data;
+
+					int other = m_links[link].m_next;
+
+					while (other != NO_INDEX)
+					{
+						const Data& otherEntity = m_links[other].m_data;
+
+						if (isReferenceCell(entity.m_size, getCellRange(otherEntity.m_size), column, row) &&
+							this->pairOverlaps(entity, otherEntity) &&
+							!visitor.visit(entity, otherEntity))
+						{
+							return;
+						}
+
+						other = m_links[other].m_next;
+					}
+
+					link = m_links[link].m_next;
+				}
+			}
+		}
+	}
+
+	//=============================================================================
+	// Function: ISpatialIndex<Data>* createSnapshot() const
+	// Description:
+	// Creates a read-only copy of the grid.
+	// Output:
+	// ISpatialIndex<Data>*
+	// Returns the snapshot. The caller owns it.
+	//=============================================================================
+	virtual ISpatialIndex<Data>* createSnapshot() const
+	{
+		return new Grid<Data>(*this);
+	}
+
+	//=============================================================================
+	// Function: void updateSnapshot(ISpatialIndex<Data>&) const
+	// Description:
+	// Copies the cells and links into a snapshot, reusing its memory.
+	// Parameters:
+	// ISpatialIndex<Data>& snapshot - A snapshot from createSnapshot.
+	//=============================================================================
+	virtual void updateSnapshot(ISpatialIndex<Data>& snapshot) const
+	{
+		Grid<Data>& grid = static_cast<Grid<Data>&>(snapshot);
+
+		grid.m_grid = m_grid;
+		grid.m_links = m_links;
+		grid.m_freeLink = m_freeLink;
+	}
+
+	//=============================================================================
+	// Function: void clear()
+	// Description:
+	// Empties every cell and drops all of the links.
+	//=============================================================================
+	virtual void clear()
+	{
+		m_grid.assign(m_grid.size(), (int)NO_INDEX);
+		m_links.clear();
+
+		m_freeLink = NO_INDEX;
 	}
 
 private:
-	std::vector<Node<Data>*> m_grid;
-};
\ No newline at end of file
+	static const int NO_INDEX = -1;
+
+	struct CellRange
+	{
+		int m_minColumn;
+		int m_minRow;
+		int m_maxColumn;
+		int m_maxRow;
+	};
+
+	struct GridLink
+	{
+		GridLink(const Data& data)
+			:m_data(data),
+			m_next(NO_INDEX)
+		{
+
+		}
+
+		Data m_data;
+
+		// Links to the next entity in the cell, or the next free link.
+		int m_next;
+	};
+
+	std::vector<int> m_grid;
+	std::vector<GridLink> m_links;
+
+	int m_freeLink;
+
+	float m_originX;
+	float m_originY;
+
+	int m_cellWidth;
+	int m_cellHeight;
+	int m_columns;
+	int m_rows;
+
+	//=============================================================================
+	// Function: const int getCellIndex(const int, const int) const
+	// Description:
+	// Gets the index of a cell in the grid.
+	// Parameters:
+	// const int column - The column of the cell.
+	// const int row - The row of the cell.
+	// Output:
+	// const int
+	// Returns the cell index.
+	//=============================================================================
+	const int getCellIndex(const int column,
+		const int row) const
+	{
+		return row * m_columns + column;
+	}
+
+	//=============================================================================
+	// Function: CellRange getCellRange(const float,
+	// const float,
+	// const float,
+	// const float) const
+	// Description:
+	// Gets the cells covered by the bounds. Bounds outside of the
+	// grid are clamped to the edge cells so nothing gets lost.
+	// The bounds are padded by a pixel to cover corner rounding.
+	// Parameters:
+	// const float minX - The left of the bounds.
+	// const float minY - The top of the bounds.
+	// const float maxX - The right of the bounds.
+	// const float maxY - The bottom of the bounds.
+	// Output:
+	// CellRange
+	// Returns the covered cell range.
+	//=============================================================================
+	CellRange getCellRange(const float minX,
+		const float minY,
+		const float maxX,
+		const float maxY) const
+	{
+		CellRange range;
+
+		range.m_minColumn = getCell(minX - 1.0f - m_originX, m_cellWidth, m_columns);
+		range.m_maxColumn = getCell(maxX + 1.0f - m_originX, m_cellWidth, m_columns);
+		range.m_minRow = getCell(minY - 1.0f - m_originY, m_cellHeight, m_rows);
+		range.m_maxRow = getCell(maxY + 1.0f - m_originY, m_cellHeight, m_rows);
+
+		return range;
+	}
+
+	//=============================================================================
+	// Function: CellRange getCellRange(const Rectangle&) const
+	// Description:
+	// Gets the cells covered by the bounding box of a rectangle.
+	// Parameters:
+	// const Rectangle& rect - The rectangle to cover.
+	// Output:
+	// CellRange
+	// Returns the covered cell range.
+	//=============================================================================
+	CellRange getCellRange(const Rectangle& rect) const
+	{
+		return getCellRange(rect.getMinX(), rect.getMinY(), rect.getMaxX(), rect.getMaxY());
+	}
+
+	//=============================================================================
+	// Function: CellRange getCellRange(const Line&) const
+	// Description:
+	// Gets the cells covered by the bounding box of a line.
+	// Parameters:
+	// const Line& line - The line to cover.
+	// Output:
+	// CellRange
+	// Returns the covered cell range.
+	//=============================================================================
+	CellRange getCellRange(const Line& line) const
+	{
+		float minX = 0.0f;
+		float minY = 0.0f;
+		float maxX = 0.0f;
+		float maxY = 0.0f;
+
+		fMin(minX, line.m_start.m_x, line.m_end.m_x);
+		fMin(minY, line.m_start.m_y, line.m_end.m_y);
+		fMax(maxX, line.m_start.m_x, line.m_end.m_x);
+		fMax(maxY, line.m_start.m_y, line.m_end.m_y);
+
+		return getCellRange(minX, minY, maxX, maxY);
+	}
+
+	//=============================================================================
+	// Function: const int getCell(const float, const int, const int) const
+	// Description:
+	// Converts a distance from the grid origin into a clamped cell.
+	// Parameters:
+	// const float position - The distance from the origin.
+	// const int cellSize - The size of a cell on this axis.
+	// const int cellCount - The number of cells on this axis.
+	// Output:
+	// const int
+	// Returns the cell on the axis.
+	//=============================================================================
+	const int getCell(const float position,
+		const int cellSize,
+		const int cellCount) const
+	{
+		int cell = 0;
+
+		if (0.0f < position)
+		{
+			cell = (int)(position / (float)cellSize);
+
+			if (cellCount <= cell)
+			{
+				cell = cellCount - 1;
+			}
+		}
+
+		return cell;
+	}
+
+	//=============================================================================
+	// Function: const bool isReferenceCell(const Rectangle&,
+	// const CellRange&,
+	// const int,
+	// const int) const
+	// Description:
+	// Checks if the cell is the first cell the entity and search
+	// share. Only that cell reports the entity.
+	// Parameters:
+	// const Rectangle& size - The size of the entity.
+	// const CellRange& area - The cells being searched.
+	// const int column - The column being checked.
+	// const int row - The row being checked.
+	// Output:
+	// const bool
+	// Returns true if the entity should be reported from this cell.
+	//=============================================================================
+	const bool isReferenceCell(const Rectangle& size,
+		const CellRange& area,
+		const int column,
+		const int row) const
+	{
+		CellRange range = getCellRange(size);
+
+		int referenceColumn = range.m_minColumn;
+		int referenceRow = range.m_minRow;
+
+		iMax(referenceColumn, referenceColumn, area.m_minColumn);
+		iMax(referenceRow, referenceRow, area.m_minRow);
+
+		return (referenceColumn == column && referenceRow == row);
+	}
+
+	//=============================================================================
+	// Function: const bool isCenterCell(const Rectangle&,
+	// const int,
+	// const int) const
+	// Description:
+	// Checks if the cell holds the center of the entity. The entity
+	// is always linked into that cell, so it's used to report each
+	// entity once in the searches that go by center.
+	// Parameters:
+	// const Rectangle& size - The size of the entity.
+	// const int column - The column being checked.
+	// const int row - The row being checked.
+	// Output:
+	// const bool
+	// Returns true if the center is in the cell.
+	//=============================================================================
+	const bool isCenterCell(const Rectangle& size,
+		const int column,
+		const int row) const
+	{
+		const Vector2D& center = size.getCenter();
+
+		return (getCell(center.m_x - m_originX, m_cellWidth, m_columns) == column &&
+			getCell(center.m_y - m_originY, m_cellHeight, m_rows) == row);
+	}
+
+	//=============================================================================
+	// Function: const int createLink(const Data&)
+	// Description:
+	// Stores the entity in a link, reusing a free one if possible.
+	// Parameters:
+	// const Data& entity - The entity to store.
+	// Output:
+	// const int
+	// Returns the index of the link.
+	//=============================================================================
+	const int createLink(const Data& entity)
+	{
+		int link = m_freeLink;
+
+		if (link != NO_INDEX)
+		{
+			m_freeLink = m_links[link].m_next;
+			m_links[link].m_data = entity;
+			m_links[link].m_next = NO_INDEX;
+		}
+		else
+		{
+			link = (int)m_links.size();
+
+			m_links.emplace_back(GridLink(entity));
+		}
+
+		return link;
+	}
+
+	//=============================================================================
+	// Function: void releaseLink(const int)
+	// Description:
+	// Puts a link back on the free list.
+	// Parameters:
+	// const int link - The link to release.
+	//=============================================================================
+	void releaseLink(const int link)
+	{
+		m_links[link].m_next = m_freeLink;
+		m_freeLink = link;
+	}
+};
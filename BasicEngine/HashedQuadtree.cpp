@@ -0,0 +1,846 @@
+#include "HashedQuadtree.h"
+#include "Quadtree.h"
+#include "BBMath.h"
+#include <algorithm>
+#include <cmath>
+
+HashedQuadtree::HashedQuadtree(const int cellSize,
+	const int maxObjects,
+	const int maxLevels)
+	:m_cellSize(cellSize),
+	m_maxObjects(maxObjects),
+	m_maxLevels(maxLevels)
+{
+	if (m_cellSize < 2)
+	{
+		m_cellSize = 2;
+	}
+	else if (MAX_CELL_SIZE < m_cellSize)
+	{
+		m_cellSize = MAX_CELL_SIZE;
+	}
+}
+
+HashedQuadtree::~HashedQuadtree()
+{
+	clear();
+}
+
+//=============================================================================
+// Function: const int getCellSize() const
+// Description:
+// Gets the width and height of the smallest cells.
+// Output:
+// const int
+// Returns the cell size.
+//=============================================================================
+const int HashedQuadtree::getCellSize() const
+{
+	return m_cellSize;
+}
+
+//=============================================================================
+// Function: const int getCellCount() const
+// Description:
+// Gets the number of cells that currently have a tree.
+// Output:
+// const int
+// Returns the cell count.
+//=============================================================================
+const int HashedQuadtree::getCellCount() const
+{
+	return (int)m_cells.size();
+}
+
+//=============================================================================
+// Function: const int getCount() const
+// Description:
+// Gets the number of entities stored.
+// Output:
+// const int
+// Returns the entity count.
+//=============================================================================
+const int HashedQuadtree::getCount() const
+{
+	return (int)m_locations.size();
+}
+
+//=============================================================================
+// Function: void search(const Rectangle&,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Searches the tree of every cell whose loose bounds reach the area.
+// Parameters:
+// const Rectangle& searchArea - The area to search inside.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call. The
+// search stops as soon as it returns false.
+//=============================================================================
+void HashedQuadtree::search(const Rectangle& searchArea,
+	ISpatialVisitor<EntityData>& visitor) const
+{
+	std::vector<CellEntry> cells;
+
+	findCells(searchArea.getMinX(),
+		searchArea.getMinY(),
+		searchArea.getMaxX(),
+		searchArea.getMaxY(),
+		true,
+		cells);
+
+	StopVisitor stopVisitor(visitor);
+
+	for (unsigned int i = 0; i < cells.size() && !stopVisitor.stopped(); i++)
+	{
+		cells[i]->second.m_tree->search(searchArea, stopVisitor);
+	}
+}
+
+//=============================================================================
+// Function: void search(const Line&,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Searches the tree of every cell whose loose bounds reach the box
+// around the line.
+// Parameters:
+// const Line& searchLine - The line to search along.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call. The
+// search stops as soon as it returns false.
+//=============================================================================
+void HashedQuadtree::search(const Line& searchLine,
+	ISpatialVisitor<EntityData>& visitor) const
+{
+	std::vector<CellEntry> cells;
+
+	float minX = 0.0f;
+	float minY = 0.0f;
+	float maxX = 0.0f;
+	float maxY = 0.0f;
+
+	fMin(minX, searchLine.m_start.m_x, searchLine.m_end.m_x);
+	fMin(minY, searchLine.m_start.m_y, searchLine.m_end.m_y);
+	fMax(maxX, searchLine.m_start.m_x, searchLine.m_end.m_x);
+	fMax(maxY, searchLine.m_start.m_y, searchLine.m_end.m_y);
+
+	findCells(minX, minY, maxX, maxY, true, cells);
+
+	StopVisitor stopVisitor(visitor);
+
+	for (unsigned int i = 0; i < cells.size() && !stopVisitor.stopped(); i++)
+	{
+		cells[i]->second.m_tree->search(searchLine, stopVisitor);
+	}
+}
+
+//=============================================================================
+// Function: void addEntity(const EntityData&)
+// Description:
+// Adds the entity to the cell holding its center, creating the cell
+// if it doesn't have one yet.
+// Parameters:
+// const EntityData& entity - The entity to add.
+//=============================================================================
+void HashedQuadtree::addEntity(const EntityData& entity)
+{
+	insertMember(getCellKey(entity.m_size), entity);
+}
+
+//=============================================================================
+// Function: void removeEntity(const EntityData&)
+// Description:
+// Removes the entity from its cell, freeing the cell if it empties.
+// Parameters:
+// const EntityData& entity - The entity to remove.
+//=============================================================================
+void HashedQuadtree::removeEntity(const EntityData& entity)
+{
+	eraseMember(entity.m_id);
+}
+
+//=============================================================================
+// Function: void moveEntity(const EntityData&, const Rectangle&)
+// Description:
+// Moves an entity to a new size. If it stays in the same cell it's
+// moved inside that cell's tree, otherwise it changes cells.
+// Parameters:
+// const EntityData& entity - The entity at its old size.
+// const Rectangle& size - The new size.
+//=============================================================================
+void HashedQuadtree::moveEntity(const EntityData& entity,
+	const Rectangle& size)
+{
+	auto lookup = m_locations.find(entity.m_id);
+
+	if (lookup != m_locations.end())
+	{
+		CellKey key = getCellKey(size);
+
+		if (key == lookup->second.m_cell)
+		{
+			HashedCell& cell = m_cells[key];
+			EntityData& member = cell.m_members[lookup->second.m_member];
+
+			member.m_flags = entity.m_flags;
+
+			cell.m_tree->moveEntity(member, size);
+			member.m_size = size;
+		}
+		else
+		{
+			eraseMember(entity.m_id);
+			insertMember(key, EntityData(entity.m_id, size, entity.m_flags));
+		}
+	}
+}
+
+//=============================================================================
+// Function: bool raycast(const Line&,
+// RaycastHit&,
+// const ISpatialFilter<EntityData>*) const
+// Description:
+// Finds the first entity the ray hits by casting it through the
+// tree of every cell whose loose bounds reach the box around it and
+// keeping the closest hit.
+// Parameters:
+// const Line& ray - The ray to cast, from its start to its end.
+// RaycastHit& hit - Set to the closest hit.
+// const ISpatialFilter<EntityData> *filter - Skips the entities it
+// doesn't accept. NULL accepts everything.
+// Output:
+// bool
+// Returns true if something was hit.
+//=============================================================================
+bool HashedQuadtree::raycast(const Line& ray,
+	RaycastHit& hit,
+	const ISpatialFilter<EntityData> *filter) const
+{
+	std::vector<CellEntry> cells;
+
+	float minX = 0.0f;
+	float minY = 0.0f;
+	float maxX = 0.0f;
+	float maxY = 0.0f;
+
+	fMin(minX, ray.m_start.m_x, ray.m_end.m_x);
+	fMin(minY, ray.m_start.m_y, ray.m_end.m_y);
+	fMax(maxX, ray.m_start.m_x, ray.m_end.m_x);
+	fMax(maxY, ray.m_start.m_y, ray.m_end.m_y);
+
+	findCells(minX, minY, maxX, maxY, true, cells);
+
+	bool found = false;
+
+	for (unsigned int i = 0; i < cells.size(); i++)
+	{
+		RaycastHit cellHit;
+
+		if (cells[i]->second.m_tree->raycast(ray, cellHit, filter) &&
+			(!found || cellHit.m_time < hit.m_time))
+		{
+			hit = cellHit;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+//=============================================================================
+// Function: void nearest(const Vector2D&,
+// const int,
+// vector<EntityData>&) const
+// Description:
+// Finds the entities whose centers are closest to the point. Every
+// center is inside its own cell, so the cells are tried from the
+// closest out and the rest are skipped once none of them can hold
+// anything closer than what's been kept.
+// Parameters:
+// const Vector2D& point - The point to search from.
+// const int count - The most entities to find.
+// vector<EntityData>& nearest - Filled with the entities, closest
+// first. It's cleared first.
+//=============================================================================
+void HashedQuadtree::nearest(const Vector2D& point,
+	const int count,
+	std::vector<EntityData>& nearest) const
+{
+	nearest.clear();
+
+	if (0 < count)
+	{
+		std::vector<std::pair<float, const HashedCell*>> cells;
+		std::vector<EntityData> found;
+
+		cells.reserve(m_cells.size());
+
+		for (auto cit = m_cells.begin(); cit != m_cells.end(); cit++)
+		{
+			const float size = getLevelSize(cit->first.m_level);
+
+			float x = 0.0f;
+			float y = 0.0f;
+
+			fMax(x, (cit->first.m_x * size) - point.m_x, point.m_x - ((cit->first.m_x + 1) * size));
+			fMax(y, (cit->first.m_y * size) - point.m_y, point.m_y - ((cit->first.m_y + 1) * size));
+			fMax(x, x, 0.0f);
+			fMax(y, y, 0.0f);
+
+			cells.emplace_back(std::make_pair((x * x) + (y * y), &cit->second));
+		}
+
+		std::sort(cells.begin(), cells.end(),
+			[](const std::pair<float, const HashedCell*>& a, const std::pair<float, const HashedCell*>& b)
+		{
+			return a.first < b.first;
+		});
+
+		for (unsigned int i = 0; i < cells.size() && canBeNearer(cells[i].first, point, count, nearest); i++)
+		{
+			cells[i].second->m_tree->nearest(point, count, found);
+
+			for (unsigned int j = 0; j < found.size(); j++)
+			{
+				keepNearest(found[j], point, count, nearest);
+			}
+		}
+
+		sortNearest(point, nearest);
+	}
+}
+
+//=============================================================================
+// Function: void withinRadius(const Vector2D&,
+// const float,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Visits every entity whose center is within the radius of the
+// point. Centers are always inside their own cell, so only the
+// cells the circle's box touches are searched.
+// Parameters:
+// const Vector2D& point - The center of the circle.
+// const float radius - The radius of the circle.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call. The
+// search stops as soon as it returns false.
+//=============================================================================
+void HashedQuadtree::withinRadius(const Vector2D& point,
+	const float radius,
+	ISpatialVisitor<EntityData>& visitor) const
+{
+	std::vector<CellEntry> cells;
+
+	findCells(point.m_x - radius,
+		point.m_y - radius,
+		point.m_x + radius,
+		point.m_y + radius,
+		false,
+		cells);
+
+	StopVisitor stopVisitor(visitor);
+
+	for (unsigned int i = 0; i < cells.size() && !stopVisitor.stopped(); i++)
+	{
+		cells[i]->second.m_tree->withinRadius(point, radius, stopVisitor);
+	}
+}
+
+//=============================================================================
+// Function: void forEachOverlappingPair(ISpatialPairVisitor<EntityData>&) const
+// Description:
+// Visits every pair of overlapping entities once. Each cell's tree
+// finds the pairs inside it, and the pairs split between two cells
+// are found by sweeping the entities near where the cells' loose
+// bounds meet. Each two cells are only paired up once.
+// Parameters:
+// ISpatialPairVisitor<EntityData>& visitor - The visitor to call.
+// The search stops as soon as it returns false.
+//=============================================================================
+void HashedQuadtree::forEachOverlappingPair(ISpatialPairVisitor<EntityData>& visitor) const
+{
+	StopPairVisitor stopVisitor(visitor);
+
+	std::vector<CellEntry> neighbors;
+
+	for (auto cit = m_cells.begin(); cit != m_cells.end(); cit++)
+	{
+		cit->second.m_tree->forEachOverlappingPair(stopVisitor);
+
+		if (stopVisitor.stopped())
+		{
+			return;
+		}
+
+		const Rectangle bounds = getCellBounds(cit->first);
+		const float half = getLevelSize(cit->first.m_level) / 2.0f;
+
+		findCells(bounds.getMinX() - half,
+			bounds.getMinY() - half,
+			bounds.getMaxX() + half,
+			bounds.getMaxY() + half,
+			true,
+			neighbors);
+
+		for (unsigned int i = 0; i < neighbors.size(); i++)
+		{
+			if (cit->first < neighbors[i]->first &&
+				!findCrossPairs(&*cit, neighbors[i], visitor))
+			{
+				return;
+			}
+		}
+	}
+}
+
+//=============================================================================
+// Function: ISpatialIndex<EntityData>* createSnapshot() const
+// Description:
+// Creates a read-only copy of the index.
+// Output:
+// ISpatialIndex<EntityData>*
+// Returns the snapshot. The caller owns it.
+//=============================================================================
+ISpatialIndex<EntityData>* HashedQuadtree::createSnapshot() const
+{
+	HashedQuadtree *snapshot = new HashedQuadtree(m_cellSize, m_maxObjects, m_maxLevels);
+
+	updateSnapshot(*snapshot);
+
+	return snapshot;
+}
+
+//=============================================================================
+// Function: void updateSnapshot(ISpatialIndex<EntityData>&) const
+// Description:
+// Copies the cells into a snapshot. Cells the snapshot already has
+// copy their trees through the trees' own snapshots, so they reuse
+// the snapshot's memory, and cells that have emptied since are
+// freed. The id lookup is left out since a snapshot is only ever
+// searched.
+// Parameters:
+// ISpatialIndex<EntityData>& snapshot - A snapshot from
+// createSnapshot.
+//=============================================================================
+void HashedQuadtree::updateSnapshot(ISpatialIndex<EntityData>& snapshot) const
+{
+	HashedQuadtree& index = static_cast<HashedQuadtree&>(snapshot);
+
+	for (auto cit = index.m_cells.begin(); cit != index.m_cells.end();)
+	{
+		if (m_cells.find(cit->first) == m_cells.end())
+		{
+			delete cit->second.m_tree;
+
+			cit = index.m_cells.erase(cit);
+		}
+		else
+		{
+			cit++;
+		}
+	}
+
+	for (auto cit = m_cells.begin(); cit != m_cells.end(); cit++)
+	{
+		HashedCell& cell = index.m_cells[cit->first];
+
+		if (cell.m_tree)
+		{
+			cit->second.m_tree->updateSnapshot(*cell.m_tree);
+		}
+		else
+		{
+			cell.m_tree = static_cast<Quadtree*>(cit->second.m_tree->createSnapshot());
+		}
+
+		cell.m_members = cit->second.m_members;
+	}
+
+	index.m_locations.clear();
+	index.m_levelCells = m_levelCells;
+}
+
+//=============================================================================
+// Function: void clear()
+// Description:
+// Removes every entity and frees every cell.
+//=============================================================================
+void HashedQuadtree::clear()
+{
+	for (auto cit = m_cells.begin(); cit != m_cells.end(); cit++)
+	{
+		delete cit->second.m_tree;
+	}
+
+	m_cells.clear();
+	m_locations.clear();
+	m_levelCells.clear();
+}
+
+//=============================================================================
+// Function: const float getLevelSize(const int) const
+// Description:
+// Gets the width and height of the cells on a level.
+// Parameters:
+// const int level - The level.
+// Output:
+// const float
+// Returns the cell size, doubling with each level.
+//=============================================================================
+const float HashedQuadtree::getLevelSize(const int level) const
+{
+	return (float)(m_cellSize << level);
+}
+
+//=============================================================================
+// Function: const CellKey getCellKey(const Rectangle&) const
+// Description:
+// Works out which cell an entity belongs in. Its level is the
+// lowest one whose cells are at least as wide and tall as it is, so
+// it stays inside the loose bounds of the cell holding its center.
+// Parameters:
+// const Rectangle& size - The entity's size.
+// Output:
+// const CellKey
+// Returns the cell's key.
+//=============================================================================
+const HashedQuadtree::CellKey HashedQuadtree::getCellKey(const Rectangle& size) const
+{
+	float extent = 0.0f;
+
+	fMax(extent, size.getMaxX() - size.getMinX(), size.getMaxY() - size.getMinY());
+
+	// Covers the corners rounding away from the center.
+	extent += 2.0f;
+
+	int level = 0;
+
+	while (getLevelSize(level) < extent && level < MAX_LEVEL)
+	{
+		level++;
+	}
+
+	const float cellSize = getLevelSize(level);
+	const Vector2D center = size.getCenter();
+
+	return CellKey(level,
+		(int)floor(center.m_x / cellSize),
+		(int)floor(center.m_y / cellSize));
+}
+
+//=============================================================================
+// Function: const Rectangle getCellBounds(const CellKey&) const
+// Description:
+// Gets the area a cell covers.
+// Parameters:
+// const CellKey& key - The cell's key.
+// Output:
+// const Rectangle
+// Returns the cell's bounds.
+//=============================================================================
+const Rectangle HashedQuadtree::getCellBounds(const CellKey& key) const
+{
+	const int cellSize = m_cellSize << key.m_level;
+	const float size = (float)cellSize;
+
+	return Rectangle(Vector2D((key.m_x * size) + (size / 2.0f), (key.m_y * size) + (size / 2.0f)),
+		cellSize,
+		cellSize);
+}
+
+//=============================================================================
+// Function: void insertMember(const CellKey&, const EntityData&)
+// Description:
+// Puts an entity in a cell, giving the cell a tree first if it's
+// new.
+// Parameters:
+// const CellKey& key - The cell to put the entity in.
+// const EntityData& entity - The entity.
+//=============================================================================
+void HashedQuadtree::insertMember(const CellKey& key,
+	const EntityData& entity)
+{
+	HashedCell& cell = m_cells[key];
+
+	if (!cell.m_tree)
+	{
+		cell.m_tree = new Quadtree(m_maxObjects, m_maxLevels, getCellBounds(key), Quadtree::LOOSE);
+
+		if ((int)m_levelCells.size() <= key.m_level)
+		{
+			m_levelCells.resize(key.m_level + 1, 0);
+		}
+
+		m_levelCells[key.m_level]++;
+	}
+
+	cell.m_tree->addEntity(entity);
+
+	m_locations.erase(entity.m_id);
+	m_locations.emplace(entity.m_id, EntityLocation(key, (int)cell.m_members.size()));
+
+	cell.m_members.emplace_back(entity);
+}
+
+//=============================================================================
+// Function: void eraseMember(const int)
+// Description:
+// Takes an entity out of its cell. The last member of the cell
+// fills its place, and the cell is freed if nothing is left.
+// Parameters:
+// const int id - The id of the entity.
+//=============================================================================
+void HashedQuadtree::eraseMember(const int id)
+{
+	auto lookup = m_locations.find(id);
+
+	if (lookup != m_locations.end())
+	{
+		CellKey key = lookup->second.m_cell;
+		int member = lookup->second.m_member;
+
+		m_locations.erase(lookup);
+
+		auto cit = m_cells.find(key);
+		HashedCell& cell = cit->second;
+
+		cell.m_tree->removeEntity(cell.m_members[member]);
+
+		if (member != (int)cell.m_members.size() - 1)
+		{
+			cell.m_members[member] = cell.m_members.back();
+			m_locations.find(cell.m_members[member].m_id)->second.m_member = member;
+		}
+
+		cell.m_members.pop_back();
+
+		if (cell.m_members.empty())
+		{
+			delete cell.m_tree;
+
+			m_cells.erase(cit);
+			m_levelCells[key.m_level]--;
+		}
+	}
+}
+
+//=============================================================================
+// Function: void findCells(const float,
+// const float,
+// const float,
+// const float,
+// const bool,
+// vector<CellEntry>&) const
+// Description:
+// Finds the cells on every level that reach an area. If there are
+// fewer cells on a level than the area covers, the level's cells
+// are checked directly instead of looking up every spot.
+// Parameters:
+// const float minX - The left of the area.
+// const float minY - The top of the area.
+// const float maxX - The right of the area.
+// const float maxY - The bottom of the area.
+// const bool loose - Whether to match the cells' loose bounds,
+// which reach half a cell past their edges, instead of the cells.
+// vector<CellEntry>& cells - Filled with the cells. It's cleared
+// first.
+//=============================================================================
+void HashedQuadtree::findCells(const float minX,
+	const float minY,
+	const float maxX,
+	const float maxY,
+	const bool loose,
+	std::vector<CellEntry>& cells) const
+{
+	cells.clear();
+
+	for (int level = 0; level < (int)m_levelCells.size(); level++)
+	{
+		if (0 < m_levelCells[level])
+		{
+			const float size = getLevelSize(level);
+
+			// A pixel more covers the corners rounding.
+			float reach = 1.0f;
+
+			if (loose)
+			{
+				reach += size / 2.0f;
+			}
+
+			const float firstX = floor((minX - reach) / size);
+			const float firstY = floor((minY - reach) / size);
+			const float lastX = floor((maxX + reach) / size);
+			const float lastY = floor((maxY + reach) / size);
+
+			const double spots = ((double)lastX - firstX + 1.0) * ((double)lastY - firstY + 1.0);
+
+			if ((double)m_levelCells[level] < spots)
+			{
+				for (auto cit = m_cells.begin(); cit != m_cells.end(); cit++)
+				{
+					const CellKey& key = cit->first;
+
+					if (key.m_level == level &&
+						firstX <= key.m_x && key.m_x <= lastX &&
+						firstY <= key.m_y && key.m_y <= lastY)
+					{
+						cells.emplace_back(&*cit);
+					}
+				}
+			}
+			else
+			{
+				for (int x = (int)firstX; x <= (int)lastX; x++)
+				{
+					for (int y = (int)firstY; y <= (int)lastY; y++)
+					{
+						auto cit = m_cells.find(CellKey(level, x, y));
+
+						if (cit != m_cells.end())
+						{
+							cells.emplace_back(&*cit);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+//=============================================================================
+// Function: const bool findCrossPairs(const CellEntry,
+// const CellEntry,
+// ISpatialPairVisitor<EntityData>&) const
+// Description:
+// Visits the overlapping pairs with one entity in each of two cells.
+// Only the entities that reach the other cell's loose bounds can
+// overlap anything in it, and those are swept along x so only pairs
+// that meet on x are checked.
+// Parameters:
+// const CellEntry first - The first cell.
+// const CellEntry second - The second cell.
+// ISpatialPairVisitor<EntityData>& visitor - The visitor to call.
+// Output:
+// const bool
+// Returns false if the visitor stopped the search.
+//=============================================================================
+const bool HashedQuadtree::findCrossPairs(const CellEntry first,
+	const CellEntry second,
+	ISpatialPairVisitor<EntityData>& visitor) const
+{
+	std::vector<StripEntry> firstStrip;
+	std::vector<StripEntry> secondStrip;
+
+	const Rectangle firstBounds = getCellBounds(first->first);
+	const Rectangle secondBounds = getCellBounds(second->first);
+
+	const float firstHalf = getLevelSize(first->first.m_level) / 2.0f;
+	const float secondHalf = getLevelSize(second->first.m_level) / 2.0f;
+
+	collectStrip(first->second,
+		secondBounds.getMinX() - secondHalf,
+		secondBounds.getMinY() - secondHalf,
+		secondBounds.getMaxX() + secondHalf,
+		secondBounds.getMaxY() + secondHalf,
+		firstStrip);
+
+	collectStrip(second->second,
+		firstBounds.getMinX() - firstHalf,
+		firstBounds.getMinY() - firstHalf,
+		firstBounds.getMaxX() + firstHalf,
+		firstBounds.getMaxY() + firstHalf,
+		secondStrip);
+
+	std::sort(firstStrip.begin(), firstStrip.end(), stripLess);
+	std::sort(secondStrip.begin(), secondStrip.end(), stripLess);
+
+	unsigned int i = 0;
+	unsigned int j = 0;
+
+	// Whichever entry starts first is checked against the entries on
+	// the other side that start before it ends. The padding matches
+	// pairOverlaps.
+	while (i < firstStrip.size() && j < secondStrip.size())
+	{
+		if (firstStrip[i].m_minX < secondStrip[j].m_minX)
+		{
+			for (unsigned int k = j; k < secondStrip.size() && secondStrip[k].m_minX <= firstStrip[i].m_maxX + 2.0f; k++)
+			{
+				if (pairOverlaps(*firstStrip[i].m_data, *secondStrip[k].m_data) &&
+					!visitor.visit(*firstStrip[i].m_data, *secondStrip[k].m_data))
+				{
+					return false;
+				}
+			}
+
+			i++;
+		}
+		else
+		{
+			for (unsigned int k = i; k < firstStrip.size() && firstStrip[k].m_minX <= secondStrip[j].m_maxX + 2.0f; k++)
+			{
+				if (pairOverlaps(*firstStrip[k].m_data, *secondStrip[j].m_data) &&
+					!visitor.visit(*firstStrip[k].m_data, *secondStrip[j].m_data))
+				{
+					return false;
+				}
+			}
+
+			j++;
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+// Function: void collectStrip(const HashedCell&,
+// const float,
+// const float,
+// const float,
+// const float,
+// vector<StripEntry>&)
+// Description:
+// Collects the members of a cell whose bounding boxes reach an area.
+// Parameters:
+// const HashedCell& cell - The cell.
+// const float minX - The left of the area.
+// const float minY - The top of the area.
+// const float maxX - The right of the area.
+// const float maxY - The bottom of the area.
+// vector<StripEntry>& strip - Filled with the members found.
+//=============================================================================
+void HashedQuadtree::collectStrip(const HashedCell& cell,
+	const float minX,
+	const float minY,
+	const float maxX,
+	const float maxY,
+	std::vector<StripEntry>& strip)
+{
+	for (unsigned int i = 0; i < cell.m_members.size(); i++)
+	{
+		const Rectangle& size = cell.m_members[i].m_size;
+
+		if (size.getMinX() - 2.0f <= maxX &&
+			minX <= size.getMaxX() + 2.0f &&
+			size.getMinY() - 2.0f <= maxY &&
+			minY <= size.getMaxY() + 2.0f)
+		{
+			strip.emplace_back(StripEntry(&cell.m_members[i]));
+		}
+	}
+}
+
+//=============================================================================
+// Function: bool stripLess(const StripEntry&, const StripEntry&)
+// Description:
+// Orders strip entries by their left edge.
+// Parameters:
+// const StripEntry& a - The first entry.
+// const StripEntry& b - The second entry.
+// Output:
+// bool
+// Returns true if a starts before b.
+//=============================================================================
+bool HashedQuadtree::stripLess(const StripEntry& a,
+	const StripEntry& b)
+{
+	return a.m_minX < b.m_minX;
+}
@@ -0,0 +1,266 @@
+#pragma once
+//==========================================================================================
+// File Name: HashedQuadtree.h
+// Author: Brian Blackmon
+// Date Created: 11/12/2019
+// Purpose:
+// A spatial index with no bounds. Space is cut into square cells
+// that are looked up by hash, and each cell only gets a loose quad
+// tree of its own once something is placed in it. An entity goes in
+// the cell holding its center, so it never needs a cell that
+// doesn't exist, and the cell's tree is freed again once it's
+// empty.
+// Cells come in levels, each twice the size of the one below. An
+// entity goes to the lowest level whose cells are at least as big
+// as it is, which keeps it inside its cell's loose bounds. Searches
+// only look at the levels that have cells.
+//==========================================================================================
+#include "ISpatialIndex.h"
+#include <climits>
+#include <vector>
+#include <unordered_map>
+
+class Quadtree;
+
+class HashedQuadtree : public ISpatialIndex<EntityData>
+{
+public:
+	HashedQuadtree(const int cellSize,
+		const int maxObjects,
+		const int maxLevels);
+	virtual ~HashedQuadtree();
+
+	const int getCellSize() const;
+	const int getCellCount() const;
+	const int getCount() const;
+
+	using ISpatialIndex<EntityData>::search;
+	using ISpatialIndex<EntityData>::withinRadius;
+
+	virtual void search(const Rectangle& searchArea,
+		ISpatialVisitor<EntityData>& visitor) const;
+	virtual void search(const Line& searchLine,
+		ISpatialVisitor<EntityData>& visitor) const;
+
+	virtual void addEntity(const EntityData& entity);
+	virtual void removeEntity(const EntityData& entity);
+	virtual void moveEntity(const EntityData& entity,
+		const Rectangle& size);
+
+	virtual bool raycast(const Line& ray,
+		RaycastHit& hit,
+		const ISpatialFilter<EntityData> *filter = NULL) const;
+
+	virtual void nearest(const Vector2D& point,
+		const int count,
+		std::vector<EntityData>& nearest) const;
+	virtual void withinRadius(const Vector2D& point,
+		const float radius,
+		ISpatialVisitor<EntityData>& visitor) const;
+
+	virtual void forEachOverlappingPair(ISpatialPairVisitor<EntityData>& visitor) const;
+
+	virtual ISpatialIndex<EntityData>* createSnapshot() const;
+	virtual void updateSnapshot(ISpatialIndex<EntityData>& snapshot) const;
+
+	virtual void clear();
+
+private:
+	// Cells stop doubling here.
+	static const int MAX_LEVEL = 15;
+
+	// The largest smallest cell, so a cell on the top level still fits
+	// in an int.
+	static const int MAX_CELL_SIZE = INT_MAX >> MAX_LEVEL;
+
+	struct CellKey
+	{
+		CellKey(const int level,
+			const int x,
+			const int y)
+			:m_level(level),
+			m_x(x),
+			m_y(y)
+		{
+
+		}
+
+		bool operator==(const CellKey& key) const
+		{
+			return m_level == key.m_level &&
+				m_x == key.m_x &&
+				m_y == key.m_y;
+		}
+
+		bool operator<(const CellKey& key) const
+		{
+			return m_level < key.m_level ||
+				(m_level == key.m_level && (m_x < key.m_x ||
+				(m_x == key.m_x && m_y < key.m_y)));
+		}
+
+		int m_level;
+		int m_x;
+		int m_y;
+	};
+
+	struct CellKeyHash
+	{
+		size_t operator()(const CellKey& key) const
+		{
+			unsigned long long hash = (unsigned int)key.m_x;
+
+			hash = (hash * 73856093ULL) ^ ((unsigned int)key.m_y * 19349663ULL);
+			hash = (hash * 83492791ULL) ^ (unsigned int)key.m_level;
+
+			return (size_t)hash;
+		}
+	};
+
+	struct HashedCell
+	{
+		HashedCell()
+			:m_tree(NULL)
+		{
+
+		}
+
+		Quadtree *m_tree;
+
+		// Every entity in the cell, so pairs across cells can be found
+		// without searching the tree.
+		std::vector<EntityData> m_members;
+	};
+
+	struct EntityLocation
+	{
+		EntityLocation(const CellKey& cell,
+			const int member)
+			:m_cell(cell),
+			m_member(member)
+		{
+
+		}
+
+		CellKey m_cell;
+
+		// Where the entity is in its cell's members.
+		int m_member;
+	};
+
+	// Passes entities on to another visitor and remembers if it asked
+	// to stop, since the cells' trees don't say.
+	class StopVisitor : public ISpatialVisitor<EntityData>
+	{
+	public:
+		StopVisitor(ISpatialVisitor<EntityData>& visitor)
+			:m_visitor(visitor),
+			m_stopped(false)
+		{
+
+		}
+
+		virtual bool visit(const EntityData& entity)
+		{
+			m_stopped = !m_visitor.visit(entity);
+
+			return !m_stopped;
+		}
+
+		bool stopped() const
+		{
+			return m_stopped;
+		}
+
+	private:
+		ISpatialVisitor<EntityData>& m_visitor;
+		bool m_stopped;
+	};
+
+	class StopPairVisitor : public ISpatialPairVisitor<EntityData>
+	{
+	public:
+		StopPairVisitor(ISpatialPairVisitor<EntityData>& visitor)
+			:m_visitor(visitor),
+			m_stopped(false)
+		{
+
+		}
+
+		virtual bool visit(const EntityData& first,
+			const EntityData& second)
+		{
+			m_stopped = !m_visitor.visit(first, second);
+
+			return !m_stopped;
+		}
+
+		bool stopped() const
+		{
+			return m_stopped;
+		}
+
+	private:
+		ISpatialPairVisitor<EntityData>& m_visitor;
+		bool m_stopped;
+	};
+
+	// An entity's extent along x, for sweeping the entities near the
+	// edge between two cells.
+	struct StripEntry
+	{
+		StripEntry(const EntityData *data)
+			:m_minX(data->m_size.getMinX()),
+			m_maxX(data->m_size.getMaxX()),
+			m_data(data)
+		{
+
+		}
+
+		float m_minX;
+		float m_maxX;
+		const EntityData *m_data;
+	};
+
+	typedef std::unordered_map<CellKey, HashedCell, CellKeyHash> CellMap;
+	typedef const CellMap::value_type* CellEntry;
+
+	CellMap m_cells;
+	std::unordered_map<int, EntityLocation> m_locations;
+
+	// How many cells each level has.
+	std::vector<int> m_levelCells;
+
+	int m_cellSize;
+	int m_maxObjects;
+	int m_maxLevels;
+
+	const float getLevelSize(const int level) const;
+	const CellKey getCellKey(const Rectangle& size) const;
+	const Rectangle getCellBounds(const CellKey& key) const;
+
+	void insertMember(const CellKey& key,
+		const EntityData& entity);
+	void eraseMember(const int id);
+
+	void findCells(const float minX,
+		const float minY,
+		const float maxX,
+		const float maxY,
+		const bool loose,
+		std::vector<CellEntry>& cells) const;
+
+	const bool findCrossPairs(const CellEntry first,
+		const CellEntry second,
+		ISpatialPairVisitor<EntityData>& visitor) const;
+
+	static void collectStrip(const HashedCell& cell,
+		const float minX,
+		const float minY,
+		const float maxX,
+		const float maxY,
+		std::vector<StripEntry>& strip);
+
+	static bool stripLess(const StripEntry& a,
+		const StripEntry& b);
+};
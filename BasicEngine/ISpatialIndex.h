@@ -0,0 +1,642 @@
+#pragma once
+//==========================================================================================
+// File Name: ISpatialIndex.h
+// Author: Brian Blackmon
+// Date Created: 11/4/2019
+// Purpose:
+// The interface shared by the spatial storage classes, so the
+// systems can swap between a Quadtree and a Grid at construction.
+//==========================================================================================
+#include "Rectangle.h"
+#include "Line.h"
+#include "Collision.h"
+#include <vector>
+#include <algorithm>
+
+class ThreadPool;
+
+struct EntityData
+{
+	EntityData(const int id,
+		const Rectangle& size,
+		const unsigned int flags = 0)
+		:m_id(id),
+		m_size(size),
+		m_flags(flags)
+	{
+
+	}
+
+	int m_id;
+	Rectangle m_size;
+
+	// Bits the owner can filter searches on without looking the
+	// entity up, like the layer of a sprite.
+	unsigned int m_flags;
+};
+
+struct RaycastHit
+{
+	RaycastHit()
+		:m_id(-1),
+		m_time(0.0f)
+	{
+
+	}
+
+	int m_id;
+
+	Vector2D m_point;
+	Vector2D m_normal;
+
+	// How far along the ray the hit is, from 0 at the start to 1 at
+	// the end.
+	float m_time;
+};
+
+template <class Data>
+class ISpatialVisitor
+{
+public:
+	ISpatialVisitor() {}
+	virtual ~ISpatialVisitor() {}
+
+	// Called for every entity found. Return false to stop the search.
+	virtual bool visit(const Data& entity) = 0;
+};
+
+template <class Data>
+class ISpatialFilter
+{
+public:
+	ISpatialFilter() {}
+	virtual ~ISpatialFilter() {}
+
+	// Return false to have the entity ignored.
+	virtual bool accept(const Data& entity) const = 0;
+};
+
+template <class Data>
+class ISpatialPairVisitor
+{
+public:
+	ISpatialPairVisitor() {}
+	virtual ~ISpatialPairVisitor() {}
+
+	// Called for every pair of entities that overlap. Return false to
+	// stop the search.
+	virtual bool visit(const Data& first,
+		const Data& second) = 0;
+};
+
+template <class Data>
+class ISpatialIndex
+{
+public:
+	ISpatialIndex() {}
+	virtual ~ISpatialIndex() {}
+
+	virtual void search(const Rectangle& searchArea,
+		ISpatialVisitor<Data>& visitor) const = 0;
+	virtual void search(const Line& searchLine,
+		ISpatialVisitor<Data>& visitor) const = 0;
+
+	virtual void addEntity(const Data& entity) = 0;
+	virtual void removeEntity(const Data& entity) = 0;
+
+	// Moves an entity from the size it was added with to the new size.
+	// The entity's flags replace the stored ones.
+	virtual void moveEntity(const Data& entity,
+		const Rectangle& size) = 0;
+
+	// Removes every entity.
+	virtual void clear() = 0;
+
+	// Fills the buffer with up to count entities whose centers are
+	// closest to the point, closest first. The buffer is cleared
+	// first, so reusing it avoids allocating.
+	virtual void nearest(const Vector2D& point,
+		const int count,
+		std::vector<Data>& nearest) const = 0;
+
+	// Visits every pair of overlapping entities once.
+	virtual void forEachOverlappingPair(ISpatialPairVisitor<Data>& visitor) const = 0;
+
+	//=============================================================================
+	// Function: void withinRadius(const Vector2D&,
+	// const float,
+	// ISpatialVisitor<Data>&) const
+	// Description:
+	// Visits every entity whose center is within the radius of the
+	// point. By default the square around the circle is searched and
+	// the centers are checked against the radius.
+	// Parameters:
+	// const Vector2D& point - The center of the circle.
+	// const float radius - The radius of the circle.
+	// ISpatialVisitor<Data>& visitor - The visitor to call. The search
+	// stops as soon as it returns false.
+	//=============================================================================
+	virtual void withinRadius(const Vector2D& point,
+		const float radius,
+		ISpatialVisitor<Data>& visitor) const
+	{
+		RadiusVisitor radiusVisitor(point, radius, visitor);
+
+		search(Rectangle(point, (int)(radius * 2.0f) + 2, (int)(radius * 2.0f) + 2), radiusVisitor);
+	}
+
+	//=============================================================================
+	// Function: void withinRadius(const Vector2D&,
+	// const float,
+	// vector<Data>&) const
+	// Description:
+	// Fills a caller owned buffer with the entities whose centers are
+	// within the radius of the point. The buffer is cleared first.
+	// Parameters:
+	// const Vector2D& point - The center of the circle.
+	// const float radius - The radius of the circle.
+	// vector<Data>& data - The buffer to fill.
+	//=============================================================================
+	void withinRadius(const Vector2D& point,
+		const float radius,
+		std::vector<Data>& data) const
+	{
+		DataCollector collector(data);
+
+		data.clear();
+		withinRadius(point, radius, collector);
+	}
+
+	//=============================================================================
+	// Function: bool raycast(const Line&,
+	// RaycastHit&,
+	// const ISpatialFilter<Data>*) const
+	// Description:
+	// Finds the first entity the ray hits. By default every entity
+	// on the line is checked, indexes that can walk the ray in order
+	// override this to stop early.
+	// Parameters:
+	// const Line& ray - The ray to cast, from its start to its end.
+	// RaycastHit& hit - Set to the closest hit.
+	// const ISpatialFilter<Data> *filter - Skips the entities it
+	// doesn't accept. NULL accepts everything.
+	// Output:
+	// bool
+	// Returns true if something was hit.
+	//=============================================================================
+	virtual bool raycast(const Line& ray,
+		RaycastHit& hit,
+		const ISpatialFilter<Data> *filter = NULL) const
+	{
+		RaycastVisitor visitor(ray, hit, filter);
+
+		search(ray, visitor);
+
+		return visitor.found();
+	}
+
+	//=============================================================================
+	// Function: void build(const vector<Data>&, ThreadPool*)
+	// Description:
+	// Replaces everything in the index with the entities. Indexes
+	// that can build faster from a full set of entities override
+	// this, by default they're just added one at a time.
+	// Parameters:
+	// const vector<Data>& entities - The entities to store.
+	// ThreadPool *pool - A pool to spread the work across, or NULL.
+	//=============================================================================
+	virtual void build(const std::vector<Data>& entities,
+		ThreadPool * /*pool*/ = NULL)
+	{
+		clear();
+
+		for (unsigned int i = 0; i < entities.size(); i++)
+		{
+			addEntity(entities[i]);
+		}
+	}
+
+	//=============================================================================
+	// Function: ISpatialIndex<Data>* createSnapshot() const
+	// Description:
+	// Creates a read-only copy of the index for other threads to
+	// search while this one changes. Indexes that can't be copied
+	// cheaply return NULL.
+	// Output:
+	// ISpatialIndex<Data>*
+	// On success - Returns the snapshot. The caller owns it.
+	// On failure - Returns NULL.
+	//=============================================================================
+	virtual ISpatialIndex<Data>* createSnapshot() const
+	{
+		return NULL;
+	}
+
+	//=============================================================================
+	// Function: void updateSnapshot(ISpatialIndex<Data>&) const
+	// Description:
+	// Copies the index into a snapshot it created earlier. Once the
+	// snapshot has grown to fit, this doesn't allocate.
+	// Parameters:
+	// ISpatialIndex<Data>& snapshot - A snapshot from createSnapshot.
+	//=============================================================================
+	virtual void updateSnapshot(ISpatialIndex<Data>& /*snapshot*/) const
+	{
+
+	}
+
+	//=============================================================================
+	// Function: vector<Data> search(const Rectangle&) const
+	// Description:
+	// Searches for all of the entities inside the area.
+	// Parameters:
+	// const Rectangle& searchArea - The area to search inside.
+	// Output:
+	// vector<Data>
+	// Returns a vector filled with the entities found.
+	//=============================================================================
+	std::vector<Data> search(const Rectangle& searchArea) const
+	{
+		std::vector<Data> data;
+
+		search(searchArea, data);
+
+		return data;
+	}
+
+	//=============================================================================
+	// Function: vector<Data> search(const Line&) const
+	// Description:
+	// Searches for all of the entities the line touches.
+	// Parameters:
+	// const Line& searchLine - The line to search along.
+	// Output:
+	// vector<Data>
+	// Returns a vector filled with the entities found.
+	//=============================================================================
+	std::vector<Data> search(const Line& searchLine) const
+	{
+		std::vector<Data> data;
+
+		search(searchLine, data);
+
+		return data;
+	}
+
+	//=============================================================================
+	// Function: void search(const Rectangle&, vector<Data>&) const
+	// Description:
+	// Fills a caller owned buffer with the entities inside the area.
+	// The buffer is cleared first, so reusing it between searches
+	// keeps its memory and avoids allocating.
+	// Parameters:
+	// const Rectangle& searchArea - The area to search inside.
+	// vector<Data>& data - The buffer to fill.
+	//=============================================================================
+	void search(const Rectangle& searchArea,
+		std::vector<Data>& data) const
+	{
+		DataCollector collector(data);
+
+		data.clear();
+		search(searchArea, collector);
+	}
+
+	//=============================================================================
+	// Function: void search(const Line&, vector<Data>&) const
+	// Description:
+	// Fills a caller owned buffer with the entities the line touches.
+	// The buffer is cleared first.
+	// Parameters:
+	// const Line& searchLine - The line to search along.
+	// vector<Data>& data - The buffer to fill.
+	//=============================================================================
+	void search(const Line& searchLine,
+		std::vector<Data>& data) const
+	{
+		DataCollector collector(data);
+
+		data.clear();
+		search(searchLine, collector);
+	}
+
+	//=============================================================================
+	// Function: void searchIDs(const Rectangle&, vector<int>&) const
+	// Description:
+	// Fills a caller owned buffer with only the ids of the entities
+	// inside the area, skipping the copy of their sizes.
+	// Parameters:
+	// const Rectangle& searchArea - The area to search inside.
+	// vector<int>& ids - The buffer to fill.
+	//=============================================================================
+	void searchIDs(const Rectangle& searchArea,
+		std::vector<int>& ids) const
+	{
+		IDCollector collector(ids);
+
+		ids.clear();
+		search(searchArea, collector);
+	}
+
+	//=============================================================================
+	// Function: void searchIDs(const Line&, vector<int>&) const
+	// Description:
+	// Fills a caller owned buffer with only the ids of the entities
+	// the line touches.
+	// Parameters:
+	// const Line& searchLine - The line to search along.
+	// vector<int>& ids - The buffer to fill.
+	//=============================================================================
+	void searchIDs(const Line& searchLine,
+		std::vector<int>& ids) const
+	{
+		IDCollector collector(ids);
+
+		ids.clear();
+		search(searchLine, collector);
+	}
+
+protected:
+	//=============================================================================
+	// Function: const bool pairOverlaps(const Data&, const Data&)
+	// Description:
+	// Checks if two entities overlap. Their bounding boxes are
+	// compared first so most pairs skip the exact test, padded by a
+	// pixel since the corners are rounded. The exact test is tried
+	// both ways around, the same as searching with either entity
+	// would.
+	// Parameters:
+	// const Data& first - The first entity.
+	// const Data& second - The second entity.
+	// Output:
+	// const bool
+	// Returns true if the entities overlap.
+	//=============================================================================
+	static const bool pairOverlaps(const Data& first,
+		const Data& second)
+	{
+		const Rectangle& a = first.m_size;
+		const Rectangle& b = second.m_size;
+
+		return a.getMinX() <= b.getMaxX() + 2.0f &&
+			b.getMinX() <= a.getMaxX() + 2.0f &&
+			a.getMinY() <= b.getMaxY() + 2.0f &&
+			b.getMinY() <= a.getMaxY() + 2.0f &&
+			(rectIntersectRect(a, b) || rectIntersectRect(b, a));
+	}
+
+	//=============================================================================
+	// Function: void checkRayHit(const Data&,
+	// const Line&,
+	// const ISpatialFilter<Data>*,
+	// RaycastHit&,
+	// bool&)
+	// Description:
+	// Casts the ray at an entity and keeps the hit if it's closer
+	// than the one found so far.
+	// Parameters:
+	// const Data& entity - The entity to check.
+	// const Line& ray - The ray being cast.
+	// const ISpatialFilter<Data> *filter - The filter, or NULL.
+	// RaycastHit& hit - The closest hit so far.
+	// bool& found - Whether anything has been hit so far.
+	//=============================================================================
+	static void checkRayHit(const Data& entity,
+		const Line& ray,
+		const ISpatialFilter<Data> *filter,
+		RaycastHit& hit,
+		bool& found)
+	{
+		float time = 0.0f;
+		Vector2D normal;
+
+		if ((!filter || filter->accept(entity)) &&
+			rayIntersectRect(entity.m_size, ray, time, normal) &&
+			(!found || time < hit.m_time))
+		{
+			hit.m_id = entity.m_id;
+			hit.m_time = time;
+			hit.m_normal = normal;
+			hit.m_point = ray.m_start + ((ray.m_end - ray.m_start) * Vector2D(time, time));
+
+			found = true;
+		}
+	}
+
+	//=============================================================================
+	// Function: float centerDistance(const Data&, const Vector2D&)
+	// Description:
+	// Gets the squared distance from a point to an entity's center.
+	// Parameters:
+	// const Data& entity - The entity to measure to.
+	// const Vector2D& point - The point to measure from.
+	// Output:
+	// float
+	// Returns the squared distance.
+	//=============================================================================
+	static float centerDistance(const Data& entity,
+		const Vector2D& point)
+	{
+		const Vector2D& center = entity.m_size.getCenter();
+
+		float x = center.m_x - point.m_x;
+		float y = center.m_y - point.m_y;
+
+		return (x * x) + (y * y);
+	}
+
+	//=============================================================================
+	// Function: void keepNearest(const Data&,
+	// const Vector2D&,
+	// const int,
+	// vector<Data>&)
+	// Description:
+	// Offers an entity to a nearest search. While the search runs the
+	// buffer is a heap with the farthest entity kept on top, so it's
+	// the one replaced when something closer comes along.
+	// Parameters:
+	// const Data& entity - The entity to offer.
+	// const Vector2D& point - The point being searched from.
+	// const int count - The most entities to keep.
+	// vector<Data>& nearest - The heap of entities kept so far.
+	//=============================================================================
+	static void keepNearest(const Data& entity,
+		const Vector2D& point,
+		const int count,
+		std::vector<Data>& nearest)
+	{
+		NearestOrder order(point);
+
+		if ((int)nearest.size() < count)
+		{
+			nearest.emplace_back(entity);
+			std::push_heap(nearest.begin(), nearest.end(), order);
+		}
+		else if (centerDistance(entity, point) < centerDistance(nearest.front(), point))
+		{
+			std::pop_heap(nearest.begin(), nearest.end(), order);
+			nearest.back() = entity;
+			std::push_heap(nearest.begin(), nearest.end(), order);
+		}
+	}
+
+	//=============================================================================
+	// Function: const bool canBeNearer(const float,
+	// const Vector2D&,
+	// const int,
+	// const vector<Data>&)
+	// Description:
+	// Checks if something at the squared distance could still make it
+	// into a nearest search.
+	// Parameters:
+	// const float distance - The squared distance to check.
+	// const Vector2D& point - The point being searched from.
+	// const int count - The most entities to keep.
+	// const vector<Data>& nearest - The heap of entities kept so far.
+	// Output:
+	// const bool
+	// Returns true if the heap isn't full or the distance is closer
+	// than the farthest entity in it.
+	//=============================================================================
+	static const bool canBeNearer(const float distance,
+		const Vector2D& point,
+		const int count,
+		const std::vector<Data>& nearest)
+	{
+		return (int)nearest.size() < count ||
+			distance < centerDistance(nearest.front(), point);
+	}
+
+	//=============================================================================
+	// Function: void sortNearest(const Vector2D&, vector<Data>&)
+	// Description:
+	// Turns the heap from a finished nearest search into a list
+	// sorted from closest to farthest.
+	// Parameters:
+	// const Vector2D& point - The point that was searched from.
+	// vector<Data>& nearest - The heap to sort.
+	//=============================================================================
+	static void sortNearest(const Vector2D& point,
+		std::vector<Data>& nearest)
+	{
+		std::sort_heap(nearest.begin(), nearest.end(), NearestOrder(point));
+	}
+
+	// Adds the id of every entity it visits to a buffer.
+	class IDCollector : public ISpatialVisitor<Data>
+	{
+	public:
+		IDCollector(std::vector<int>& ids)
+			:m_ids(ids)
+		{
+
+		}
+
+		virtual bool visit(const Data& entity)
+		{
+			m_ids.emplace_back(entity.m_id);
+
+			return true;
+		}
+
+	private:
+		std::vector<int>& m_ids;
+	};
+
+private:
+	class NearestOrder
+	{
+	public:
+		NearestOrder(const Vector2D& point)
+			:m_point(point)
+		{
+
+		}
+
+		bool operator()(const Data& a, const Data& b) const
+		{
+			return centerDistance(a, m_point) < centerDistance(b, m_point);
+		}
+
+	private:
+		Vector2D m_point;
+	};
+
+	class RadiusVisitor : public ISpatialVisitor<Data>
+	{
+	public:
+		RadiusVisitor(const Vector2D& point,
+			const float radius,
+			ISpatialVisitor<Data>& visitor)
+			:m_point(point),
+			m_radiusSquared(radius * radius),
+			m_visitor(visitor)
+		{
+
+		}
+
+		virtual bool visit(const Data& entity)
+		{
+			return m_radiusSquared < centerDistance(entity, m_point) ||
+				m_visitor.visit(entity);
+		}
+
+	private:
+		Vector2D m_point;
+		float m_radiusSquared;
+		ISpatialVisitor<Data>& m_visitor;
+	};
+
+	class RaycastVisitor : public ISpatialVisitor<Data>
+	{
+	public:
+		RaycastVisitor(const Line& ray,
+			RaycastHit& hit,
+			const ISpatialFilter<Data> *filter)
+			:m_ray(ray),
+			m_hit(hit),
+			m_filter(filter),
+			m_found(false)
+		{
+
+		}
+
+		virtual bool visit(const Data& entity)
+		{
+			checkRayHit(entity, m_ray, m_filter, m_hit, m_found);
+
+			return true;
+		}
+
+		bool found() const
+		{
+			return m_found;
+		}
+
+	private:
+		const Line& m_ray;
+		RaycastHit& m_hit;
+		const ISpatialFilter<Data> *m_filter;
+		bool m_found;
+	};
+
+	class DataCollector : public ISpatialVisitor<Data>
+	{
+	public:
+		DataCollector(std::vector<Data>& data)
+			:m_data(data)
+		{
+
+		}
+
+		virtual bool visit(const Data& entity)
+		{
+			m_data.emplace_back(entity);
+
+			return true;
+		}
+
+	private:
+		std::vector<Data>& m_data;
+	};
+};
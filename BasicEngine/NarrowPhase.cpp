@@ -0,0 +1,505 @@
+#include "NarrowPhase.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define NARROWPHASE_X86
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define NARROWPHASE_AVX2_TARGET
+#else
+#define NARROWPHASE_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define NARROWPHASE_SSE2
+#include <emmintrin.h>
+#endif
+
+// The arrays a kernel reads and writes, so they don't all have to be
+// passed one at a time.
+struct PairArrays
+{
+	const float *m_firstMinX;
+	const float *m_firstMinY;
+	const float *m_firstMaxX;
+	const float *m_firstMaxY;
+
+	const float *m_secondMinX;
+	const float *m_secondMinY;
+	const float *m_secondMaxX;
+	const float *m_secondMaxY;
+
+	unsigned char *m_overlaps;
+	float *m_penetrationX;
+	float *m_penetrationY;
+};
+
+//=============================================================================
+// Function: void add(const Rectangle&)
+// Description:
+// Adds a box to the end of the arrays. Unrotated rectangles use their
+// rounded corners, the same ones rectIntersectRect checks.
+// Parameters:
+// const Rectangle& box - The box to add.
+//=============================================================================
+void BoxArrays::add(const Rectangle& box)
+{
+	if (box.getRotation() == 0.0f)
+	{
+		Vector2D topLeft = box.getTopLeft();
+		Vector2D bottomRight = box.getBottomRight();
+
+		m_minX.push_back(topLeft.m_x);
+		m_minY.push_back(topLeft.m_y);
+		m_maxX.push_back(bottomRight.m_x);
+		m_maxY.push_back(bottomRight.m_y);
+	}
+	else
+	{
+		m_minX.push_back(box.getMinX());
+		m_minY.push_back(box.getMinY());
+		m_maxX.push_back(box.getMaxX());
+		m_maxY.push_back(box.getMaxY());
+	}
+}
+
+//=============================================================================
+// Function: void clear()
+// Description:
+// Removes every box, keeping the memory for the next batch.
+//=============================================================================
+void BoxArrays::clear()
+{
+	m_minX.clear();
+	m_minY.clear();
+	m_maxX.clear();
+	m_maxY.clear();
+}
+
+//=============================================================================
+// Function: const int size() const
+// Description:
+// Gets how many boxes there are.
+// Output:
+// const int
+// Returns the box count.
+//=============================================================================
+const int BoxArrays::size() const
+{
+	return (int)m_minX.size();
+}
+
+//=============================================================================
+// Function: void overlapScalar(const PairArrays&, const int, const int)
+// Description:
+// Checks pairs one at a time. A pair overlaps unless there's a gap
+// between them on either axis. The first box can leave along either
+// direction of either axis, and the shortest of the four is kept.
+// Ties go to y over x, left over right and down over up, which is
+// the order the separating axis test tries them in. Every other
+// kernel has to give exactly these answers.
+// Parameters:
+// const PairArrays& pairs - The boxes and where the answers go.
+// const int begin - The first pair to check.
+// const int end - One past the last pair to check.
+//=============================================================================
+static void overlapScalar(const PairArrays& pairs,
+	const int begin,
+	const int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		float firstMinX = pairs.m_firstMinX[i];
+		float firstMinY = pairs.m_firstMinY[i];
+		float firstMaxX = pairs.m_firstMaxX[i];
+		float firstMaxY = pairs.m_firstMaxY[i];
+
+		float secondMinX = pairs.m_secondMinX[i];
+		float secondMinY = pairs.m_secondMinY[i];
+		float secondMaxX = pairs.m_secondMaxX[i];
+		float secondMaxY = pairs.m_secondMaxY[i];
+
+		bool overlaps = !(firstMaxX < secondMinX ||
+			secondMaxX < firstMinX ||
+			firstMaxY < secondMinY ||
+			secondMaxY < firstMinY);
+
+		float penetrationX = 0.0f;
+		float penetrationY = 0.0f;
+
+		if (overlaps)
+		{
+			float pushRight = secondMaxX - firstMinX;
+			float pushLeft = firstMaxX - secondMinX;
+			float pushDown = secondMaxY - firstMinY;
+			float pushUp = firstMaxY - secondMinY;
+
+			float moveX = pushRight;
+			float depthX = pushRight;
+
+			if (pushLeft <= pushRight)
+			{
+				moveX = 0.0f - pushLeft;
+				depthX = pushLeft;
+			}
+
+			float moveY = pushDown;
+			float depthY = pushDown;
+
+			if (pushUp < pushDown)
+			{
+				moveY = 0.0f - pushUp;
+				depthY = pushUp;
+			}
+
+			if (depthX < depthY)
+			{
+				penetrationX = moveX;
+			}
+			else
+			{
+				penetrationY = moveY;
+			}
+		}
+
+		pairs.m_overlaps[i] = overlaps ? 1 : 0;
+		pairs.m_penetrationX[i] = penetrationX;
+		pairs.m_penetrationY[i] = penetrationY;
+	}
+}
+
+#ifdef NARROWPHASE_SSE2
+//=============================================================================
+// Function: void overlapSSE2(const PairArrays&, const int, const int)
+// Description:
+// Checks pairs four at a time with the same steps as overlapScalar,
+// using masks in place of the branches. The pairs that don't fill a
+// whole group are left to overlapScalar.
+// Parameters:
+// const PairArrays& pairs - The boxes and where the answers go.
+// const int begin - The first pair to check.
+// const int end - One past the last pair to check.
+//=============================================================================
+static void overlapSSE2(const PairArrays& pairs,
+	const int begin,
+	const int end)
+{
+	const int LANES = 4;
+
+	const __m128 zero = _mm_setzero_ps();
+
+	int i = begin;
+
+	for (; i + LANES <= end; i += LANES)
+	{
+		__m128 firstMinX = _mm_loadu_ps(pairs.m_firstMinX + i);
+		__m128 firstMinY = _mm_loadu_ps(pairs.m_firstMinY + i);
+		__m128 firstMaxX = _mm_loadu_ps(pairs.m_firstMaxX + i);
+		__m128 firstMaxY = _mm_loadu_ps(pairs.m_firstMaxY + i);
+
+		__m128 secondMinX = _mm_loadu_ps(pairs.m_secondMinX + i);
+		__m128 secondMinY = _mm_loadu_ps(pairs.m_secondMinY + i);
+		__m128 secondMaxX = _mm_loadu_ps(pairs.m_secondMaxX + i);
+		__m128 secondMaxY = _mm_loadu_ps(pairs.m_secondMaxY + i);
+
+		__m128 apart = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(firstMaxX, secondMinX),
+			_mm_cmplt_ps(secondMaxX, firstMinX)),
+			_mm_or_ps(_mm_cmplt_ps(firstMaxY, secondMinY),
+			_mm_cmplt_ps(secondMaxY, firstMinY)));
+
+		__m128 pushRight = _mm_sub_ps(secondMaxX, firstMinX);
+		__m128 pushLeft = _mm_sub_ps(firstMaxX, secondMinX);
+		__m128 pushDown = _mm_sub_ps(secondMaxY, firstMinY);
+		__m128 pushUp = _mm_sub_ps(firstMaxY, secondMinY);
+
+		__m128 useLeft = _mm_cmple_ps(pushLeft, pushRight);
+		__m128 moveX = _mm_or_ps(_mm_and_ps(useLeft, _mm_sub_ps(zero, pushLeft)),
+			_mm_andnot_ps(useLeft, pushRight));
+		__m128 depthX = _mm_or_ps(_mm_and_ps(useLeft, pushLeft),
+			_mm_andnot_ps(useLeft, pushRight));
+
+		__m128 useUp = _mm_cmplt_ps(pushUp, pushDown);
+		__m128 moveY = _mm_or_ps(_mm_and_ps(useUp, _mm_sub_ps(zero, pushUp)),
+			_mm_andnot_ps(useUp, pushDown));
+		__m128 depthY = _mm_or_ps(_mm_and_ps(useUp, pushUp),
+			_mm_andnot_ps(useUp, pushDown));
+
+		__m128 useX = _mm_cmplt_ps(depthX, depthY);
+
+		_mm_storeu_ps(pairs.m_penetrationX + i,
+			_mm_andnot_ps(apart, _mm_and_ps(useX, moveX)));
+		_mm_storeu_ps(pairs.m_penetrationY + i,
+			_mm_andnot_ps(apart, _mm_andnot_ps(useX, moveY)));
+
+		int apartBits = _mm_movemask_ps(apart);
+
+		for (int lane = 0; lane < LANES; lane++)
+		{
+			pairs.m_overlaps[i + lane] = ((apartBits >> lane) & 1) ? 0 : 1;
+		}
+	}
+
+	overlapScalar(pairs, i, end);
+}
+#endif
+
+#ifdef NARROWPHASE_X86
+//=============================================================================
+// Function: void overlapAVX2(const PairArrays&, const int, const int)
+// Description:
+// Checks pairs eight at a time, the same way as overlapSSE2. Only
+// called once the processor is known to support AVX2.
+// Parameters:
+// const PairArrays& pairs - The boxes and where the answers go.
+// const int begin - The first pair to check.
+// const int end - One past the last pair to check.
+//=============================================================================
+NARROWPHASE_AVX2_TARGET
+static void overlapAVX2(const PairArrays& pairs,
+	const int begin,
+	const int end)
+{
+	const int LANES = 8;
+
+	const __m256 zero = _mm256_setzero_ps();
+
+	int i = begin;
+
+	for (; i + LANES <= end; i += LANES)
+	{
+		__m256 firstMinX = _mm256_loadu_ps(pairs.m_firstMinX + i);
+		__m256 firstMinY = _mm256_loadu_ps(pairs.m_firstMinY + i);
+		__m256 firstMaxX = _mm256_loadu_ps(pairs.m_firstMaxX + i);
+		__m256 firstMaxY = _mm256_loadu_ps(pairs.m_firstMaxY + i);
+
+		__m256 secondMinX = _mm256_loadu_ps(pairs.m_secondMinX + i);
+		__m256 secondMinY = _mm256_loadu_ps(pairs.m_secondMinY + i);
+		__m256 secondMaxX = _mm256_loadu_ps(pairs.m_secondMaxX + i);
+		__m256 secondMaxY = _mm256_loadu_ps(pairs.m_secondMaxY + i);
+
+		__m256 apart = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(firstMaxX, secondMinX, _CMP_LT_OQ),
+			_mm256_cmp_ps(secondMaxX, firstMinX, _CMP_LT_OQ)),
+			_mm256_or_ps(_mm256_cmp_ps(firstMaxY, secondMinY, _CMP_LT_OQ),
+			_mm256_cmp_ps(secondMaxY, firstMinY, _CMP_LT_OQ)));
+
+		__m256 pushRight = _mm256_sub_ps(secondMaxX, firstMinX);
+		__m256 pushLeft = _mm256_sub_ps(firstMaxX, secondMinX);
+		__m256 pushDown = _mm256_sub_ps(secondMaxY, firstMinY);
+		__m256 pushUp = _mm256_sub_ps(firstMaxY, secondMinY);
+
+		__m256 useLeft = _mm256_cmp_ps(pushLeft, pushRight, _CMP_LE_OQ);
+		__m256 moveX = _mm256_blendv_ps(pushRight, _mm256_sub_ps(zero, pushLeft), useLeft);
+		__m256 depthX = _mm256_blendv_ps(pushRight, pushLeft, useLeft);
+
+		__m256 useUp = _mm256_cmp_ps(pushUp, pushDown, _CMP_LT_OQ);
+		__m256 moveY = _mm256_blendv_ps(pushDown, _mm256_sub_ps(zero, pushUp), useUp);
+		__m256 depthY = _mm256_blendv_ps(pushDown, pushUp, useUp);
+
+		__m256 useX = _mm256_cmp_ps(depthX, depthY, _CMP_LT_OQ);
+
+		_mm256_storeu_ps(pairs.m_penetrationX + i,
+			_mm256_andnot_ps(apart, _mm256_and_ps(useX, moveX)));
+		_mm256_storeu_ps(pairs.m_penetrationY + i,
+			_mm256_andnot_ps(apart, _mm256_andnot_ps(useX, moveY)));
+
+		int apartBits = _mm256_movemask_ps(apart);
+
+		for (int lane = 0; lane < LANES; lane++)
+		{
+			pairs.m_overlaps[i + lane] = ((apartBits >> lane) & 1) ? 0 : 1;
+		}
+	}
+
+	overlapScalar(pairs, i, end);
+}
+
+//=============================================================================
+// Function: bool supportsAVX2()
+// Description:
+// Checks that both the processor and the operating system support
+// AVX2. The operating system has to save the wider registers when
+// switching threads, or they can't be used.
+// Output:
+// bool
+// Returns true if AVX2 can be used.
+//=============================================================================
+static bool supportsAVX2()
+{
+#ifdef _MSC_VER
+	int info[4];
+
+	__cpuid(info, 0);
+
+	if (info[0] < 7)
+	{
+		return false;
+	}
+
+	__cpuid(info, 1);
+
+	const int OSXSAVE = 1 << 27;
+	const int AVX = 1 << 28;
+
+	if ((info[2] & (OSXSAVE | AVX)) != (OSXSAVE | AVX) ||
+		(_xgetbv(0) & 6) != 6)
+	{
+		return false;
+	}
+
+	__cpuidex(info, 7, 0);
+
+	const int AVX2 = 1 << 5;
+
+	return (info[1] & AVX2) != 0;
+#else
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+//=============================================================================
+// Function: NarrowPhaseKernel findBestKernel()
+// Description:
+// Works out the fastest kernel this processor can run.
+// Output:
+// NarrowPhaseKernel
+// Returns the kernel to use.
+//=============================================================================
+static NarrowPhaseKernel findBestKernel()
+{
+	NarrowPhaseKernel kernel = KERNEL_SCALAR;
+
+#ifdef NARROWPHASE_SSE2
+	kernel = KERNEL_SSE2;
+#endif
+
+#ifdef NARROWPHASE_X86
+	if (supportsAVX2())
+	{
+		kernel = KERNEL_AVX2;
+	}
+#endif
+
+	return kernel;
+}
+
+//=============================================================================
+// Function: const NarrowPhaseKernel getBestKernel()
+// Description:
+// Gets the fastest kernel this processor can run. It's only worked
+// out the first time.
+// Output:
+// const NarrowPhaseKernel
+// Returns the kernel overlapBoxPairs uses.
+//=============================================================================
+const NarrowPhaseKernel getBestKernel()
+{
+	static const NarrowPhaseKernel best = findBestKernel();
+
+	return best;
+}
+
+//=============================================================================
+// Function: void overlapBoxPairs(const BoxArrays&,
+// const BoxArrays&,
+// BoxPairResults&)
+// Description:
+// Checks every pair of boxes with the fastest kernel there is. Pair
+// i is the first box i against the second box i.
+// Parameters:
+// const BoxArrays& first - The boxes to move out.
+// const BoxArrays& second - The boxes they're checked against.
+// BoxPairResults& results - Set to the answer for every pair.
+//=============================================================================
+void overlapBoxPairs(const BoxArrays& first,
+	const BoxArrays& second,
+	BoxPairResults& results)
+{
+	overlapBoxPairs(first, second, results, getBestKernel());
+}
+
+//=============================================================================
+// Function: void overlapBoxPairs(const BoxArrays&,
+// const BoxArrays&,
+// BoxPairResults&,
+// const NarrowPhaseKernel)
+// Description:
+// Checks every pair of boxes with a chosen kernel, so the kernels can
+// be checked against each other. A kernel the processor can't run
+// falls back to the plain loop. If one array is longer, its extra
+// boxes are left out.
+// Parameters:
+// const BoxArrays& first - The boxes to move out.
+// const BoxArrays& second - The boxes they're checked against.
+// BoxPairResults& results - Set to the answer for every pair.
+// const NarrowPhaseKernel kernel - The kernel to use.
+//=============================================================================
+void overlapBoxPairs(const BoxArrays& first,
+	const BoxArrays& second,
+	BoxPairResults& results,
+	const NarrowPhaseKernel kernel)
+{
+	int count = first.size();
+
+	if (second.size() < count)
+	{
+		count = second.size();
+	}
+
+	results.m_overlaps.resize(count);
+	results.m_penetrationX.resize(count);
+	results.m_penetrationY.resize(count);
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	PairArrays pairs;
+
+	pairs.m_firstMinX = first.m_minX.data();
+	pairs.m_firstMinY = first.m_minY.data();
+	pairs.m_firstMaxX = first.m_maxX.data();
+	pairs.m_firstMaxY = first.m_maxY.data();
+
+	pairs.m_secondMinX = second.m_minX.data();
+	pairs.m_secondMinY = second.m_minY.data();
+	pairs.m_secondMaxX = second.m_maxX.data();
+	pairs.m_secondMaxY = second.m_maxY.data();
+
+	pairs.m_overlaps = results.m_overlaps.data();
+	pairs.m_penetrationX = results.m_penetrationX.data();
+	pairs.m_penetrationY = results.m_penetrationY.data();
+
+	NarrowPhaseKernel used = kernel;
+
+	if (getBestKernel() < used)
+	{
+		used = KERNEL_SCALAR;
+	}
+
+	switch (used)
+	{
+#ifdef NARROWPHASE_X86
+	case KERNEL_AVX2:
+	{
+		overlapAVX2(pairs, 0, count);
+		break;
+	}
+#endif
+#ifdef NARROWPHASE_SSE2
+	case KERNEL_SSE2:
+	{
+		overlapSSE2(pairs, 0, count);
+		break;
+	}
+#endif
+	default:
+	{
+		overlapScalar(pairs, 0, count);
+		break;
+	}
+	}
+}
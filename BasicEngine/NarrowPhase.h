@@ -0,0 +1,59 @@
+#pragma once
+//==========================================================================================
+// File Name: NarrowPhase.h
+// Author: Brian Blackmon
+// Date Created: 11/13/2019
+// Purpose:
+// Checks many pairs of axis aligned boxes at once. The boxes are
+// kept as one array per side, so four or eight pairs can be loaded
+// and checked together with SSE2 or AVX2. Which kernel runs is
+// picked once, from what the processor supports, and the plain loop
+// the others have to match is always there to fall back on.
+// Each pair gets the same answers rectIntersectRect and
+// overlapAmount give for unrotated rectangles. Rotated rectangles
+// are checked as the box around their corners.
+//==========================================================================================
+#include "Rectangle.h"
+#include <vector>
+
+enum NarrowPhaseKernel
+{
+	KERNEL_SCALAR,
+	KERNEL_SSE2,
+	KERNEL_AVX2
+};
+
+struct BoxArrays
+{
+	void add(const Rectangle& box);
+	void clear();
+
+	const int size() const;
+
+	std::vector<float> m_minX;
+	std::vector<float> m_minY;
+	std::vector<float> m_maxX;
+	std::vector<float> m_maxY;
+};
+
+struct BoxPairResults
+{
+	// 1 for each pair that overlaps or touches, 0 otherwise.
+	std::vector<unsigned char> m_overlaps;
+
+	// The smallest move that takes the first box of each pair out of
+	// the second. 0 for pairs that don't overlap.
+	std::vector<float> m_penetrationX;
+	std::vector<float> m_penetrationY;
+};
+
+const NarrowPhaseKernel getBestKernel();
+
+void overlapBoxPairs(const BoxArrays& first,
+	const BoxArrays& second,
+	BoxPairResults& results);
+
+void overlapBoxPairs(const BoxArrays& first,
+	const BoxArrays& second,
+	BoxPairResults& results,
+	const NarrowPhaseKernel kernel);
@@ -1,11 +1,16 @@
 #include "PhysicsSystem.h"
 #include "BBMath.h"
 #include "Collision.h"
+#include <cmath>
 
 PhysicsSystem::PhysicsSystem(const int maxLevels,
 	const int maxObjects,
-	const Rectangle& bounds)
-	:m_collisionGrid(NULL)
+	const Rectangle& bounds,
+	const SpatialIndexType indexType,
+	const int cellSize)
+	:m_collisionGrid(NULL),
+	m_snapshots(NULL),
+	m_bulkLoading(false)
 {
 	int workingLevels = maxLevels;
 
@@ -22,7 +27,7 @@ PhysicsSystem::PhysicsSystem(const int maxLevels,
 	}
 
 	m_collisionGrid =
-		new Quadtree(maxObjects, maxLevels, 0, bounds, NULL);
+		createSpatialIndex(indexType, bounds, workingObjects, workingLevels, cellSize);
 }
 
 PhysicsSystem::~PhysicsSystem()
@@ -55,6 +60,78 @@ CollisionBox* PhysicsSystem::getCollisionBox(const int collisionBoxID) const
 	return collision;
 }
 
+//=============================================================================
+// Function: const ISpatialIndex<EntityData>* getCollisionGrid() const
+// Description:
+// Gets the spatial index holding the collision boxes, so other
+// systems can run queries like nearest or withinRadius on it.
+// Output:
+// const ISpatialIndex<EntityData>*
+// Returns the collision index.
+//=============================================================================
+const ISpatialIndex<EntityData>* PhysicsSystem::getCollisionGrid() const
+{
+	return m_collisionGrid;
+}
+
+//=============================================================================
+// Function: void enableSnapshots()
+// Description:
+// Starts keeping a read-only copy of the collision grid that's
+// published at the end of every update. Other threads can search
+// it through acquireSnapshot while physics runs. The copies only
+// hold entity ids and sizes, the collision boxes themselves still
+// belong to this system.
+//=============================================================================
+void PhysicsSystem::enableSnapshots()
+{
+	if (m_collisionGrid && !m_snapshots)
+	{
+		m_snapshots = new SpatialSnapshots(*m_collisionGrid);
+	}
+}
+
+//=============================================================================
+// Function: const ISpatialIndex<EntityData>* acquireSnapshot()
+// Description:
+// Gets the collision grid as it was at the end of the last update.
+// It stays valid until it's passed to releaseSnapshot. Safe to
+// call from any thread.
+// Output:
+// const ISpatialIndex<EntityData>*
+// On success - Returns the snapshot.
+// On failure - Returns NULL if snapshots aren't enabled or the grid
+// can't be copied.
+//=============================================================================
+const ISpatialIndex<EntityData>* PhysicsSystem::acquireSnapshot()
+{
+	const ISpatialIndex<EntityData> *snapshot = NULL;
+
+	if (m_snapshots)
+	{
+		snapshot = m_snapshots->acquire();
+	}
+
+	return snapshot;
+}
+
+//=============================================================================
+// Function: void releaseSnapshot(const ISpatialIndex<EntityData>*)
+// Description:
+// Lets go of a snapshot from acquireSnapshot. Should be called
+// before the next update ends so publishing doesn't have to wait.
+// Parameters:
+// const ISpatialIndex<EntityData> *snapshot - The snapshot to
+// release.
+//=============================================================================
+void PhysicsSystem::releaseSnapshot(const ISpatialIndex<EntityData> *snapshot)
+{
+	if (m_snapshots)
+	{
+		m_snapshots->release(snapshot);
+	}
+}
+
 //=============================================================================
 // Function: Velocity* getVelocity(const int)
 // Description:
@@ -80,6 +157,8 @@ Velocity* PhysicsSystem::getVelocity(const int velocityID)
 	else
 	{
 		vel = new Velocity();
+
+		m_velocity.insert(std::make_pair(velocityID, vel));
 	}
 
 	return vel;
@@ -120,12 +199,59 @@ CollisionBox* PhysicsSystem::createCollisionBox(const int collisionBoxID,
 
 		m_collisionBoxes.insert(std::make_pair(collisionBoxID, collision));
 
-		m_collisionGrid->addEntity(EntityData(collisionBoxID, box));
+		if (!m_bulkLoading)
+		{
+			m_collisionGrid->addEntity(EntityData(collisionBoxID, box));
+		}
 	}
 
 	return collision;
 }
 
+//=============================================================================
+// Function: void beginBulkLoad()
+// Description:
+// Starts loading a batch of collision boxes. Boxes created until
+// endBulkLoad is called aren't added to the collision grid one at a
+// time. Don't update the system while loading.
+//=============================================================================
+void PhysicsSystem::beginBulkLoad()
+{
+	m_bulkLoading = true;
+}
+
+//=============================================================================
+// Function: void endBulkLoad(ThreadPool*)
+// Description:
+// Finishes loading by building the collision grid from every
+// collision box in one pass.
+// Parameters:
+// ThreadPool *pool - A pool to spread the build across, or NULL.
+//=============================================================================
+void PhysicsSystem::endBulkLoad(ThreadPool *pool)
+{
+	if (m_bulkLoading)
+	{
+		std::vector<EntityData> entities;
+
+		entities.reserve(m_collisionBoxes.size());
+
+		for (auto mit = m_collisionBoxes.begin(); mit != m_collisionBoxes.end(); mit++)
+		{
+			entities.emplace_back(EntityData(mit->first, mit->second->getBox()));
+		}
+
+		m_collisionGrid->build(entities, pool);
+
+		if (m_snapshots)
+		{
+			m_snapshots->publish(*m_collisionGrid);
+		}
+
+		m_bulkLoading = false;
+	}
+}
+
 //=============================================================================
 // Function: void update(const float)
 // Description:
@@ -135,6 +261,8 @@ CollisionBox* PhysicsSystem::createCollisionBox(const int collisionBoxID,
 //=============================================================================
 void PhysicsSystem::update(const float delta)
 {
+	m_contacts.clear();
+
 	if (m_collisionGrid)
 	{
 		auto mit = m_velocity.begin();
@@ -158,15 +286,38 @@ void PhysicsSystem::update(const float delta)
 
 			mit++;
 		}
+
+		if (m_snapshots)
+		{
+			m_snapshots->publish(*m_collisionGrid);
+		}
 	}
 }
 
+//=============================================================================
+// Function: const std::vector<CollisionContact>& getContacts() const
+// Description:
+// Gets the pairs of boxes that touched during the last update, so
+// triggers and game code can use the same results the physics did.
+// Output:
+// const std::vector<CollisionContact>&
+// Returns the contacts from the last update.
+//=============================================================================
+const std::vector<CollisionContact>& PhysicsSystem::getContacts() const
+{
+	return m_contacts;
+}
+
 //=============================================================================
 // Function: void handleMovement(const int,
 // CollisionBox*,
 // const Vector2D&)
 // Description:
-// Handles the movement for the collision box.
+// Handles the movement for the collision box. The solid boxes it
+// could touch are found with one search over the area it sweeps
+// through. The box then moves until the first one it would hit, and
+// slides along that one's side with whatever movement is left. Then
+// everything it ends up touching is resolved and recorded.
 // Parameters:
 // const int boxID - The id of the box to move.
 // CollisionBox* box - The box to move.
@@ -178,121 +329,151 @@ void PhysicsSystem::handleMovement(const int boxID,
 {
 	if (box)
 	{
-		Vector2D startPos = box->getPosition();
-		Vector2D endPos = startPos + movement;
-		Line distance(startPos, endPos);
-
-		// Checks to see if there are any collisions on the move path.
-		std::vector<EntityData> lineSearch
-			= m_collisionGrid->search(distance);
+		Rectangle startBox = box->getBox();
 
-		CollisionBox *collision = NULL;
-		CollisionBox *temp = NULL;
+		m_collisionGrid->searchIDs(getSweptArea(startBox, movement), m_searchIDs);
 
-		Vector2D collisionPoint(-1.0f, -1.0f);
+		m_solidBoxes.clear();
 
-		for (unsigned int i = 0; i < lineSearch.size(); i++)
+		for (unsigned int i = 0; i < m_searchIDs.size(); i++)
 		{
-			if (lineSearch[i].m_id != boxID)
+			if (m_searchIDs[i] != boxID)
 			{
-				temp = getCollisionBox(lineSearch[i].m_id);
+				CollisionBox *temp = getCollisionBox(m_searchIDs[i]);
 
-				if (temp->getSolid())
+				if (temp && temp->getSolid())
 				{
-					if (collision)
-					{
-						Vector2D tempIntersect = intersectPoint(temp->getBox(), distance);
-
-						if (totalDistance(startPos, tempIntersect) < 
-							totalDistance(startPos, collisionPoint))
-						{
-							collisionPoint = tempIntersect;
-							collision = temp;
-						}
-					}
-					else
-					{
-						collision = temp;
-						
-						collisionPoint = intersectPoint(collision->getBox(), distance);
-					}
+					m_solidBoxes.push_back(temp);
 				}
 			}
 		}
 
-		// If a collision was made, move up to the collision point.
-		if (collision &&
-			0.0f <= collisionPoint.m_x &&
-			0.0f <= collisionPoint.m_y)
-		{
-			endPos = collisionPoint;
-		}
-
-		box->setPosition(endPos);
+		Vector2D remaining = movement;
 
-		std::vector<EntityData> movedCollisions =
-			m_collisionGrid->search(box->getBox());
-
-		for (unsigned int i = 0; i < movedCollisions.size(); i++)
+		for (int slide = 0; slide < m_MAX_SLIDES &&
+			(remaining.m_x != 0.0f || remaining.m_y != 0.0f); slide++)
 		{
-			if (movedCollisions[i].m_id != boxID)
+			bool blocked = false;
+			float firstTime = 1.0f;
+			Vector2D firstNormal(0.0f, 0.0f);
+
+			for (unsigned int i = 0; i < m_solidBoxes.size(); i++)
 			{
-				temp = getCollisionBox(movedCollisions[i].m_id);
+				float time = 0.0f;
+				Vector2D normal;
 
-				if (temp && temp->getSolid())
+				if (sweepRectRect(box->getBox(), remaining, m_solidBoxes[i]->getBox(), time, normal) &&
+					(!blocked || time < firstTime))
 				{
-					moveOutside(box, temp);
+					blocked = true;
+					firstTime = time;
+					firstNormal = normal;
 				}
 			}
-		}
 
-		endPos = box->getPosition();
+			box->setPosition(box->getPosition() +
+				Vector2D(remaining.m_x * firstTime, remaining.m_y * firstTime));
 
-		box->setPosition(startPos);
+			if (blocked)
+			{
+				// Keep the rest of the movement, less the part going
+				// into the side that was hit.
+				remaining = Vector2D(remaining.m_x * (1.0f - firstTime),
+					remaining.m_y * (1.0f - firstTime));
+
+				float into = (remaining.m_x * firstNormal.m_x) + (remaining.m_y * firstNormal.m_y);
+
+				remaining -= Vector2D(firstNormal.m_x * into, firstNormal.m_y * into);
+			}
+			else
+			{
+				remaining = Vector2D(0.0f, 0.0f);
+			}
+		}
 
-		m_collisionGrid->removeEntity(EntityData(boxID, box->getBox()));
-		
-		box->setPosition(endPos);
+		resolveContacts(boxID, box);
 
-		m_collisionGrid->addEntity(EntityData(boxID, box->getBox()));
+		m_collisionGrid->moveEntity(EntityData(boxID, startBox), box->getBox());
 	}
 }
 
 //=============================================================================
-// Function: void moveOutside(CollisionBox*,
-// CollisionBox*,
-// const Vector2D&)
+// Function: void resolveContacts(const int,
+// CollisionBox*)
 // Description:
-// Moves the box outside of the box it's colliding with.
+// Gets the manifold for each box found by the last search that the
+// moved box is touching. Solid boxes push it out along the normal,
+// and every pair is kept as a contact, so nothing has to check the
+// same pair again.
 // Parameters:
-// CollisionBox* box - The box to move.
-// CollisionBox* collision - The box it's inside.
+// const int boxID - The id of the box that moved.
+// CollisionBox* box - The box that moved.
 //=============================================================================
-void PhysicsSystem::moveOutside(CollisionBox* box,
-	CollisionBox* collision)
+void PhysicsSystem::resolveContacts(const int boxID,
+	CollisionBox* box)
 {
-	if (box && collision)
+	if (box)
 	{
-		Vector2D updatedPosition = box->getPosition();
-		Vector2D overlap = overlapAmount(box->getBox(), collision->getBox());
-		// find the smallest move
-		// If you can just move the x, move the x
-		// If you can just move the y, move the y
-		// Otherwise, move both.
-		if (absoluteValue(overlap.m_x) <= 
-			absoluteValue(overlap.m_y))
+		for (unsigned int i = 0; i < m_searchIDs.size(); i++)
 		{
-			updatedPosition.m_x += overlap.m_x;
-		}
-		else
-		{
-			updatedPosition.m_y += overlap.m_y;
-		}
+			CollisionBox *temp = NULL;
+
+			if (m_searchIDs[i] != boxID)
+			{
+				temp = getCollisionBox(m_searchIDs[i]);
+			}
+
+			CollisionContact contact;
+
+			if (temp && getManifold(box->getBox(), temp->getBox(), contact.m_manifold))
+			{
+				if (temp->getSolid())
+				{
+					box->setPosition(box->getPosition() + contact.m_manifold.getTranslation());
+				}
+
+				contact.m_first = boxID;
+				contact.m_second = m_searchIDs[i];
 
-		box->setPosition(updatedPosition);
+				m_contacts.push_back(contact);
+			}
+		}
 	}
 }
 
+//=============================================================================
+// Function: const Rectangle getSweptArea(const Rectangle&,
+// const Vector2D&) const
+// Description:
+// Gets an area holding the box at both ends of a move, and so
+// everywhere in between.
+// Parameters:
+// const Rectangle& box - The box where it starts.
+// const Vector2D& movement - How far it moves.
+// Output:
+// const Rectangle
+// Returns the area the box sweeps through.
+//=============================================================================
+const Rectangle PhysicsSystem::getSweptArea(const Rectangle& box,
+	const Vector2D& movement) const
+{
+	float minX = box.getMinX();
+	float minY = box.getMinY();
+	float maxX = box.getMaxX();
+	float maxY = box.getMaxY();
+
+	fMin(minX, minX, minX + movement.m_x);
+	fMin(minY, minY, minY + movement.m_y);
+	fMax(maxX, maxX, maxX + movement.m_x);
+	fMax(maxY, maxY, maxY + movement.m_y);
+
+	// getMinX and friends can sit inside the rounded corners the
+	// collision checks use, so the area is padded by a pixel a side.
+	return Rectangle(Vector2D((minX + maxX) / 2.0f, (minY + maxY) / 2.0f),
+		(int)ceil(maxX - minX) + 2,
+		(int)ceil(maxY - minY) + 2);
+}
+
 //=============================================================================
 // Function: Vector2D applyFriction(const Vector2D&,
 // const float) const
@@ -341,6 +522,11 @@ Vector2D PhysicsSystem::applyFriction(const Vector2D& velocity,
 //=============================================================================
 void PhysicsSystem::cleanUp()
 {
+	if (m_snapshots)
+	{
+		delete m_snapshots;
+	}
+
 	if (m_collisionGrid)
 	{
 		delete m_collisionGrid;
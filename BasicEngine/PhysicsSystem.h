@@ -6,42 +6,90 @@
 // Purpose: 
 // Handles all of the physics updates for the system.
 //==========================================================================================
-#include "Quadtree.h"
+#include "SpatialIndex.h"
+#include "SpatialSnapshots.h"
 #include "Velocity.h"
 #include "CollisionBox.h"
+#include "Collision.h"
 #include <map>
 
+struct CollisionContact
+{
+	// The box that moved and the box it ended up touching. The
+	// manifold's normal pushes the first out of the second.
+	int m_first;
+	int m_second;
+
+	CollisionManifold m_manifold;
+};
+
 class PhysicsSystem
 {
 public:
 	PhysicsSystem(const int maxLevels,
 		const int maxObjects,
-		const Rectangle& bounds);
+		const Rectangle& bounds,
+		const SpatialIndexType indexType = INDEX_QUADTREE,
+		const int cellSize = 128);
 	~PhysicsSystem();
 
 	CollisionBox* getCollisionBox(const int collisionBoxID) const;
 	Velocity* getVelocity(const int velocityID);
 
+	const ISpatialIndex<EntityData>* getCollisionGrid() const;
+
+	void enableSnapshots();
+	const ISpatialIndex<EntityData>* acquireSnapshot();
+	void releaseSnapshot(const ISpatialIndex<EntityData> *snapshot);
+
 	CollisionBox* createCollisionBox(const int collisionBoxID,
 		const Rectangle& box,
 		const bool solid);
 
+	void beginBulkLoad();
+	void endBulkLoad(ThreadPool *pool = NULL);
+
 	void update(const float delta);
 
+	const std::vector<CollisionContact>& getContacts() const;
+
 private:
 	std::map<int, CollisionBox*> m_collisionBoxes;
 	std::map<int, Velocity*> m_velocity;
 
-	Quadtree *m_collisionGrid;
+	ISpatialIndex<EntityData> *m_collisionGrid;
+
+	// Copies of the collision grid from the end of the last update,
+	// for other threads to search while this one runs. NULL until
+	// enableSnapshots is called.
+	SpatialSnapshots *m_snapshots;
+
+	// Reused by every search so moving doesn't allocate.
+	std::vector<int> m_searchIDs;
+	std::vector<CollisionBox*> m_solidBoxes;
+
+	// Every pair found touching during the last update, solid or not.
+	std::vector<CollisionContact> m_contacts;
+
+	// While loading, new boxes are left out of the collision grid
+	// until the whole grid is built at the end.
+	bool m_bulkLoading;
 
 	const float m_FRICTION = 1.0f;
 
+	// How many times a box can hit something and slide along it in
+	// one move.
+	const int m_MAX_SLIDES = 3;
+
 	void handleMovement(const int boxID,
 		CollisionBox* box,
 		const Vector2D& movement);
 
-	void moveOutside(CollisionBox* box,
-		CollisionBox* collision);
+	void resolveContacts(const int boxID,
+		CollisionBox* box);
+
+	const Rectangle getSweptArea(const Rectangle& box,
+		const Vector2D& movement) const;
 
 	Vector2D applyFriction(const Vector2D& velocity,
 		const float delta) const;
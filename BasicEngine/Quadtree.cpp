@@ -1,419 +1,2870 @@
 #include "Quadtree.h"
 #include "Collision.h"
 #include "Renderer.h"
+#include "ThreadPool.h"
+#include "BBMath.h"
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+// SSE is always there on the x86 and x64 targets, anything else
+// checks the batches one entity at a time.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#define QUADTREE_SSE
+#include <xmmintrin.h>
+#endif
 
 Quadtree::Quadtree(const int maxObjects,
 	const int maxLevels,
-	const int level,
 	const Rectangle& bounds,
-	Quadtree *parent)
-	:m_maxObjects(maxObjects),
+	const float looseness)
+	:m_freeEntity(NO_INDEX),
+	m_freeNode(NO_INDEX),
+	m_maxObjects(maxObjects),
 	m_maxLevels(maxLevels),
-	m_level(level),
-	m_bounds(bounds),
-	m_parent(parent)
+	m_mergeObjects(maxObjects / 2),
+	m_looseness(looseness),
+	m_queryCount(0),
+	m_nodesVisited(0),
+	m_entitiesTested(0),
+	m_entitiesReturned(0)
+{
+	if (m_looseness < 1.0f)
+	{
+		m_looseness = 1.0f;
+	}
+
+	m_nodes.emplace_back(QuadNode(bounds, getLooseBounds(bounds), NO_INDEX, 0));
+}
+
+Quadtree::~Quadtree()
+{
+	cleanUp();
+}
+
+//=============================================================================
+// Function: const int getWidth() const
+// Description:
+// Gets the width of the Quadtree.
+// Output:
+// const int
+// Returns width.
+//=============================================================================
+const int Quadtree::getWidth() const
+{
+	return m_nodes[ROOT].m_bounds.getWidth();
+}
+
+//=============================================================================
+// Function: const int getHeight() const
+// Description:
+// Gets the height of the Quadtree.
+// Output:
+// const int
+// Returns height.
+//=============================================================================
+const int Quadtree::getHeight() const
+{
+	return m_nodes[ROOT].m_bounds.getHeight();
+}
+
+//=============================================================================
+// Function: const float getLooseness() const
+// Description:
+// Gets the factor the node bounds are grown by for searching.
+// Output:
+// const float
+// Returns the looseness. 1 means the tree isn't loose.
+//=============================================================================
+const float Quadtree::getLooseness() const
+{
+	return m_looseness;
+}
+
+//=============================================================================
+// Function: const QuadtreeStats getStats() const
+// Description:
+// Walks the tree and counts the nodes, leafs, depth and entities,
+// along with how much of the node pool is free.
+// Output:
+// const QuadtreeStats
+// Returns the stats of the tree.
+//=============================================================================
+const QuadtreeStats Quadtree::getStats() const
+{
+	QuadtreeStats stats;
+
+	collectStats(ROOT, stats);
+
+	stats.m_poolSize = (int)m_nodes.size();
+
+	int block = m_freeNode;
+
+	while (block != NO_INDEX)
+	{
+		stats.m_freeNodes += CHILD_COUNT;
+
+		block = m_nodes[block].m_firstChild;
+	}
+
+	return stats;
+}
+
+//=============================================================================
+// Function: const QuadtreeQueryStats getQueryStats() const
+// Description:
+// Gets the totals counted by the area and line searches since the
+// counters were last reset.
+// Output:
+// const QuadtreeQueryStats
+// Returns the totals.
+//=============================================================================
+const QuadtreeQueryStats Quadtree::getQueryStats() const
+{
+	QuadtreeQueryStats stats;
+
+	stats.m_queries = m_queryCount.load(std::memory_order_relaxed);
+	stats.m_nodesVisited = m_nodesVisited.load(std::memory_order_relaxed);
+	stats.m_entitiesTested = m_entitiesTested.load(std::memory_order_relaxed);
+	stats.m_entitiesReturned = m_entitiesReturned.load(std::memory_order_relaxed);
+
+	return stats;
+}
+
+//=============================================================================
+// Function: void resetQueryStats()
+// Description:
+// Sets the search totals back to 0.
+//=============================================================================
+void Quadtree::resetQueryStats()
+{
+	m_queryCount.store(0, std::memory_order_relaxed);
+	m_nodesVisited.store(0, std::memory_order_relaxed);
+	m_entitiesTested.store(0, std::memory_order_relaxed);
+	m_entitiesReturned.store(0, std::memory_order_relaxed);
+}
+
+//=============================================================================
+// Function: const bool writeOccupancyCSV(const string&) const
+// Description:
+// Writes a line for every node to a CSV file with its level, whether
+// it's a leaf, its bounds and how many entities it and its subtree
+// hold. Plotting the leafs' counts over their bounds gives a
+// heatmap of where the tree is loaded.
+// Parameters:
+// const string& path - The file to write.
+// Output:
+// const bool
+// Returns true if the file was written.
+//=============================================================================
+const bool Quadtree::writeOccupancyCSV(const std::string& path) const
+{
+	bool success = false;
+
+	std::ofstream fout;
+
+	fout.open(path, std::ios::trunc);
+
+	if (fout.is_open())
+	{
+		fout << "level,leaf,minX,minY,maxX,maxY,entities,total" << std::endl;
+
+		writeOccupancyNode(ROOT, fout);
+
+		success = fout.good();
+	}
+
+	fout.close();
+
+	return success;
+}
+
+//=============================================================================
+// Function: void search(const Rectangle&,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Searches the tree for any entities inside the specified rectangle
+// and hands each one to the visitor.
+// Parameters:
+// const Rectangle& searchArea - The area to search inside.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call. The
+// search stops as soon as it returns false.
+//=============================================================================
+void Quadtree::search(const Rectangle& searchArea,
+	ISpatialVisitor<EntityData>& visitor) const
+{
+	QueryCounter counter;
+
+	search(searchArea, visitor, counter);
+
+	recordQuery(counter);
+}
+
+//=============================================================================
+// Function: void search(const Rectangle&,
+// ISpatialVisitor<EntityData>&,
+// QueryCounter&) const
+// Description:
+// Searches the tree for any entities inside the specified rectangle
+// and hands each one to the visitor, adding the work done to the
+// counter instead of the totals.
+// Parameters:
+// const Rectangle& searchArea - The area to search inside.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call. The
+// search stops as soon as it returns false.
+// QueryCounter& counter - Counts the search.
+//=============================================================================
+void Quadtree::search(const Rectangle& searchArea,
+	ISpatialVisitor<EntityData>& visitor,
+	QueryCounter& counter) const
+{
+	const QuadNode& root = m_nodes[ROOT];
+
+	counter.m_queries++;
+	counter.m_nodesVisited++;
+
+	if (rectIntersectRect(root.m_looseBounds, searchArea))
+	{
+		bool keepGoing = true;
+
+		if (root.m_firstChild != NO_INDEX)
+		{
+			for (int i = 0; i < CHILD_COUNT && keepGoing; i++)
+			{
+				keepGoing = search(root.m_firstChild + i, searchArea, visitor, counter);
+			}
+		}
+
+		if (keepGoing)
+		{
+			searchEntities(ROOT, searchArea, false, visitor, counter);
+		}
+	}
+}
+
+//=============================================================================
+// Function: void search(const Line&,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Searches for all entities that intersect the line and hands each
+// one to the visitor.
+// Parameters:
+// const Line& searchLine - The line to search along.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call. The
+// search stops as soon as it returns false.
+//=============================================================================
+void Quadtree::search(const Line& searchLine,
+	ISpatialVisitor<EntityData>& visitor) const
 {
-	
+	QueryCounter counter;
+
+	counter.m_queries++;
+
+	search(ROOT, searchLine, visitor, counter);
+
+	recordQuery(counter);
+}
+
+//=============================================================================
+// Function: void searchBatch(const vector<Rectangle>&,
+// SearchBatchResult&,
+// ThreadPool*) const
+// Description:
+// Answers many area searches at once. The queries are split into
+// chunks that each collect ids into their own buffer and count
+// their work in their own counter, so the threads never share
+// anything they write to. The buffers are then joined into one list
+// with an offset for each query, and the counters are added to the
+// totals once.
+// Parameters:
+// const vector<Rectangle>& searchAreas - The areas to search.
+// SearchBatchResult& results - Filled with the ids found by each
+// query, in the same order as the areas.
+// ThreadPool *pool - The pool to spread the queries across, or NULL
+// to run them all on this thread.
+//=============================================================================
+void Quadtree::searchBatch(const std::vector<Rectangle>& searchAreas,
+	SearchBatchResult& results,
+	ThreadPool *pool) const
+{
+	const int count = (int)searchAreas.size();
+
+	int chunks = 1;
+
+	if (pool)
+	{
+		chunks = pool->getThreadCount() * CHUNKS_PER_THREAD;
+	}
+
+	iMin(chunks, chunks, count);
+	iMax(chunks, chunks, 1);
+
+	const int chunkSize = (count + chunks - 1) / chunks;
+
+	results.m_offsets.resize(count + 1);
+
+	if ((int)results.m_chunkIds.size() < chunks)
+	{
+		results.m_chunkIds.resize(chunks);
+	}
+
+	std::vector<QueryCounter> counters(chunks);
+
+	// Each offset starts out relative to its chunk's buffer.
+	auto searchChunk = [&](const int chunk)
+	{
+		int begin = chunk * chunkSize;
+		int end = begin + chunkSize;
+
+		iMin(end, end, count);
+
+		std::vector<int>& ids = results.m_chunkIds[chunk];
+		IDCollector collector(ids);
+
+		ids.clear();
+
+		for (int i = begin; i < end; i++)
+		{
+			results.m_offsets[i] = (int)ids.size();
+
+			search(searchAreas[i], collector, counters[chunk]);
+		}
+	};
+
+	std::vector<int> chunkStarts(chunks + 1, 0);
+
+	if (1 < chunks)
+	{
+		pool->run(chunks, searchChunk);
+	}
+	else
+	{
+		searchChunk(0);
+	}
+
+	QueryCounter total;
+
+	for (int i = 0; i < chunks; i++)
+	{
+		chunkStarts[i + 1] = chunkStarts[i] + (int)results.m_chunkIds[i].size();
+
+		total.m_queries += counters[i].m_queries;
+		total.m_nodesVisited += counters[i].m_nodesVisited;
+		total.m_entitiesTested += counters[i].m_entitiesTested;
+		total.m_entitiesReturned += counters[i].m_entitiesReturned;
+	}
+
+	recordQuery(total);
+
+	results.m_ids.resize(chunkStarts[chunks]);
+	results.m_offsets[count] = chunkStarts[chunks];
+
+	auto joinChunk = [&](const int chunk)
+	{
+		int begin = chunk * chunkSize;
+		int end = begin + chunkSize;
+
+		iMin(end, end, count);
+
+		for (int i = begin; i < end; i++)
+		{
+			results.m_offsets[i] += chunkStarts[chunk];
+		}
+
+		const std::vector<int>& ids = results.m_chunkIds[chunk];
+
+		std::copy(ids.begin(), ids.end(), results.m_ids.begin() + chunkStarts[chunk]);
+	};
+
+	if (1 < chunks)
+	{
+		pool->run(chunks, joinChunk);
+	}
+	else
+	{
+		joinChunk(0);
+	}
+}
+
+//=============================================================================
+// Function: void addEntity(const EntityData&)
+// Description:
+// Adds an entity to the tree. Entity ids are expected to be unique.
+// Parameters:
+// const EntityData& entity - The entity to add to the quad tree.
+//=============================================================================
+void Quadtree::addEntity(const EntityData& entity)
+{
+	int slot = createSlot(entity);
+
+	m_slotLookup[entity.m_id] = slot;
+
+	insertEntity(ROOT, slot);
+}
+
+//=============================================================================
+// Function: void removeEntity(const EntityData&)
+// Description:
+// Finds and removes an entity from the quad tree.
+// Parameters:
+// const EntityData& entity - The entity to remove.
+//=============================================================================
+void Quadtree::removeEntity(const EntityData& entity)
+{
+	auto lookup = m_slotLookup.find(entity.m_id);
+
+	if (lookup != m_slotLookup.end())
+	{
+		int slot = lookup->second;
+		int node = m_entities[slot].m_node;
+
+		m_slotLookup.erase(lookup);
+
+		unlinkEntity(slot);
+		releaseSlot(slot);
+
+		collapse(node);
+	}
+}
+
+//=============================================================================
+// Function: void moveEntity(const EntityData&, const Rectangle&)
+// Description:
+// Moves an entity to a new size. The tree tracks where every
+// entity is, so the old size isn't needed.
+// Parameters:
+// const EntityData& entity - The entity at its old size.
+// const Rectangle& size - The new size.
+//=============================================================================
+void Quadtree::moveEntity(const EntityData& entity,
+	const Rectangle& size)
+{
+	auto lookup = m_slotLookup.find(entity.m_id);
+
+	if (lookup != m_slotLookup.end())
+	{
+		m_entities[lookup->second].m_data.m_flags = entity.m_flags;
+
+		resizeSlot(lookup->second, size);
+	}
+}
+
+//=============================================================================
+// Function: void updateEntity(const int, const Rectangle&)
+// Description:
+// Changes the size of an entity.
+// Parameters:
+// const int id - The id of the entity to update.
+// const Rectangle& size - The new size.
+//=============================================================================
+void Quadtree::updateEntity(const int id,
+	const Rectangle& size)
+{
+	auto lookup = m_slotLookup.find(id);
+
+	if (lookup != m_slotLookup.end())
+	{
+		resizeSlot(lookup->second, size);
+	}
+}
+
+//=============================================================================
+// Function: bool raycast(const Line&,
+// RaycastHit&,
+// const ISpatialFilter<EntityData>*) const
+// Description:
+// Finds the first entity the ray hits. Children are visited in the
+// order the ray reaches them. In a loose tree every entity is inside
+// its node's loose bounds, so nodes the ray reaches after the
+// closest hit so far are skipped and most casts stop in the first
+// few nodes. A tight tree can't skip them, since its entities can
+// hang out of their node.
+// Parameters:
+// const Line& ray - The ray to cast, from its start to its end.
+// RaycastHit& hit - Set to the closest hit.
+// const ISpatialFilter<EntityData> *filter - Skips the entities it
+// doesn't accept. NULL accepts everything.
+// Output:
+// bool
+// Returns true if something was hit.
+//=============================================================================
+bool Quadtree::raycast(const Line& ray,
+	RaycastHit& hit,
+	const ISpatialFilter<EntityData> *filter) const
+{
+	bool found = false;
+
+	float time = 0.0f;
+	Vector2D normal;
+
+	if (rayIntersectRect(m_nodes[ROOT].m_looseBounds, ray, time, normal))
+	{
+		raycast(ROOT, time, ray, filter, hit, found);
+	}
+
+	return found;
+}
+
+//=============================================================================
+// Function: void nearest(const Vector2D&,
+// const int,
+// vector<EntityData>&) const
+// Description:
+// Finds the entities whose centers are closest to the point.
+// Entities are placed by their centers, so a node can't hold
+// anything closer than its own bounds. Children are visited closest
+// first and skipped once they're farther than everything kept.
+// Parameters:
+// const Vector2D& point - The point to search from.
+// const int count - The most entities to find.
+// vector<EntityData>& nearest - Filled with the entities, closest
+// first. It's cleared first.
+//=============================================================================
+void Quadtree::nearest(const Vector2D& point,
+	const int count,
+	std::vector<EntityData>& nearest) const
+{
+	nearest.clear();
+
+	if (0 < count)
+	{
+		this->nearest(ROOT, point, count, nearest);
+
+		sortNearest(point, nearest);
+	}
+}
+
+//=============================================================================
+// Function: void withinRadius(const Vector2D&,
+// const float,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Visits every entity whose center is within the radius of the
+// point, skipping the nodes that are entirely outside of it.
+// Parameters:
+// const Vector2D& point - The center of the circle.
+// const float radius - The radius of the circle.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call. The
+// search stops as soon as it returns false.
+//=============================================================================
+void Quadtree::withinRadius(const Vector2D& point,
+	const float radius,
+	ISpatialVisitor<EntityData>& visitor) const
+{
+	withinRadius(ROOT, point, radius * radius, visitor);
+}
+
+//=============================================================================
+// Function: void forEachOverlappingPair(ISpatialPairVisitor<EntityData>&) const
+// Description:
+// Visits every pair of overlapping entities in one walk of the
+// tree. Each entity is tested against the entities after it in its
+// own node and the entities below it. Pairs split between sibling
+// subtrees are found by walking the two subtrees together, which
+// only happens where their extents meet. Every pair is found once.
+// The extents of each subtree are measured first, in one pass.
+// Parameters:
+// ISpatialPairVisitor<EntityData>& visitor - The visitor to call.
+// The search stops as soon as it returns false.
+//=============================================================================
+void Quadtree::forEachOverlappingPair(ISpatialPairVisitor<EntityData>& visitor) const
+{
+	if (m_nodes[ROOT].m_totalCount != 0)
+	{
+		std::vector<NodeExtent> extents(m_nodes.size());
+
+		findExtents(ROOT, extents);
+		findPairs(ROOT, extents, visitor);
+	}
+}
+
+//=============================================================================
+// Function: ISpatialIndex<EntityData>* createSnapshot() const
+// Description:
+// Creates a read-only copy of the tree.
+// Output:
+// ISpatialIndex<EntityData>*
+// Returns the snapshot. The caller owns it.
+//=============================================================================
+ISpatialIndex<EntityData>* Quadtree::createSnapshot() const
+{
+	Quadtree *snapshot =
+		new Quadtree(m_maxObjects, m_maxLevels, m_nodes[ROOT].m_bounds, m_looseness);
+
+	updateSnapshot(*snapshot);
+
+	return snapshot;
+}
+
+//=============================================================================
+// Function: void updateSnapshot(ISpatialIndex<EntityData>&) const
+// Description:
+// Copies the nodes and entity slots into a snapshot. The id lookup
+// is left out since a snapshot is only ever searched, so the copy
+// is two flat arrays that reuse the snapshot's memory.
+// Parameters:
+// ISpatialIndex<EntityData>& snapshot - A snapshot from
+// createSnapshot.
+//=============================================================================
+void Quadtree::updateSnapshot(ISpatialIndex<EntityData>& snapshot) const
+{
+	Quadtree& tree = static_cast<Quadtree&>(snapshot);
+
+	tree.m_nodes = m_nodes;
+	tree.m_entities = m_entities;
+	tree.m_slotLookup.clear();
+
+	tree.m_slotMinX = m_slotMinX;
+	tree.m_slotMinY = m_slotMinY;
+	tree.m_slotMaxX = m_slotMaxX;
+	tree.m_slotMaxY = m_slotMaxY;
+	tree.m_slotAligned = m_slotAligned;
+
+	tree.m_freeEntity = m_freeEntity;
+	tree.m_freeNode = m_freeNode;
+}
+
+//=============================================================================
+// Function: void clear()
+// Description:
+// Removes every entity and node, leaving an empty root.
+//=============================================================================
+void Quadtree::clear()
+{
+	const Rectangle bounds = m_nodes[ROOT].m_bounds;
+
+	cleanUp();
+
+	m_nodes.emplace_back(QuadNode(bounds, getLooseBounds(bounds), NO_INDEX, 0));
+}
+
+//=============================================================================
+// Function: void build(const vector<EntityData>&, ThreadPool*)
+// Description:
+// Replaces the contents of the tree with the entities. They're
+// sorted by the Z-order code of their centers, which groups them by
+// node, and then the tree is built from the top down with each
+// node splitting its part of the list between its children once.
+// The slab ends up in the same order, so entities that are close
+// together are stored close together. The tree ends up with the
+// same shape as adding the entities one at a time.
+// Parameters:
+// const vector<EntityData>& entities - The entities to store.
+// ThreadPool *pool - Used to work out and sort the codes, or NULL
+// to do it all on this thread.
+//=============================================================================
+void Quadtree::build(const std::vector<EntityData>& entities,
+	ThreadPool *pool)
+{
+	const int count = (int)entities.size();
+
+	std::vector<MortonEntry> sorted(count);
+	std::vector<int> slots(count);
+	std::vector<int> children(count);
+	std::vector<int> scratch(count);
+
+	clear();
+
+	sortByMorton(entities, sorted, pool);
+
+	m_entities.reserve(count);
+	m_slotLookup.reserve(count);
+
+	m_slotMinX.reserve(count);
+	m_slotMinY.reserve(count);
+	m_slotMaxX.reserve(count);
+	m_slotMaxY.reserve(count);
+	m_slotAligned.reserve(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		const EntityData& entity = entities[sorted[i].m_index];
+
+		slots[i] = createSlot(entity);
+		m_slotLookup[entity.m_id] = slots[i];
+	}
+
+	buildNode(ROOT, 0, count, slots, children, scratch);
+}
+
+//=============================================================================
+// Function: void serialize(vector<char>&) const
+// Description:
+// Writes the tree's settings, node pool and slab to a blob that
+// deserialize can load back without rebuilding anything. Free nodes
+// and slots are written too so every index stays the same.
+// Parameters:
+// vector<char>& blob - Replaced with the saved tree.
+//=============================================================================
+void Quadtree::serialize(std::vector<char>& blob) const
+{
+	const int nodeCount = (int)m_nodes.size();
+	const int slotCount = (int)m_entities.size();
+
+	BlobHeader header;
+
+	header.m_magic = BLOB_MAGIC;
+	header.m_version = BLOB_VERSION;
+	header.m_maxObjects = m_maxObjects;
+	header.m_maxLevels = m_maxLevels;
+	header.m_looseness = m_looseness;
+	header.m_nodeCount = nodeCount;
+	header.m_slotCount = slotCount;
+	header.m_freeNode = m_freeNode;
+	header.m_freeEntity = m_freeEntity;
+
+	blob.resize(sizeof(BlobHeader) +
+		(nodeCount * sizeof(NodeRecord)) +
+		(slotCount * sizeof(SlotRecord)));
+
+	char *write = blob.data();
+
+	memcpy(write, &header, sizeof(BlobHeader));
+	write += sizeof(BlobHeader);
+
+	for (int i = 0; i < nodeCount; i++)
+	{
+		const QuadNode& quadNode = m_nodes[i];
+
+		NodeRecord record;
+
+		record.m_centerX = quadNode.m_bounds.getCenter().m_x;
+		record.m_centerY = quadNode.m_bounds.getCenter().m_y;
+		record.m_width = quadNode.m_bounds.getWidth();
+		record.m_height = quadNode.m_bounds.getHeight();
+		record.m_parent = quadNode.m_parent;
+		record.m_firstChild = quadNode.m_firstChild;
+		record.m_firstEntity = quadNode.m_firstEntity;
+		record.m_lastEntity = quadNode.m_lastEntity;
+		record.m_entityCount = quadNode.m_entityCount;
+		record.m_totalCount = quadNode.m_totalCount;
+		record.m_level = quadNode.m_level;
+
+		memcpy(write, &record, sizeof(NodeRecord));
+		write += sizeof(NodeRecord);
+	}
+
+	for (int i = 0; i < slotCount; i++)
+	{
+		const EntitySlot& entitySlot = m_entities[i];
+		const Rectangle& size = entitySlot.m_data.m_size;
+
+		SlotRecord record;
+
+		record.m_id = entitySlot.m_data.m_id;
+		record.m_flags = entitySlot.m_data.m_flags;
+		record.m_centerX = size.getCenter().m_x;
+		record.m_centerY = size.getCenter().m_y;
+		record.m_width = size.getWidth();
+		record.m_height = size.getHeight();
+		record.m_rotation = size.getRotation();
+		record.m_node = entitySlot.m_node;
+		record.m_previous = entitySlot.m_previous;
+		record.m_next = entitySlot.m_next;
+
+		memcpy(write, &record, sizeof(SlotRecord));
+		write += sizeof(SlotRecord);
+	}
+}
+
+//=============================================================================
+// Function: const bool deserialize(const char*, const size_t)
+// Description:
+// Replaces the tree with one written by serialize. The blob can come
+// straight from a file read or a mapped view of one. The records are
+// copied into the pools as they are, then the id lookup and corner
+// arrays are filled in from the slab. A blob that isn't a saved tree,
+// or that has an index out of range, is rejected and the tree is
+// left alone.
+// Parameters:
+// const char *blob - The saved tree.
+// const size_t size - The size of the blob in bytes.
+// Output:
+// const bool
+// Returns true if the tree was loaded.
+//=============================================================================
+const bool Quadtree::deserialize(const char *blob,
+	const size_t size)
+{
+	if (blob == NULL || size < sizeof(BlobHeader))
+	{
+		return false;
+	}
+
+	BlobHeader header;
+
+	memcpy(&header, blob, sizeof(BlobHeader));
+
+	if (header.m_magic != BLOB_MAGIC ||
+		header.m_version != BLOB_VERSION ||
+		header.m_nodeCount < 1 ||
+		header.m_slotCount < 0 ||
+		size != sizeof(BlobHeader) +
+			((size_t)header.m_nodeCount * sizeof(NodeRecord)) +
+			((size_t)header.m_slotCount * sizeof(SlotRecord)))
+	{
+		return false;
+	}
+
+	const int nodeCount = header.m_nodeCount;
+	const int slotCount = header.m_slotCount;
+
+	const char *nodeRecords = blob + sizeof(BlobHeader);
+	const char *slotRecords = nodeRecords + (nodeCount * sizeof(NodeRecord));
+
+	// Check every link before anything is replaced.
+	for (int i = 0; i < nodeCount; i++)
+	{
+		NodeRecord record;
+
+		memcpy(&record, nodeRecords + (i * sizeof(NodeRecord)), sizeof(NodeRecord));
+
+		if (!validIndex(record.m_parent, nodeCount) ||
+			!validIndex(record.m_firstChild, nodeCount - (CHILD_COUNT - 1)) ||
+			!validIndex(record.m_firstEntity, slotCount) ||
+			!validIndex(record.m_lastEntity, slotCount))
+		{
+			return false;
+		}
+	}
+
+	for (int i = 0; i < slotCount; i++)
+	{
+		SlotRecord record;
+
+		memcpy(&record, slotRecords + (i * sizeof(SlotRecord)), sizeof(SlotRecord));
+
+		if (!validIndex(record.m_node, nodeCount) ||
+			!validIndex(record.m_previous, slotCount) ||
+			!validIndex(record.m_next, slotCount))
+		{
+			return false;
+		}
+	}
+
+	if (!validIndex(header.m_freeNode, nodeCount) ||
+		!validIndex(header.m_freeEntity, slotCount))
+	{
+		return false;
+	}
+
+	cleanUp();
+
+	m_maxObjects = header.m_maxObjects;
+	m_maxLevels = header.m_maxLevels;
+	m_mergeObjects = m_maxObjects / 2;
+	m_looseness = header.m_looseness;
+
+	if (m_looseness < 1.0f)
+	{
+		m_looseness = 1.0f;
+	}
+
+	m_freeNode = header.m_freeNode;
+	m_freeEntity = header.m_freeEntity;
+
+	m_nodes.reserve(nodeCount);
+	m_entities.reserve(slotCount);
+	m_slotLookup.reserve(slotCount);
+
+	m_slotMinX.resize(slotCount);
+	m_slotMinY.resize(slotCount);
+	m_slotMaxX.resize(slotCount);
+	m_slotMaxY.resize(slotCount);
+	m_slotAligned.resize(slotCount);
+
+	for (int i = 0; i < nodeCount; i++)
+	{
+		NodeRecord record;
+
+		memcpy(&record, nodeRecords + (i * sizeof(NodeRecord)), sizeof(NodeRecord));
+
+		const Rectangle bounds(Vector2D(record.m_centerX, record.m_centerY),
+			record.m_width,
+			record.m_height);
+
+		m_nodes.emplace_back(QuadNode(bounds, getLooseBounds(bounds), record.m_parent, record.m_level));
+
+		QuadNode& quadNode = m_nodes.back();
+
+		quadNode.m_firstChild = record.m_firstChild;
+		quadNode.m_firstEntity = record.m_firstEntity;
+		quadNode.m_lastEntity = record.m_lastEntity;
+		quadNode.m_entityCount = record.m_entityCount;
+		quadNode.m_totalCount = record.m_totalCount;
+	}
+
+	for (int i = 0; i < slotCount; i++)
+	{
+		SlotRecord record;
+
+		memcpy(&record, slotRecords + (i * sizeof(SlotRecord)), sizeof(SlotRecord));
+
+		Rectangle bounds(Vector2D(record.m_centerX, record.m_centerY),
+			record.m_width,
+			record.m_height);
+
+		bounds.setRotation(record.m_rotation);
+
+		m_entities.emplace_back(EntitySlot(EntityData(record.m_id, bounds, record.m_flags)));
+
+		EntitySlot& entitySlot = m_entities.back();
+
+		entitySlot.m_node = record.m_node;
+		entitySlot.m_previous = record.m_previous;
+		entitySlot.m_next = record.m_next;
+
+		setSlotBounds(i);
+
+		// Free slots aren't linked into a node.
+		if (entitySlot.m_node != NO_INDEX)
+		{
+			m_slotLookup[record.m_id] = i;
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+// Function: const bool save(const string&) const
+// Description:
+// Serializes the tree and writes it to a file in one go.
+// Parameters:
+// const string& path - The file to write.
+// Output:
+// const bool
+// Returns true if the file was written.
+//=============================================================================
+const bool Quadtree::save(const std::string& path) const
+{
+	bool success = false;
+
+	std::vector<char> blob;
+
+	serialize(blob);
+
+	std::ofstream fout;
+
+	fout.open(path, std::ios::binary | std::ios::trunc);
+
+	if (fout.is_open())
+	{
+		fout.write(blob.data(), blob.size());
+
+		success = fout.good();
+	}
+
+	fout.close();
+
+	return success;
+}
+
+//=============================================================================
+// Function: const bool load(const string&)
+// Description:
+// Reads a file written by save with a single read and loads the tree
+// from it.
+// Parameters:
+// const string& path - The file to read.
+// Output:
+// const bool
+// Returns true if the tree was loaded.
+//=============================================================================
+const bool Quadtree::load(const std::string& path)
+{
+	bool success = false;
+
+	std::ifstream fin;
+
+	fin.open(path, std::ios::binary | std::ios::ate);
+
+	if (fin.is_open())
+	{
+		const std::streamoff size = fin.tellg();
+
+		if (0 < size)
+		{
+			std::vector<char> blob((size_t)size);
+
+			fin.seekg(0, std::ios::beg);
+			fin.read(blob.data(), size);
+
+			success = fin.good() && deserialize(blob.data(), blob.size());
+		}
+	}
+
+	fin.close();
+
+	return success;
+}
+
+//=============================================================================
+// Function: void renderTree(Renderer*,
+// const Vector2D&,
+// const float,
+// const float)
+// Description:
+// Draws the outline of every leaf node.
+// Parameters:
+// Renderer *renderer - The renderer to draw with.
+// const Vector2D& offset - The camera offset.
+// const float xScale - The horizontal scale.
+// const float yScale - The vertical scale.
+//=============================================================================
+void Quadtree::renderTree(Renderer *renderer,
+	const Vector2D& offset,
+	const float xScale,
+	const float yScale)
+{
+	renderNode(ROOT, renderer, offset, xScale, yScale);
+}
+
+//=============================================================================
+// Function: void renderOccupancy(Renderer*,
+// const Vector2D&,
+// const float,
+// const float)
+// Description:
+// Draws a heatmap of the tree. Every node holding entities is
+// filled in, more solid the closer it is to the object limit, and
+// nodes over the limit are drawn fully solid.
+// Parameters:
+// Renderer *renderer - The renderer to draw with.
+// const Vector2D& offset - The camera offset.
+// const float xScale - The horizontal scale.
+// const float yScale - The vertical scale.
+//=============================================================================
+void Quadtree::renderOccupancy(Renderer *renderer,
+	const Vector2D& offset,
+	const float xScale,
+	const float yScale)
+{
+	renderOccupancyNode(ROOT, renderer, offset, xScale, yScale);
+}
+
+//=============================================================================
+// Function: void cleanUp()
+// Description:
+// Cleans up all of the nodes and entity slots.
+//=============================================================================
+void Quadtree::cleanUp()
+{
+	m_nodes.clear();
+	m_entities.clear();
+	m_slotLookup.clear();
+
+	m_slotMinX.clear();
+	m_slotMinY.clear();
+	m_slotMaxX.clear();
+	m_slotMaxY.clear();
+	m_slotAligned.clear();
+
+	m_freeEntity = NO_INDEX;
+	m_freeNode = NO_INDEX;
+}
+
+//=============================================================================
+// Function: void recordQuery(const QueryCounter&) const
+// Description:
+// Adds the work done by a search, or a batch of them, to the totals.
+// Parameters:
+// const QueryCounter& counter - The searches' counts.
+//=============================================================================
+void Quadtree::recordQuery(const QueryCounter& counter) const
+{
+	m_queryCount.fetch_add(counter.m_queries, std::memory_order_relaxed);
+	m_nodesVisited.fetch_add(counter.m_nodesVisited, std::memory_order_relaxed);
+	m_entitiesTested.fetch_add(counter.m_entitiesTested, std::memory_order_relaxed);
+	m_entitiesReturned.fetch_add(counter.m_entitiesReturned, std::memory_order_relaxed);
+}
+
+//=============================================================================
+// Function: const bool search(const int,
+// const Rectangle&,
+// ISpatialVisitor<EntityData>&,
+// QueryCounter&) const
+// Description:
+// Visits all of the items which are inside the search area.
+// NOTE: This search function visits everything in the node
+// if the node is inside the search area.
+// Parameters:
+// const int node - The index of the node to search.
+// const Rectangle& searchArea - The area to search.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call.
+// QueryCounter& counter - Counts the work done by the search.
+// Output:
+// const bool
+// Returns false if the visitor stopped the search.
+//=============================================================================
+const bool Quadtree::search(const int node,
+	const Rectangle& searchArea,
+	ISpatialVisitor<EntityData>& visitor,
+	QueryCounter& counter) const
+{
+	const QuadNode& quadNode = m_nodes[node];
+
+	counter.m_nodesVisited++;
+
+	if (rectIntersectRect(quadNode.m_looseBounds, searchArea))
+	{
+		if (rectInsideRect(quadNode.m_looseBounds, searchArea))
+		{
+			return getData(node, visitor, counter);
+		}
+
+		if (quadNode.m_firstChild != NO_INDEX)
+		{
+			for (int i = 0; i < CHILD_COUNT; i++)
+			{
+				if (!search(quadNode.m_firstChild + i, searchArea, visitor, counter))
+				{
+					return false;
+				}
+			}
+		}
+
+		return searchEntities(node, searchArea, true, visitor, counter);
+	}
+
+	return true;
+}
+
+//=============================================================================
+// Function: const bool searchEntities(const int,
+// const Rectangle&,
+// const bool,
+// ISpatialVisitor<EntityData>&,
+// QueryCounter&) const
+// Description:
+// Visits the entities in a node that collide with the search area.
+// The node's list is read in batches and the axis aligned entities
+// in each batch are checked against the area's corners together.
+// Everything else goes through rectIntersectRect.
+// Parameters:
+// const int node - The node whose entities are checked.
+// const Rectangle& searchArea - The area to search.
+// const bool areaFirst - Whether the area is passed to
+// rectIntersectRect first, which matters once something is rotated.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call.
+// QueryCounter& counter - Counts the work done by the search.
+// Output:
+// const bool
+// Returns false if the visitor stopped the search.
+//=============================================================================
+const bool Quadtree::searchEntities(const int node,
+	const Rectangle& searchArea,
+	const bool areaFirst,
+	ISpatialVisitor<EntityData>& visitor,
+	QueryCounter& counter) const
+{
+	const bool aligned = searchArea.getRotation() == 0.0f;
+
+	Vector2D topLeft;
+	Vector2D bottomRight;
+
+	if (aligned)
+	{
+		topLeft = searchArea.getTopLeft();
+		bottomRight = searchArea.getBottomRight();
+	}
+
+	int batch[SEARCH_BATCH];
+
+	int slot = m_nodes[node].m_firstEntity;
+
+	while (slot != NO_INDEX)
+	{
+		int count = 0;
+
+		while (slot != NO_INDEX && count < SEARCH_BATCH)
+		{
+			batch[count] = slot;
+			count++;
+
+			slot = m_entities[slot].m_next;
+		}
+
+		counter.m_entitiesTested += count;
+
+		int hits = 0;
+
+		if (aligned)
+		{
+			hits = getOverlapMask(batch, count, topLeft.m_x, topLeft.m_y, bottomRight.m_x, bottomRight.m_y);
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			const EntityData& entity = m_entities[batch[i]].m_data;
+
+			bool inside = false;
+
+			if (aligned && m_slotAligned[batch[i]])
+			{
+				inside = (hits & (1 << i)) != 0;
+			}
+			else if (areaFirst)
+			{
+				inside = rectIntersectRect(searchArea, entity.m_size);
+			}
+			else
+			{
+				inside = rectIntersectRect(entity.m_size, searchArea);
+			}
+
+			if (inside)
+			{
+				counter.m_entitiesReturned++;
+
+				if (!visitor.visit(entity))
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+// Function: const int getOverlapMask(const int*,
+// const int,
+// const float,
+// const float,
+// const float,
+// const float) const
+// Description:
+// Checks a batch of slots' corners against an axis aligned area in
+// one go. The result for rotated slots is meaningless.
+// Parameters:
+// const int *slots - The slots to check.
+// const int count - How many slots there are, up to SEARCH_BATCH.
+// const float minX - The left of the area.
+// const float minY - The top of the area.
+// const float maxX - The right of the area.
+// const float maxY - The bottom of the area.
+// Output:
+// const int
+// Returns a mask with bit i set if slots[i] overlaps the area.
+//=============================================================================
+const int Quadtree::getOverlapMask(const int *slots,
+	const int count,
+	const float minX,
+	const float minY,
+	const float maxX,
+	const float maxY) const
+{
+	int mask = 0;
+
+#ifdef QUADTREE_SSE
+	// Short batches repeat the first slot, and the extra bits are
+	// masked off below.
+	int lanes[SEARCH_BATCH];
+
+	for (int i = 0; i < SEARCH_BATCH; i++)
+	{
+		lanes[i] = slots[i < count ? i : 0];
+	}
+
+	__m128 slotMinX = _mm_setr_ps(m_slotMinX[lanes[0]], m_slotMinX[lanes[1]], m_slotMinX[lanes[2]], m_slotMinX[lanes[3]]);
+	__m128 slotMinY = _mm_setr_ps(m_slotMinY[lanes[0]], m_slotMinY[lanes[1]], m_slotMinY[lanes[2]], m_slotMinY[lanes[3]]);
+	__m128 slotMaxX = _mm_setr_ps(m_slotMaxX[lanes[0]], m_slotMaxX[lanes[1]], m_slotMaxX[lanes[2]], m_slotMaxX[lanes[3]]);
+	__m128 slotMaxY = _mm_setr_ps(m_slotMaxY[lanes[0]], m_slotMaxY[lanes[1]], m_slotMaxY[lanes[2]], m_slotMaxY[lanes[3]]);
+
+	__m128 apart = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(slotMaxX, _mm_set1_ps(minX)),
+		_mm_cmplt_ps(_mm_set1_ps(maxX), slotMinX)),
+		_mm_or_ps(_mm_cmplt_ps(slotMaxY, _mm_set1_ps(minY)),
+		_mm_cmplt_ps(_mm_set1_ps(maxY), slotMinY)));
+
+	mask = ~_mm_movemask_ps(apart) & ((1 << count) - 1);
+#else
+	for (int i = 0; i < count; i++)
+	{
+		int slot = slots[i];
+
+		if (!(m_slotMaxX[slot] < minX ||
+			maxX < m_slotMinX[slot] ||
+			m_slotMaxY[slot] < minY ||
+			maxY < m_slotMinY[slot]))
+		{
+			mask |= 1 << i;
+		}
+	}
+#endif
+
+	return mask;
+}
+
+//=============================================================================
+// Function: const bool search(const int,
+// const Line&,
+// ISpatialVisitor<EntityData>&,
+// QueryCounter&) const
+// Description:
+// Searches along the search line and visits any entities that
+// collide with it.
+// Parameters:
+// const int node - The index of the node to search.
+// const Line& searchLine - The line to search along.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call.
+// QueryCounter& counter - Counts the work done by the search.
+// Output:
+// const bool
+// Returns false if the visitor stopped the search.
+//=============================================================================
+const bool Quadtree::search(const int node,
+	const Line& searchLine,
+	ISpatialVisitor<EntityData>& visitor,
+	QueryCounter& counter) const
+{
+	const QuadNode& quadNode = m_nodes[node];
+
+	counter.m_nodesVisited++;
+
+	if (lineInRect(quadNode.m_looseBounds, searchLine))
+	{
+		if (quadNode.m_firstChild != NO_INDEX)
+		{
+			for (int i = 0; i < CHILD_COUNT; i++)
+			{
+				if (!search(quadNode.m_firstChild + i, searchLine, visitor, counter))
+				{
+					return false;
+				}
+			}
+		}
+
+		int slot = quadNode.m_firstEntity;
+
+		while (slot != NO_INDEX)
+		{
+			counter.m_entitiesTested++;
+
+			if (lineInRect(m_entities[slot].m_data.m_size, searchLine))
+			{
+				counter.m_entitiesReturned++;
+
+				if (!visitor.visit(m_entities[slot].m_data))
+				{
+					return false;
+				}
+			}
+
+			slot = m_entities[slot].m_next;
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+// Function: const bool getData(const int,
+// ISpatialVisitor<EntityData>&,
+// QueryCounter&) const
+// Description:
+// Visits all of the data in the node and its children.
+// Parameters:
+// const int node - The index of the node to collect.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call.
+// QueryCounter& counter - Counts the work done by the search.
+// Output:
+// const bool
+// Returns false if the visitor stopped the search.
+//=============================================================================
+const bool Quadtree::getData(const int node,
+	ISpatialVisitor<EntityData>& visitor,
+	QueryCounter& counter) const
+{
+	const QuadNode& quadNode = m_nodes[node];
+
+	if (quadNode.m_firstChild != NO_INDEX)
+	{
+		for (int i = 0; i < CHILD_COUNT; i++)
+		{
+			counter.m_nodesVisited++;
+
+			if (!getData(quadNode.m_firstChild + i, visitor, counter))
+			{
+				return false;
+			}
+		}
+	}
+
+	int slot = quadNode.m_firstEntity;
+
+	while (slot != NO_INDEX)
+	{
+		counter.m_entitiesReturned++;
+
+		if (!visitor.visit(m_entities[slot].m_data))
+		{
+			return false;
+		}
+
+		slot = m_entities[slot].m_next;
+	}
+
+	return true;
+}
+
+//=============================================================================
+// Function: void nearest(const int,
+// const Vector2D&,
+// const int,
+// vector<EntityData>&) const
+// Description:
+// Offers the entities in a node to the nearest search, then the
+// children that could still hold something closer, closest first.
+// Parameters:
+// const int node - The node to search.
+// const Vector2D& point - The point to search from.
+// const int count - The most entities to find.
+// vector<EntityData>& nearest - The heap of entities kept so far.
+//=============================================================================
+void Quadtree::nearest(const int node,
+	const Vector2D& point,
+	const int count,
+	std::vector<EntityData>& nearest) const
+{
+	const QuadNode& quadNode = m_nodes[node];
+
+	int slot = quadNode.m_firstEntity;
+
+	while (slot != NO_INDEX)
+	{
+		keepNearest(m_entities[slot].m_data, point, count, nearest);
+
+		slot = m_entities[slot].m_next;
+	}
+
+	if (quadNode.m_firstChild != NO_INDEX)
+	{
+		int order[CHILD_COUNT];
+		float distances[CHILD_COUNT];
+
+		for (int i = 0; i < CHILD_COUNT; i++)
+		{
+			int child = quadNode.m_firstChild + i;
+			float distance = getNodeDistance(child, point);
+			int position = i;
+
+			while (0 < position && distance < distances[position - 1])
+			{
+				order[position] = order[position - 1];
+				distances[position] = distances[position - 1];
+				position--;
+			}
+
+			order[position] = child;
+			distances[position] = distance;
+		}
+
+		for (int i = 0; i < CHILD_COUNT; i++)
+		{
+			if (m_nodes[order[i]].m_totalCount != 0 &&
+				canBeNearer(distances[i], point, count, nearest))
+			{
+				this->nearest(order[i], point, count, nearest);
+			}
+		}
+	}
+}
+
+//=============================================================================
+// Function: const bool withinRadius(const int,
+// const Vector2D&,
+// const float,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Visits the entities in a node and its children whose centers are
+// within the radius.
+// Parameters:
+// const int node - The node to search.
+// const Vector2D& point - The center of the circle.
+// const float radiusSquared - The radius of the circle, squared.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call.
+// Output:
+// const bool
+// Returns false if the visitor stopped the search.
+//=============================================================================
+const bool Quadtree::withinRadius(const int node,
+	const Vector2D& point,
+	const float radiusSquared,
+	ISpatialVisitor<EntityData>& visitor) const
+{
+	const QuadNode& quadNode = m_nodes[node];
+
+	int slot = quadNode.m_firstEntity;
+
+	while (slot != NO_INDEX)
+	{
+		const EntityData& entity = m_entities[slot].m_data;
+
+		if (centerDistance(entity, point) <= radiusSquared &&
+			!visitor.visit(entity))
+		{
+			return false;
+		}
+
+		slot = m_entities[slot].m_next;
+	}
+
+	if (quadNode.m_firstChild != NO_INDEX)
+	{
+		for (int i = 0; i < CHILD_COUNT; i++)
+		{
+			int child = quadNode.m_firstChild + i;
+
+			if (m_nodes[child].m_totalCount != 0 &&
+				getNodeDistance(child, point) <= radiusSquared &&
+				!withinRadius(child, point, radiusSquared, visitor))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+// Function: const float getNodeDistance(const int,
+// const Vector2D&) const
+// Description:
+// Gets the squared distance from a point to the closest place an
+// entity center in the node could be. The bounds are padded by a
+// pixel since placing a center rounds it.
+// Parameters:
+// const int node - The node to measure to.
+// const Vector2D& point - The point to measure from.
+// Output:
+// const float
+// Returns the squared distance, 0 if the point is inside.
+//=============================================================================
+const float Quadtree::getNodeDistance(const int node,
+	const Vector2D& point) const
+{
+	const Rectangle& bounds = m_nodes[node].m_bounds;
+
+	float x = 0.0f;
+	float y = 0.0f;
+
+	fMax(x, bounds.getMinX() - 1.0f - point.m_x, point.m_x - bounds.getMaxX() - 1.0f);
+	fMax(y, bounds.getMinY() - 1.0f - point.m_y, point.m_y - bounds.getMaxY() - 1.0f);
+	fMax(x, x, 0.0f);
+	fMax(y, y, 0.0f);
+
+	return (x * x) + (y * y);
+}
+
+//=============================================================================
+// Function: const bool findPairs(const int,
+// const vector<NodeExtent>&,
+// ISpatialPairVisitor<EntityData>&) const
+// Description:
+// Visits the overlapping pairs with an entity in this node, then
+// the pairs split between its children, then moves on to the
+// children.
+// Parameters:
+// const int node - The node to search.
+// const vector<NodeExtent>& extents - The extents of every subtree.
+// ISpatialPairVisitor<EntityData>& visitor - The visitor to call.
+// Output:
+// const bool
+// Returns false if the visitor stopped the search.
+//=============================================================================
+const bool Quadtree::findPairs(const int node,
+	const std::vector<NodeExtent>& extents,
+	ISpatialPairVisitor<EntityData>& visitor) const
+{
+	const QuadNode& quadNode = m_nodes[node];
+
+	int slot = quadNode.m_firstEntity;
+
+	while (slot != NO_INDEX)
+	{
+		const EntityData& entity = m_entities[slot].m_data;
+
+		int other = m_entities[slot].m_next;
+
+		while (other != NO_INDEX)
+		{
+			if (pairOverlaps(entity, m_entities[other].m_data) &&
+				!visitor.visit(entity, m_entities[other].m_data))
+			{
+				return false;
+			}
+
+			other = m_entities[other].m_next;
+		}
+
+		if (quadNode.m_firstChild != NO_INDEX)
+		{
+			for (int i = 0; i < CHILD_COUNT; i++)
+			{
+				if (!findPairs(quadNode.m_firstChild + i, entity, extents, visitor))
+				{
+					return false;
+				}
+			}
+		}
+
+		slot = m_entities[slot].m_next;
+	}
+
+	if (quadNode.m_firstChild != NO_INDEX)
+	{
+		for (int i = 0; i < CHILD_COUNT; i++)
+		{
+			for (int j = i + 1; j < CHILD_COUNT; j++)
+			{
+				if (!findCrossPairs(quadNode.m_firstChild + i, quadNode.m_firstChild + j, extents, visitor))
+				{
+					return false;
+				}
+			}
+		}
+
+		for (int i = 0; i < CHILD_COUNT; i++)
+		{
+			if (m_nodes[quadNode.m_firstChild + i].m_totalCount != 0 &&
+				!findPairs(quadNode.m_firstChild + i, extents, visitor))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+// Function: const bool findPairs(const int,
+// const EntityData&,
+// const vector<NodeExtent>&,
+// ISpatialPairVisitor<EntityData>&) const
+// Description:
+// Visits the entities in this node and its children that overlap
+// an entity from higher up the tree. Subtrees the entity doesn't
+// reach are skipped.
+// Parameters:
+// const int node - The node to search.
+// const EntityData& entity - The entity from higher up the tree.
+// const vector<NodeExtent>& extents - The extents of every subtree.
+// ISpatialPairVisitor<EntityData>& visitor - The visitor to call.
+// Output:
+// const bool
+// Returns false if the visitor stopped the search.
+//=============================================================================
+const bool Quadtree::findPairs(const int node,
+	const EntityData& entity,
+	const std::vector<NodeExtent>& extents,
+	ISpatialPairVisitor<EntityData>& visitor) const
+{
+	const QuadNode& quadNode = m_nodes[node];
+
+	if (quadNode.m_totalCount != 0 &&
+		extentsOverlap(extents[node], NodeExtent(entity.m_size)))
+	{
+		int slot = quadNode.m_firstEntity;
+
+		while (slot != NO_INDEX)
+		{
+			if (pairOverlaps(entity, m_entities[slot].m_data) &&
+				!visitor.visit(entity, m_entities[slot].m_data))
+			{
+				return false;
+			}
+
+			slot = m_entities[slot].m_next;
+		}
+
+		if (quadNode.m_firstChild != NO_INDEX)
+		{
+			for (int i = 0; i < CHILD_COUNT; i++)
+			{
+				if (!findPairs(quadNode.m_firstChild + i, entity, extents, visitor))
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+// Function: const bool findCrossPairs(const int,
+// const int,
+// const vector<NodeExtent>&,
+// ISpatialPairVisitor<EntityData>&) const
+// Description:
+// Visits the overlapping pairs that have one entity in the first
+// subtree and the other in the second. The entities in each node
+// are tested against the other subtree, then the children are
+// paired up where their extents meet.
+// Parameters:
+// const int first - The root of the first subtree.
+// const int second - The root of the second subtree.
+// const vector<NodeExtent>& extents - The extents of every subtree.
+// ISpatialPairVisitor<EntityData>& visitor - The visitor to call.
+// Output:
+// const bool
+// Returns false if the visitor stopped the search.
+//=============================================================================
+const bool Quadtree::findCrossPairs(const int first,
+	const int second,
+	const std::vector<NodeExtent>& extents,
+	ISpatialPairVisitor<EntityData>& visitor) const
+{
+	const QuadNode& firstNode = m_nodes[first];
+	const QuadNode& secondNode = m_nodes[second];
+
+	if (firstNode.m_totalCount != 0 &&
+		secondNode.m_totalCount != 0 &&
+		extentsOverlap(extents[first], extents[second]))
+	{
+		// The first node's entities against all of the second subtree.
+		int slot = firstNode.m_firstEntity;
+
+		while (slot != NO_INDEX)
+		{
+			if (!findPairs(second, m_entities[slot].m_data, extents, visitor))
+			{
+				return false;
+			}
+
+			slot = m_entities[slot].m_next;
+		}
+
+		if (firstNode.m_firstChild != NO_INDEX)
+		{
+			// The second node's entities against the first node's
+			// children, since the first node itself is done.
+			slot = secondNode.m_firstEntity;
+
+			while (slot != NO_INDEX)
+			{
+				for (int i = 0; i < CHILD_COUNT; i++)
+				{
+					if (!findPairs(firstNode.m_firstChild + i, m_entities[slot].m_data, extents, visitor))
+					{
+						return false;
+					}
+				}
+
+				slot = m_entities[slot].m_next;
+			}
+
+			if (secondNode.m_firstChild != NO_INDEX)
+			{
+				for (int i = 0; i < CHILD_COUNT; i++)
+				{
+					for (int j = 0; j < CHILD_COUNT; j++)
+					{
+						if (!findCrossPairs(firstNode.m_firstChild + i, secondNode.m_firstChild + j, extents, visitor))
+						{
+							return false;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+//=============================================================================
+// Function: void findExtents(const int, vector<NodeExtent>&) const
+// Description:
+// Finds the box around every entity in a node and its children.
+// Entities in a tight tree can hang past their node, so the pair
+// search prunes with these instead of the node bounds.
+// Parameters:
+// const int node - The node to measure.
+// vector<NodeExtent>& extents - Filled in for the node and its
+// children.
+//=============================================================================
+void Quadtree::findExtents(const int node,
+	std::vector<NodeExtent>& extents) const
+{
+	const QuadNode& quadNode = m_nodes[node];
+
+	NodeExtent extent;
+
+	int slot = quadNode.m_firstEntity;
+
+	while (slot != NO_INDEX)
+	{
+		extent.add(NodeExtent(m_entities[slot].m_data.m_size));
+
+		slot = m_entities[slot].m_next;
+	}
+
+	if (quadNode.m_firstChild != NO_INDEX)
+	{
+		for (int i = 0; i < CHILD_COUNT; i++)
+		{
+			int child = quadNode.m_firstChild + i;
+
+			if (m_nodes[child].m_totalCount != 0)
+			{
+				findExtents(child, extents);
+
+				extent.add(extents[child]);
+			}
+		}
+	}
+
+	extents[node] = extent;
+}
+
+//=============================================================================
+// Function: bool extentsOverlap(const NodeExtent&, const NodeExtent&)
+// Description:
+// Checks if two extents overlap. There's the same pixel of slack
+// pairOverlaps gives bounding boxes, so nothing it would accept is
+// pruned.
+// Parameters:
+// const NodeExtent& a - The first extent.
+// const NodeExtent& b - The second extent.
+// Output:
+// bool
+// Returns true if the extents could hold an overlapping pair.
+//=============================================================================
+bool Quadtree::extentsOverlap(const NodeExtent& a,
+	const NodeExtent& b)
+{
+	return a.m_minX <= b.m_maxX + 2.0f &&
+		b.m_minX <= a.m_maxX + 2.0f &&
+		a.m_minY <= b.m_maxY + 2.0f &&
+		b.m_minY <= a.m_maxY + 2.0f;
+}
+
+//=============================================================================
+// Function: void raycast(const int,
+// const float,
+// const Line&,
+// const ISpatialFilter<EntityData>*,
+// RaycastHit&,
+// bool&) const
+// Description:
+// Checks the entities in a node against the ray, then the children
+// the ray passes through from front to back.
+// Parameters:
+// const int node - The node to check.
+// const float enterTime - Where the ray enters the node.
+// const Line& ray - The ray to cast.
+// const ISpatialFilter<EntityData> *filter - The filter, or NULL.
+// RaycastHit& hit - The closest hit so far.
+// bool& found - Whether anything has been hit so far.
+//=============================================================================
+void Quadtree::raycast(const int node,
+	const float enterTime,
+	const Line& ray,
+	const ISpatialFilter<EntityData> *filter,
+	RaycastHit& hit,
+	bool& found) const
+{
+	if (!found ||
+		enterTime <= hit.m_time ||
+		m_looseness <= 1.0f)
+	{
+		const QuadNode& quadNode = m_nodes[node];
+
+		int slot = quadNode.m_firstEntity;
+
+		while (slot != NO_INDEX)
+		{
+			checkRayHit(m_entities[slot].m_data, ray, filter, hit, found);
+
+			slot = m_entities[slot].m_next;
+		}
+
+		if (quadNode.m_firstChild != NO_INDEX)
+		{
+			int order[CHILD_COUNT];
+			float times[CHILD_COUNT];
+			int count = 0;
+
+			float time = 0.0f;
+			Vector2D normal;
+
+			// Sort the children the ray passes through by when it
+			// reaches them.
+			for (int i = 0; i < CHILD_COUNT; i++)
+			{
+				int child = quadNode.m_firstChild + i;
+
+				if (rayIntersectRect(m_nodes[child].m_looseBounds, ray, time, normal))
+				{
+					int position = count;
+
+					while (0 < position && time < times[position - 1])
+					{
+						order[position] = order[position - 1];
+						times[position] = times[position - 1];
+						position--;
+					}
+
+					order[position] = child;
+					times[position] = time;
+					count++;
+				}
+			}
+
+			for (int i = 0; i < count; i++)
+			{
+				raycast(order[i], times[i], ray, filter, hit, found);
+			}
+		}
+	}
+}
+
+//=============================================================================
+// Function: void insertEntity(const int, const int)
+// Description:
+// Places an entity slot in the deepest node that will take it,
+// splitting the node and pushing its entities down if it's full.
+// Parameters:
+// const int node - The node to start from.
+// const int slot - The entity slot to place.
+//=============================================================================
+void Quadtree::insertEntity(const int node,
+	const int slot)
+{
+	const Rectangle& size = m_entities[slot].m_data.m_size;
+
+	int current = node;
+
+	while (m_nodes[current].m_firstChild != NO_INDEX)
+	{
+		int index = getChildIndex(current, size);
+
+		if (index == THIS_TREE)
+		{
+			break;
+		}
+
+		current = m_nodes[current].m_firstChild + index;
+	}
+
+	linkEntity(current, slot);
+
+	if (m_maxObjects < m_nodes[current].m_entityCount &&
+		m_nodes[current].m_firstChild == NO_INDEX)
+	{
+		if (split(current))
+		{
+			int working = m_nodes[current].m_firstEntity;
+
+			while (working != NO_INDEX)
+			{
+				int next = m_entities[working].m_next;
+				int index = getChildIndex(current, m_entities[working].m_data.m_size);
+
+				if (index != THIS_TREE)
+				{
+					unlinkEntity(working);
+					insertEntity(m_nodes[current].m_firstChild + index, working);
+				}
+
+				working = next;
+			}
+		}
+	}
+}
+
+//=============================================================================
+// Function: void linkEntity(const int, const int)
+// Description:
+// Appends an entity slot to a node and counts it in the totals of
+// the node and its parents.
+// Parameters:
+// const int node - The node to add to.
+// const int slot - The slot to link.
+//=============================================================================
+void Quadtree::linkEntity(const int node,
+	const int slot)
+{
+	appendEntity(node, slot);
+
+	for (int current = node; current != NO_INDEX; current = m_nodes[current].m_parent)
+	{
+		m_nodes[current].m_totalCount++;
+	}
+}
+
+//=============================================================================
+// Function: void appendEntity(const int, const int)
+// Description:
+// Appends an entity slot to the end of a node's entity list without
+// touching the totals.
+// Parameters:
+// const int node - The node to add to.
+// const int slot - The slot to append.
+//=============================================================================
+void Quadtree::appendEntity(const int node,
+	const int slot)
+{
+	QuadNode& quadNode = m_nodes[node];
+	EntitySlot& entitySlot = m_entities[slot];
+
+	entitySlot.m_node = node;
+	entitySlot.m_previous = quadNode.m_lastEntity;
+	entitySlot.m_next = NO_INDEX;
+
+	if (quadNode.m_lastEntity == NO_INDEX)
+	{
+		quadNode.m_firstEntity = slot;
+	}
+	else
+	{
+		m_entities[quadNode.m_lastEntity].m_next = slot;
+	}
+
+	quadNode.m_lastEntity = slot;
+	quadNode.m_entityCount++;
+}
+
+//=============================================================================
+// Function: void unlinkEntity(const int)
+// Description:
+// Takes an entity slot out of the entity list of its node.
+// Parameters:
+// const int slot - The slot to unlink.
+//=============================================================================
+void Quadtree::unlinkEntity(const int slot)
+{
+	EntitySlot& entitySlot = m_entities[slot];
+	QuadNode& quadNode = m_nodes[entitySlot.m_node];
+
+	if (entitySlot.m_previous == NO_INDEX)
+	{
+		quadNode.m_firstEntity = entitySlot.m_next;
+	}
+	else
+	{
+		m_entities[entitySlot.m_previous].m_next = entitySlot.m_next;
+	}
+
+	if (entitySlot.m_next == NO_INDEX)
+	{
+		quadNode.m_lastEntity = entitySlot.m_previous;
+	}
+	else
+	{
+		m_entities[entitySlot.m_next].m_previous = entitySlot.m_previous;
+	}
+
+	quadNode.m_entityCount--;
+
+	for (int current = entitySlot.m_node; current != NO_INDEX; current = m_nodes[current].m_parent)
+	{
+		m_nodes[current].m_totalCount--;
+	}
+
+	entitySlot.m_node = NO_INDEX;
+	entitySlot.m_previous = NO_INDEX;
+	entitySlot.m_next = NO_INDEX;
+}
+
+//=============================================================================
+// Function: const int createSlot(const EntityData&)
+// Description:
+// Stores the entity in the slab, reusing a freed slot if one exists.
+// Parameters:
+// const EntityData& entity - The entity to store.
+// Output:
+// const int
+// Returns the index of the slot.
+//=============================================================================
+const int Quadtree::createSlot(const EntityData& entity)
+{
+	int slot = m_freeEntity;
+
+	if (slot != NO_INDEX)
+	{
+		m_freeEntity = m_entities[slot].m_next;
+
+		m_entities[slot] = EntitySlot(entity);
+	}
+	else
+	{
+		slot = (int)m_entities.size();
+
+		m_entities.emplace_back(EntitySlot(entity));
+
+		m_slotMinX.emplace_back(0.0f);
+		m_slotMinY.emplace_back(0.0f);
+		m_slotMaxX.emplace_back(0.0f);
+		m_slotMaxY.emplace_back(0.0f);
+		m_slotAligned.emplace_back(0);
+	}
+
+	setSlotBounds(slot);
+
+	return slot;
 }
 
-Quadtree::~Quadtree()
+//=============================================================================
+// Function: void releaseSlot(const int)
+// Description:
+// Returns a slot to the free list so it can be reused.
+// Parameters:
+// const int slot - The slot to release.
+//=============================================================================
+void Quadtree::releaseSlot(const int slot)
 {
-	cleanUp();
+	m_entities[slot].m_next = m_freeEntity;
+	m_freeEntity = slot;
 }
 
 //=============================================================================
-// Function: const int getWidth() const
+// Function: void setSlotBounds(const int)
 // Description:
-// Gets the width of the Quadtree.
-// Output:
-// const int
-// Returns width.
+// Copies the corners of a slot's entity into the corner arrays. They
+// match what rectIntersectRect works out for an axis aligned
+// rectangle, so the batched check gives the same answer.
+// Parameters:
+// const int slot - The slot whose entity changed.
 //=============================================================================
-const int Quadtree::getWidth() const
+void Quadtree::setSlotBounds(const int slot)
 {
-	return m_bounds.getWidth();
+	const Rectangle& size = m_entities[slot].m_data.m_size;
+
+	Vector2D topLeft = size.getTopLeft();
+	Vector2D bottomRight = size.getBottomRight();
+
+	m_slotMinX[slot] = topLeft.m_x;
+	m_slotMinY[slot] = topLeft.m_y;
+	m_slotMaxX[slot] = bottomRight.m_x;
+	m_slotMaxY[slot] = bottomRight.m_y;
+	m_slotAligned[slot] = size.getRotation() == 0.0f;
 }
 
 //=============================================================================
-// Function: const int getHeight() const
+// Function: void resizeSlot(const int, const Rectangle&)
 // Description:
-// Gets the height of the Quadtree.
-// Output:
-// const int
-// Returns height.
+// Changes the size of a slot's entity. If it still belongs in the
+// same node it's updated in place, otherwise it walks up the parents
+// to the deepest node that still holds it and is placed from there.
+// Parameters:
+// const int slot - The slot of the entity to update.
+// const Rectangle& size - The new size.
 //=============================================================================
-const int Quadtree::getHeight() const
+void Quadtree::resizeSlot(const int slot,
+	const Rectangle& size)
 {
-	return m_bounds.getHeight();
+	int node = m_entities[slot].m_node;
+	int home = getContainingNode(node, size);
+
+	m_entities[slot].m_data.m_size = size;
+	setSlotBounds(slot);
+
+	if (home != node ||
+		getChildIndex(node, size) != THIS_TREE)
+	{
+		unlinkEntity(slot);
+		insertEntity(home, slot);
+
+		collapse(node);
+	}
 }
 
 //=============================================================================
-// Function: vector<EntityData> search(const Rectangle&) const
+// Function: void renderNode(const int,
+// Renderer*,
+// const Vector2D&,
+// const float,
+// const float) const
 // Description:
-// Searches the tree for any entities inside the specified rectangle.
+// Draws the node if it's a leaf, otherwise draws its children.
 // Parameters:
-// const Rectangle& searchArea - The area to search inside.
-// Output:
-// vector<EntityData> Returns a vector filled with all of the
-// entities inside the search area.
+// const int node - The node to draw.
+// Renderer *renderer - The renderer to draw with.
+// const Vector2D& offset - The camera offset.
+// const float xScale - The horizontal scale.
+// const float yScale - The vertical scale.
 //=============================================================================
-std::vector<EntityData> Quadtree::search(const Rectangle& searchArea) const
+void Quadtree::renderNode(const int node,
+	Renderer *renderer,
+	const Vector2D& offset,
+	const float xScale,
+	const float yScale) const
 {
-	std::vector<EntityData> data;
+	const QuadNode& quadNode = m_nodes[node];
 
-	if (rectIntersectRect(m_bounds, searchArea))
+	if (quadNode.m_firstChild != NO_INDEX)
 	{
-		if (m_children[0] != nullptr)
-		{
-			for (int i = 0; i <= CHILD_SW; i++)
-			{
-				m_children[i]->search(searchArea, data);
-			}
-		}
-
-		for (unsigned int i = 0; i < m_data.size(); i++)
+		for (int i = 0; i < CHILD_COUNT; i++)
 		{
-			if (rectIntersectRect(m_data[i].m_size, searchArea))
-			{
-				data.emplace_back(m_data[i]);
-			}
+			renderNode(quadNode.m_firstChild + i, renderer, offset, xScale, yScale);
 		}
 	}
+	else
+	{
+		SDL_Color red{ 255, 0, 0, 255 };
 
-	return data;
+		renderer->drawRect(getScreenRect(quadNode.m_bounds, offset, xScale, yScale), red, false);
+	}
 }
 
 //=============================================================================
-// Function: vector<EntityData> search(const Line&) const
+// Function: void renderOccupancyNode(const int,
+// Renderer*,
+// const Vector2D&,
+// const float,
+// const float) const
 // Description:
-// Searches for all entities that intersect the line and returns them.
+// Fills the node by how full it is, then draws its children.
 // Parameters:
-// const Line& 
-// Output:
-// vector<EntityData>
-// Returns a vector filled with the entity data of all entities found.
+// const int node - The node to draw.
+// Renderer *renderer - The renderer to draw with.
+// const Vector2D& offset - The camera offset.
+// const float xScale - The horizontal scale.
+// const float yScale - The vertical scale.
 //=============================================================================
-std::vector<EntityData> Quadtree::search(const Line& searchLine) const
+void Quadtree::renderOccupancyNode(const int node,
+	Renderer *renderer,
+	const Vector2D& offset,
+	const float xScale,
+	const float yScale) const
 {
-	std::vector<EntityData> data;
+	const QuadNode& quadNode = m_nodes[node];
 
-	if (lineInRect(m_bounds, searchLine))
+	if (0 < quadNode.m_entityCount)
 	{
-		if (m_children[0] != nullptr)
-		{
-			m_children[CHILD_NW]->search(searchLine, data);
-			m_children[CHILD_NE]->search(searchLine, data);
-			m_children[CHILD_SE]->search(searchLine, data);
-			m_children[CHILD_SW]->search(searchLine, data);
-		}
+		float load = (float)quadNode.m_entityCount / (float)m_maxObjects;
+
+		clamp(load, 0.0f, 1.0f);
 
-		for (unsigned int i = 0; i < m_data.size(); i++)
+		SDL_Color heat{ 255, (Uint8)(255.0f * (1.0f - load)), 0, (Uint8)(32.0f + (191.0f * load)) };
+
+		renderer->drawRect(getScreenRect(quadNode.m_bounds, offset, xScale, yScale), heat, true);
+	}
+
+	if (quadNode.m_firstChild != NO_INDEX)
+	{
+		for (int i = 0; i < CHILD_COUNT; i++)
 		{
-			if (lineInRect(m_data[i].m_size, searchLine))
-			{
-				data.emplace_back(m_data[i]);
-			}
+			renderOccupancyNode(quadNode.m_firstChild + i, renderer, offset, xScale, yScale);
 		}
 	}
+}
+
+//=============================================================================
+// Function: const Rectangle getScreenRect(const Rectangle&,
+// const Vector2D&,
+// const float,
+// const float) const
+// Description:
+// Moves a node's bounds into screen space for drawing.
+// Parameters:
+// const Rectangle& bounds - The bounds to move.
+// const Vector2D& offset - The camera offset.
+// const float xScale - The horizontal scale.
+// const float yScale - The vertical scale.
+// Output:
+// const Rectangle
+// Returns the bounds on screen.
+//=============================================================================
+const Rectangle Quadtree::getScreenRect(const Rectangle& bounds,
+	const Vector2D& offset,
+	const float xScale,
+	const float yScale) const
+{
+	Vector2D center = bounds.getCenter();
 
-	return data;
+	center.m_x *= xScale;
+	center.m_y *= yScale;
+
+	center -= offset;
+
+	return Rectangle(center,
+		bounds.getWidth() * xScale,
+		bounds.getHeight() * yScale);
 }
 
 //=============================================================================
-// Function: void addEntity(const EntityData&)
+// Function: void writeOccupancyNode(const int, ostream&) const
 // Description:
-// Adds an entity to the tree.
+// Writes the node's line of the occupancy CSV, then its children's.
 // Parameters:
-// const EntityData& entity - The entity to add to the quad tree.
+// const int node - The node to write.
+// ostream& out - The stream to write to.
 //=============================================================================
-void Quadtree::addEntity(const EntityData& entity)
+void Quadtree::writeOccupancyNode(const int node,
+	std::ostream& out) const
 {
-	if (m_children[0] != nullptr)
-	{
-		int index = getChildIndex(entity.m_size.getCenter());
+	const QuadNode& quadNode = m_nodes[node];
+	const Rectangle& bounds = quadNode.m_bounds;
 
-		if (index != THIS_TREE)
+	out << quadNode.m_level << ","
+		<< (quadNode.m_firstChild == NO_INDEX ? 1 : 0) << ","
+		<< bounds.getMinX() << ","
+		<< bounds.getMinY() << ","
+		<< bounds.getMaxX() << ","
+		<< bounds.getMaxY() << ","
+		<< quadNode.m_entityCount << ","
+		<< quadNode.m_totalCount << "\n";
+
+	if (quadNode.m_firstChild != NO_INDEX)
+	{
+		for (int i = 0; i < CHILD_COUNT; i++)
 		{
-			m_children[index]->addEntity(entity);
-			return;
+			writeOccupancyNode(quadNode.m_firstChild + i, out);
 		}
 	}
+}
 
-	m_data.emplace_back(entity);
+//=============================================================================
+// Function: const bool split(const int)
+// Description:
+// Splits the node into 4 leafs if it's possible. The children are
+// stored in the node pool side by side, reusing a freed block of
+// children when there is one.
+// Parameters:
+// const int node - The node to split.
+// Output:
+// const bool
+// Returns true if the node was split.
+// Returns false if the node can't be split.
+//=============================================================================
+const bool Quadtree::split(const int node)
+{
+	bool success = false;
 
-	if (m_maxObjects < (int)m_data.size() && 
-		m_children[0] == nullptr)
+	if (m_nodes[node].m_firstChild == NO_INDEX &&
+		m_nodes[node].m_level < m_maxLevels)
 	{
-		split();
+		const Rectangle bounds = m_nodes[node].m_bounds;
+		const int level = m_nodes[node].m_level + 1;
+
+		int halfWidth = bounds.getWidth() / 2;
+		int halfHeight = bounds.getHeight() / 2;
+		Vector2D center = bounds.getCenter();
 
-		auto vit = m_data.begin();
+		float xOffset = (float)(halfWidth / 2);
+		float yOffset = (float)(halfHeight / 2);
 
-		while (vit != m_data.end())
+		int firstChild = m_freeNode;
+
+		Rectangle childBounds[CHILD_COUNT]{
+			Rectangle(Vector2D(center.m_x - xOffset, center.m_y - yOffset), halfWidth, halfHeight),
+			Rectangle(Vector2D(center.m_x + xOffset, center.m_y - yOffset), halfWidth, halfHeight),
+			Rectangle(Vector2D(center.m_x + xOffset, center.m_y + yOffset), halfWidth, halfHeight),
+			Rectangle(Vector2D(center.m_x - xOffset, center.m_y + yOffset), halfWidth, halfHeight) };
+
+		if (firstChild != NO_INDEX)
 		{
-			int index = getChildIndex(vit->m_size.getCenter());
+			m_freeNode = m_nodes[firstChild].m_firstChild;
 
-			if (index != THIS_TREE)
+			for (int i = 0; i < CHILD_COUNT; i++)
 			{
-				m_children[index]->addEntity(*vit);
-				
-				vit = m_data.erase(vit);
+				m_nodes[firstChild + i] = QuadNode(childBounds[i], getLooseBounds(childBounds[i]), node, level);
 			}
-			else
+		}
+		else
+		{
+			firstChild = (int)m_nodes.size();
+
+			for (int i = 0; i < CHILD_COUNT; i++)
 			{
-				vit++;
+				m_nodes.emplace_back(QuadNode(childBounds[i], getLooseBounds(childBounds[i]), node, level));
 			}
 		}
+
+		m_nodes[node].m_firstChild = firstChild;
+
+		success = true;
 	}
+
+	return success;
 }
 
 //=============================================================================
-// Function: void removeEntity(const EntityData&)
+// Function: void collapse(const int)
 // Description:
-// Finds and removes an entity from the quad tree.
+// Walks from a node up to the root after entities have left it and
+// merges the highest subtree that has dropped to the merge limit.
+// The merge limit is half of the split limit so a node on the edge
+// doesn't keep splitting and merging.
 // Parameters:
-// const EntityData& entity - The entity to remove.
+// const int node - The node entities were taken out of.
 //=============================================================================
-void Quadtree::removeEntity(const EntityData& entity)
+void Quadtree::collapse(const int node)
 {
-	if (m_children[0] != nullptr)
-	{
-		int index = getChildIndex(entity.m_size.getCenter());
+	int target = NO_INDEX;
 
-		if (index != THIS_TREE)
+	for (int current = node; current != NO_INDEX; current = m_nodes[current].m_parent)
+	{
+		if (m_nodes[current].m_firstChild != NO_INDEX &&
+			m_nodes[current].m_totalCount <= m_mergeObjects)
 		{
-			m_children[index]->removeEntity(entity);
-			return;
+			target = current;
 		}
 	}
 
-	auto vit = m_data.begin();
-
-	while (vit != m_data.end())
+	if (target != NO_INDEX)
 	{
-		if (vit->m_id == entity.m_id)
-		{
-			vit = m_data.erase(vit);
-			break;
-		}
-		else
+		int firstChild = m_nodes[target].m_firstChild;
+
+		for (int i = 0; i < CHILD_COUNT; i++)
 		{
-			vit++;
+			absorbNode(target, firstChild + i);
 		}
+
+		releaseChildren(target);
 	}
 }
 
-void Quadtree::renderTree(Renderer *renderer, 
-	const Vector2D& offset,
-	const float xScale,
-	const float yScale)
+//=============================================================================
+// Function: void absorbNode(const int, const int)
+// Description:
+// Moves every entity in a node and its children into the target
+// node and frees the children. The target has to be an ancestor,
+// so the total counts along the way don't change.
+// Parameters:
+// const int target - The node taking the entities.
+// const int node - The node giving them up.
+//=============================================================================
+void Quadtree::absorbNode(const int target,
+	const int node)
 {
-	if (m_children[0] != nullptr)
+	int firstChild = m_nodes[node].m_firstChild;
+
+	if (firstChild != NO_INDEX)
 	{
-		m_children[CHILD_NW]->renderTree(renderer, offset, xScale, yScale);
-		m_children[CHILD_NE]->renderTree(renderer, offset, xScale, yScale);
-		m_children[CHILD_SE]->renderTree(renderer, offset, xScale, yScale);
-		m_children[CHILD_SW]->renderTree(renderer, offset, xScale, yScale);
+		for (int i = 0; i < CHILD_COUNT; i++)
+		{
+			absorbNode(target, firstChild + i);
+		}
+
+		releaseChildren(node);
 	}
-	else
-	{
-		SDL_Color red{ 255, 0, 0, 255 };
 
-		Vector2D center = m_bounds.getCenter();
+	int slot = m_nodes[node].m_firstEntity;
 
-		center.m_x *= xScale;
-		center.m_y *= yScale;
+	while (slot != NO_INDEX)
+	{
+		int next = m_entities[slot].m_next;
 
-		center -= offset;
+		appendEntity(target, slot);
 
-		Rectangle scaled(center, m_bounds.getWidth() * xScale, m_bounds.getHeight() * yScale);
-		renderer->drawRect(scaled, red, false);
+		slot = next;
 	}
+
+	m_nodes[node].m_firstEntity = NO_INDEX;
+	m_nodes[node].m_lastEntity = NO_INDEX;
+	m_nodes[node].m_entityCount = 0;
+	m_nodes[node].m_totalCount = 0;
 }
 
 //=============================================================================
-// Function: void cleanUp()
+// Function: void releaseChildren(const int)
 // Description:
-// Cleans up all of the nodes.
+// Puts the block of children of a node on the free list and turns
+// the node back into a leaf. The children have to be empty leafs.
+// Parameters:
+// const int node - The node to release the children of.
 //=============================================================================
-void Quadtree::cleanUp()
+void Quadtree::releaseChildren(const int node)
+{
+	int firstChild = m_nodes[node].m_firstChild;
+
+	m_nodes[firstChild].m_firstChild = m_freeNode;
+	m_freeNode = firstChild;
+
+	m_nodes[node].m_firstChild = NO_INDEX;
+}
+
+//=============================================================================
+// Function: void collectStats(const int, QuadtreeStats&) const
+// Description:
+// Adds a node and all of its children to the stats.
+// Parameters:
+// const int node - The node to count.
+// QuadtreeStats& stats - The stats to add to.
+//=============================================================================
+void Quadtree::collectStats(const int node,
+	QuadtreeStats& stats) const
 {
-	if (m_children[0] != nullptr)
+	const QuadNode& quadNode = m_nodes[node];
+
+	stats.m_nodeCount++;
+	stats.m_entityCount += quadNode.m_entityCount;
+
+	if (stats.m_depth < quadNode.m_level)
+	{
+		stats.m_depth = quadNode.m_level;
+	}
+
+	if ((int)stats.m_depthNodes.size() <= quadNode.m_level)
+	{
+		stats.m_depthNodes.resize(quadNode.m_level + 1, 0);
+		stats.m_depthEntities.resize(quadNode.m_level + 1, 0);
+	}
+
+	stats.m_depthNodes[quadNode.m_level]++;
+	stats.m_depthEntities[quadNode.m_level] += quadNode.m_entityCount;
+
+	if (stats.m_occupancy.empty())
+	{
+		stats.m_occupancy.resize(m_maxObjects + 2, 0);
+	}
+
+	int bucket = quadNode.m_entityCount;
+
+	iMin(bucket, bucket, m_maxObjects + 1);
+
+	stats.m_occupancy[bucket]++;
+
+	if (quadNode.m_firstChild != NO_INDEX)
 	{
-		for (int i = 0; i <= CHILD_SW; i++)
+		for (int i = 0; i < CHILD_COUNT; i++)
 		{
-			m_children[i].reset();
+			collectStats(quadNode.m_firstChild + i, stats);
 		}
 	}
+	else
+	{
+		stats.m_leafCount++;
+	}
 }
 
 //=============================================================================
-// Function: void search(const Rectangle&, 
-// vector<EntityData>&) const
+// Function: void sortByMorton(const vector<EntityData>&,
+// vector<MortonEntry>&,
+// ThreadPool*) const
 // Description:
-// Adds all of the items which are inside the search area.
-// NOTE: This search function adds everything in the node
-// If the node is inside the node.
+// Works out the Z-order code of every entity's center inside the
+// root and sorts them by it. With a pool each thread sorts a chunk
+// and the chunks are then merged in pairs.
 // Parameters:
-// const Rectangle& searchArea - The area to search.
-// vector<EntityData>& data - The data to fill.
+// const vector<EntityData>& entities - The entities to sort.
+// vector<MortonEntry>& sorted - Filled with the codes and the index
+// of each entity, in order. Has to be the same size as entities.
+// ThreadPool *pool - The pool to use, or NULL.
 //=============================================================================
-void Quadtree::search(const Rectangle& searchArea,
-	std::vector<EntityData>& data) const
+void Quadtree::sortByMorton(const std::vector<EntityData>& entities,
+	std::vector<MortonEntry>& sorted,
+	ThreadPool *pool) const
 {
-	if (rectIntersectRect(m_bounds, searchArea))
+	const Rectangle& bounds = m_nodes[ROOT].m_bounds;
+	const int count = (int)entities.size();
+
+	const float minX = bounds.getMinX();
+	const float minY = bounds.getMinY();
+	const float xScale = 65535.0f / (float)bounds.getWidth();
+	const float yScale = 65535.0f / (float)bounds.getHeight();
+
+	int chunks = 1;
+
+	if (pool)
+	{
+		chunks = pool->getThreadCount();
+	}
+
+	const int chunkSize = (count + chunks - 1) / chunks;
+
+	auto sortChunk = [&](const int chunk)
 	{
-		if (rectInsideRect(m_bounds, searchArea))
+		int begin = chunk * chunkSize;
+		int end = begin + chunkSize;
+
+		iMin(end, end, count);
+
+		for (int i = begin; i < end; i++)
 		{
-			getData(data);
+			Vector2D center = entities[i].m_size.getCenter();
+
+			float x = (center.m_x - minX) * xScale;
+			float y = (center.m_y - minY) * yScale;
+
+			clamp(x, 0.0f, 65535.0f);
+			clamp(y, 0.0f, 65535.0f);
+
+			sorted[i].m_code = mortonCode((unsigned short)x, (unsigned short)y);
+			sorted[i].m_index = i;
 		}
-		else
+
+		if (begin < end)
 		{
-			if (m_children[0] != nullptr)
-			{
-				for (int i = 0; i <= CHILD_SW; i++)
-				{
-					m_children[i]->search(searchArea, data);
-				}
-			}
+			std::sort(sorted.begin() + begin, sorted.begin() + end, mortonLess);
+		}
+	};
+
+	if (1 < chunks && 0 < chunkSize)
+	{
+		pool->run(chunks, sortChunk);
 
-			for (unsigned int i = 0; i < m_data.size(); i++)
+		for (int width = chunkSize; width < count; width *= 2)
+		{
+			pool->run((count + width * 2 - 1) / (width * 2), [&](const int merge)
 			{
-				if (rectIntersectRect(searchArea, m_data[i].m_size))
-				{
-					data.emplace_back(m_data[i]);
-				}
-			}
+				int begin = merge * width * 2;
+				int middle = begin + width;
+				int end = middle + width;
+
+				iMin(middle, middle, count);
+				iMin(end, end, count);
+
+				std::inplace_merge(sorted.begin() + begin,
+					sorted.begin() + middle,
+					sorted.begin() + end,
+					mortonLess);
+			});
 		}
 	}
+	else
+	{
+		sortChunk(0);
+	}
 }
 
 //=============================================================================
-// Function: void search(const Line&, vector<EntityData>&) const
+// Function: void buildNode(const int,
+// const int,
+// const int,
+// vector<int>&,
+// vector<int>&,
+// vector<int>&)
 // Description:
-// Searches along the search line and adds any entities that collide
-// with it to the data vector.
+// Places a range of the sorted slots into a node. If there are more
+// than the node can hold it splits, and the range is partitioned
+// into the slots that stay and the slots for each child, keeping
+// their sorted order. The children then build from their part.
 // Parameters:
-// const Line& searchLine - The line to search along.
-// vector<EntityData>& data - The data vector to fill.
+// const int node - The node to build.
+// const int begin - The first slot in the range.
+// const int end - One past the last slot in the range.
+// vector<int>& slots - The sorted slots.
+// vector<int>& children - Holds the child picked for each slot.
+// vector<int>& scratch - Holds the slots while they're partitioned.
 //=============================================================================
-void Quadtree::search(const Line& searchLine,
-	std::vector<EntityData>& data) const
+void Quadtree::buildNode(const int node,
+	const int begin,
+	const int end,
+	std::vector<int>& slots,
+	std::vector<int>& children,
+	std::vector<int>& scratch)
 {
-	if (lineInRect(m_bounds, searchLine))
+	m_nodes[node].m_totalCount = end - begin;
+
+	if (m_maxObjects < end - begin && split(node))
 	{
-		if (m_children[0] != nullptr)
+		// The first group stays in this node, the rest go to the
+		// children in order.
+		int starts[CHILD_COUNT + 2] = { 0 };
+		int positions[CHILD_COUNT + 1];
+
+		for (int i = begin; i < end; i++)
 		{
-			m_children[CHILD_NW]->search(searchLine, data);
-			m_children[CHILD_NE]->search(searchLine, data);
-			m_children[CHILD_SE]->search(searchLine, data);
-			m_children[CHILD_SW]->search(searchLine, data);
+			children[i] = getChildIndex(node, m_entities[slots[i]].m_data.m_size) + 1;
+			starts[children[i] + 1]++;
 		}
 
-		for (unsigned int i = 0; i < m_data.size(); i++)
+		starts[0] = begin;
+
+		for (int i = 0; i <= CHILD_COUNT; i++)
 		{
-			if (lineInRect(m_data[i].m_size, searchLine))
-			{
-				data.emplace_back(m_data[i]);
-			}
+			starts[i + 1] += starts[i];
+			positions[i] = starts[i];
+		}
+
+		for (int i = begin; i < end; i++)
+		{
+			scratch[positions[children[i]]++] = slots[i];
+		}
+
+		std::copy(scratch.begin() + begin, scratch.begin() + end, slots.begin() + begin);
+
+		for (int i = starts[0]; i < starts[1]; i++)
+		{
+			appendEntity(node, slots[i]);
+		}
+
+		int firstChild = m_nodes[node].m_firstChild;
+
+		for (int i = 0; i < CHILD_COUNT; i++)
+		{
+			buildNode(firstChild + i, starts[i + 1], starts[i + 2], slots, children, scratch);
+		}
+	}
+	else
+	{
+		for (int i = begin; i < end; i++)
+		{
+			appendEntity(node, slots[i]);
 		}
 	}
 }
 
 //=============================================================================
-// Function: void getData(vector<EntityData>&) const
+// Function: bool mortonLess(const MortonEntry&, const MortonEntry&)
 // Description:
-// Gets all of the data from the node it's children.
+// Orders entries by their code, and by their index when the codes
+// match so the order doesn't depend on how the sort was split up.
 // Parameters:
-// vector<EntityData>& data - The data vector to fill up.
+// const MortonEntry& a - The first entry.
+// const MortonEntry& b - The second entry.
+// Output:
+// bool
+// Returns true if a comes before b.
 //=============================================================================
-void Quadtree::getData(std::vector<EntityData>& data) const
+bool Quadtree::mortonLess(const MortonEntry& a,
+	const MortonEntry& b)
 {
-	if (m_children[0] != nullptr)
-	{
-		m_children[CHILD_NW]->getData(data);
-		m_children[CHILD_NE]->getData(data);
-		m_children[CHILD_SE]->getData(data);
-		m_children[CHILD_SW]->getData(data);
-	}
+	return a.m_code < b.m_code ||
+		(a.m_code == b.m_code && a.m_index < b.m_index);
+}
 
-	for (unsigned int i = 0; i < m_data.size(); i++)
-	{
-		data.emplace_back(m_data[i]);
-	}
+//=============================================================================
+// Function: bool validIndex(const int, const int)
+// Description:
+// Checks that an index read from a saved tree is either unused or
+// inside its pool.
+// Parameters:
+// const int index - The index to check.
+// const int count - The size of the pool.
+// Output:
+// bool
+// Returns true if the index is NO_INDEX or in the pool.
+//=============================================================================
+bool Quadtree::validIndex(const int index,
+	const int count)
+{
+	return index == NO_INDEX || (0 <= index && index < count);
 }
 
 //=============================================================================
-// Function: void split()
+// Function: const Rectangle getLooseBounds(const Rectangle&) const
 // Description:
-// Splits the quad tree into 4 leafs if it's possible.
+// Grows node bounds by the looseness of the tree.
+// Parameters:
+// const Rectangle& bounds - The bounds of the node.
+// Output:
+// const Rectangle
+// Returns the search bounds for the node.
 //=============================================================================
-void Quadtree::split()
+const Rectangle Quadtree::getLooseBounds(const Rectangle& bounds) const
 {
-	if (m_children[0] == nullptr)
+	Rectangle looseBounds = bounds;
+
+	if (1.0f < m_looseness)
 	{
-		if (m_level < m_maxLevels)
-		{
-			int halfWidth = m_bounds.getWidth() / 2;
-			int halfHeight = m_bounds.getHeight() / 2;
-			Vector2D center = m_bounds.getCenter();
+		looseBounds.setWidth((int)(bounds.getWidth() * m_looseness));
+		looseBounds.setHeight((int)(bounds.getHeight() * m_looseness));
+	}
 
-			m_children[CHILD_NW] =
-				std::make_shared<Quadtree>(m_maxObjects,
-					m_maxLevels,
-					m_level + 1,
-					Rectangle(Vector2D(center.m_x - (float)(halfWidth / 2), center.m_y - (float)(halfHeight / 2)), halfWidth, halfHeight),
-					this);
+	return looseBounds;
+}
 
-			m_children[CHILD_NE] =
-				std::make_shared<Quadtree>
-				(m_maxObjects,
-					m_maxLevels,
-					m_level + 1,
-					Rectangle(Vector2D(center.m_x + (float)(halfWidth / 2), center.m_y - (float)(halfHeight / 2)), halfWidth, halfHeight),
-					this);
+//=============================================================================
+// Function: const int getChildIndex(const int, const Rectangle&) const
+// Description:
+// Finds the child node that the center of the entity is inside.
+// In a loose tree the entity also has to fit inside the loose
+// bounds of that child, otherwise it stays in this node.
+// Parameters:
+// const int node - The node to check the children of.
+// const Rectangle& size - The size of the entity to place.
+// Output:
+// const int
+// Returns the child node index, or THIS_TREE if it stays here.
+//=============================================================================
+const int Quadtree::getChildIndex(const int node,
+	const Rectangle& size) const
+{
+	int index = THIS_TREE;
+	int firstChild = m_nodes[node].m_firstChild;
 
-			m_children[CHILD_SE] =
-				std::make_shared<Quadtree>
-				(m_maxObjects,
-					m_maxLevels,
-					m_level + 1,
-					Rectangle(Vector2D(center.m_x + (float)(halfWidth / 2), center.m_y + (float)(halfHeight / 2)), halfWidth, halfHeight),
-					this);
+	if (firstChild != NO_INDEX)
+	{
+		for (int i = 0; i < CHILD_COUNT && index == THIS_TREE; i++)
+		{
+			if (pointInRect(m_nodes[firstChild + i].m_bounds, size.getCenter()))
+			{
+				index = i;
+			}
+		}
 
-			m_children[CHILD_SW] =
-				std::make_shared<Quadtree>
-				(m_maxObjects,
-					m_maxLevels,
-					m_level + 1,
-					Rectangle(Vector2D(center.m_x - (float)(halfWidth / 2), center.m_y + (float)(halfHeight / 2)), halfWidth, halfHeight),
-					this);
+		if (index != THIS_TREE &&
+			!fitsLooseBounds(firstChild + index, size))
+		{
+			index = THIS_TREE;
 		}
 	}
+
+	return index;
 }
 
 //=============================================================================
-// Function: const int getChildIndex(const Vector2D&) const
+// Function: const int getContainingNode(const int,
+// const Rectangle&) const
 // Description:
-// Checks all of the children nodes to see if a point is inside them.
-// If there are no children, it returns the base node.
+// Walks from a node up to the root and finds the deepest node on
+// that path that placing the entity from the root would pass
+// through.
 // Parameters:
-// const Vector2D& point - The point to find.
+// const int node - The node to start from.
+// const Rectangle& size - The size of the entity.
 // Output:
 // const int
-// Returns the child node index of the point.
+// Returns the index of the containing node.
 //=============================================================================
-const int Quadtree::getChildIndex(const Vector2D& point) const
+const int Quadtree::getContainingNode(const int node,
+	const Rectangle& size) const
 {
-	if (m_children[0] != nullptr)
+	int containing = node;
+	int current = node;
+
+	while (current != ROOT)
 	{
-		for (int i = 0; i <= CHILD_SW; i++)
+		int parent = m_nodes[current].m_parent;
+
+		if (getChildIndex(parent, size) != current - m_nodes[parent].m_firstChild)
 		{
-			if (pointInRect(m_children[i]->m_bounds, point))
-			{
-				return i;
-			}
+			containing = parent;
 		}
+
+		current = parent;
+	}
+
+	return containing;
+}
+
+//=============================================================================
+// Function: const bool fitsLooseBounds(const int, const Rectangle&) const
+// Description:
+// Checks if an entity is completely inside the loose bounds of a
+// node. Always true when the tree isn't loose.
+// Parameters:
+// const int node - The node to check.
+// const Rectangle& size - The size of the entity.
+// Output:
+// const bool
+// Returns true if the entity fits.
+//=============================================================================
+const bool Quadtree::fitsLooseBounds(const int node,
+	const Rectangle& size) const
+{
+	bool fits = true;
+
+	if (1.0f < m_looseness)
+	{
+		const Rectangle& loose = m_nodes[node].m_looseBounds;
+
+		fits = loose.getMinX() <= size.getMinX() &&
+			size.getMaxX() <= loose.getMaxX() &&
+			loose.getMinY() <= size.getMinY() &&
+			size.getMaxY() <= loose.getMaxY();
 	}
 
-	return -1;
-}
\ No newline at end of file
+	return fits;
+}
@@ -3,84 +3,536 @@
 // File Name: Quadtree.h
 // Author: Brian Blackmon
 // Date Created: 10/25/2019
-// Purpose: 
-// A quad tree storage object.
+// Purpose:
+// A quad tree storage object, loose when built with a looseness
+// above 1. Nodes live in an index linked pool and entities in a
+// shared slab, so neither allocates once the pools have grown.
 //==========================================================================================
-#include "Rectangle.h"
-#include "Line.h"
+#include "ISpatialIndex.h"
+#include "BBMath.h"
 #include <vector>
-#include <memory>
+#include <unordered_map>
+#include <atomic>
+#include <string>
+#include <iosfwd>
+#include <cfloat>
 
 class Renderer;
 
-struct EntityData
+struct QuadtreeStats
 {
-	EntityData(const int id,
-		const Rectangle& size)
-		:m_id(id),
-		m_size(size)
+	QuadtreeStats()
+		:m_nodeCount(0),
+		m_leafCount(0),
+		m_depth(0),
+		m_entityCount(0),
+		m_poolSize(0),
+		m_freeNodes(0)
 	{
-		
+
+	}
+
+	// The nodes currently in use and how many of them are leafs.
+	int m_nodeCount;
+	int m_leafCount;
+
+	// The deepest level that has a node.
+	int m_depth;
+
+	int m_entityCount;
+
+	// The size of the node pool and how much of it is waiting to be
+	// reused.
+	int m_poolSize;
+	int m_freeNodes;
+
+	// The nodes and entities on each level, indexed by level.
+	std::vector<int> m_depthNodes;
+	std::vector<int> m_depthEntities;
+
+	// How many nodes hold each number of entities, indexed by the
+	// count. The last entry counts every node holding more than the
+	// tree's object limit.
+	std::vector<int> m_occupancy;
+};
+
+// Totals across every area and line search since the counters were
+// last reset.
+struct QuadtreeQueryStats
+{
+	QuadtreeQueryStats()
+		:m_queries(0),
+		m_nodesVisited(0),
+		m_entitiesTested(0),
+		m_entitiesReturned(0)
+	{
+
 	}
 
-	int m_id;
-	Rectangle m_size;
+	long long m_queries;
+	long long m_nodesVisited;
+
+	// Entities checked against the search area or line, and the ones
+	// handed to the visitor. Entities in nodes entirely inside the
+	// area are returned without being tested.
+	long long m_entitiesTested;
+	long long m_entitiesReturned;
 };
 
-class Quadtree
+struct SearchBatchResult
+{
+	// The ids found by query i are m_ids[m_offsets[i]] up to, but not
+	// including, m_ids[m_offsets[i + 1]].
+	std::vector<int> m_offsets;
+	std::vector<int> m_ids;
+
+	// Where each chunk of queries collects its ids before they're
+	// joined into m_ids. Kept so later batches reuse the memory.
+	std::vector<std::vector<int>> m_chunkIds;
+};
+
+class Quadtree : public ISpatialIndex<EntityData>
 {
 public:
+	// A looseness of 2 lets any entity up to half a node's size sink
+	// into the child that holds its center.
+	static constexpr float LOOSE = 2.0f;
+
+	// How many chunks of queries each thread gets in searchBatch, so
+	// a thread that finishes early can pick up more.
+	static const int CHUNKS_PER_THREAD = 4;
+
 	Quadtree(const int maxObjects,
 		const int maxLevels,
-		const int level,
 		const Rectangle& bounds,
-		Quadtree *parent);
+		const float looseness = 1.0f);
 
-	~Quadtree();
+	virtual ~Quadtree();
 
 	const int getWidth() const;
 	const int getHeight() const;
+	const float getLooseness() const;
+
+	const QuadtreeStats getStats() const;
+
+	const QuadtreeQueryStats getQueryStats() const;
+	void resetQueryStats();
+
+	const bool writeOccupancyCSV(const std::string& path) const;
+
+	using ISpatialIndex<EntityData>::search;
+
+	virtual void search(const Rectangle& searchArea,
+		ISpatialVisitor<EntityData>& visitor) const;
+	virtual void search(const Line& searchLine,
+		ISpatialVisitor<EntityData>& visitor) const;
+
+	void searchBatch(const std::vector<Rectangle>& searchAreas,
+		SearchBatchResult& results,
+		ThreadPool *pool = NULL) const;
+
+	virtual void addEntity(const EntityData& entity);
+	virtual void removeEntity(const EntityData& entity);
+	virtual void moveEntity(const EntityData& entity,
+		const Rectangle& size);
 
-	std::vector<EntityData> search(const Rectangle& searchArea) const;
-	std::vector<EntityData> search(const Line& searchLine) const;
+	void updateEntity(const int id,
+		const Rectangle& size);
 
-	void addEntity(const EntityData& entity);
-	void removeEntity(const EntityData& entity);
+	virtual bool raycast(const Line& ray,
+		RaycastHit& hit,
+		const ISpatialFilter<EntityData> *filter = NULL) const;
 
-	void renderTree(Renderer *renderer, 
+	using ISpatialIndex<EntityData>::withinRadius;
+
+	virtual void nearest(const Vector2D& point,
+		const int count,
+		std::vector<EntityData>& nearest) const;
+	virtual void withinRadius(const Vector2D& point,
+		const float radius,
+		ISpatialVisitor<EntityData>& visitor) const;
+
+	virtual void forEachOverlappingPair(ISpatialPairVisitor<EntityData>& visitor) const;
+
+	virtual ISpatialIndex<EntityData>* createSnapshot() const;
+	virtual void updateSnapshot(ISpatialIndex<EntityData>& snapshot) const;
+
+	virtual void clear();
+	virtual void build(const std::vector<EntityData>& entities,
+		ThreadPool *pool = NULL);
+
+	void serialize(std::vector<char>& blob) const;
+	const bool deserialize(const char *blob,
+		const size_t size);
+
+	const bool save(const std::string& path) const;
+	const bool load(const std::string& path);
+
+	void renderTree(Renderer *renderer,
+		const Vector2D& offset,
+		const float xScale,
+		const float yScale);
+	void renderOccupancy(Renderer *renderer,
 		const Vector2D& offset,
 		const float xScale,
 		const float yScale);
 
 private:
 	static const int THIS_TREE = -1;
+	static const int NO_INDEX = -1;
+	static const int ROOT = 0;
 	static const int CHILD_NW = 0;
 	static const int CHILD_NE = 1;
 	static const int CHILD_SE = 2;
 	static const int CHILD_SW = 3;
+	static const int CHILD_COUNT = 4;
+	static const int SEARCH_BATCH = 4;
+
+	// "QTRE" read as a little endian int, and the layout of the blob.
+	static const unsigned int BLOB_MAGIC = 0x45525451;
+	static const int BLOB_VERSION = 2;
+
+	struct QuadNode
+	{
+		QuadNode(const Rectangle& bounds,
+			const Rectangle& looseBounds,
+			const int parent,
+			const int level)
+			:m_bounds(bounds),
+			m_looseBounds(looseBounds),
+			m_parent(parent),
+			m_firstChild(NO_INDEX),
+			m_firstEntity(NO_INDEX),
+			m_lastEntity(NO_INDEX),
+			m_entityCount(0),
+			m_totalCount(0),
+			m_level(level)
+		{
 
-	std::vector<EntityData> m_data;
+		}
 
-	Quadtree *m_parent;
-	std::shared_ptr<Quadtree> m_children[4];
+		Rectangle m_bounds;
+
+		// The bounds used for searching. They match m_bounds unless
+		// the tree is loose.
+		Rectangle m_looseBounds;
+
+		// The children are stored next to each other, so only the
+		// first one needs to be tracked. The first node of a freed
+		// block of children uses m_firstChild to link to the next
+		// free block.
+		int m_parent;
+		int m_firstChild;
+
+		int m_firstEntity;
+		int m_lastEntity;
+		int m_entityCount;
+
+		// The entities in this node and all of its children.
+		int m_totalCount;
+
+		int m_level;
+	};
+
+	struct EntitySlot
+	{
+		EntitySlot(const EntityData& data)
+			:m_data(data),
+			m_node(NO_INDEX),
+			m_previous(NO_INDEX),
+			m_next(NO_INDEX)
+		{
+
+		}
+
+		EntityData m_data;
+
+		// The node the entity is linked into.
+		int m_node;
+
+		// Links to the entities around it in the node. m_next also
+		// links to the next free slot once the slot is released.
+		int m_previous;
+		int m_next;
+	};
+
+	// The box around everything in a subtree.
+	struct NodeExtent
+	{
+		NodeExtent()
+			:m_minX(FLT_MAX),
+			m_minY(FLT_MAX),
+			m_maxX(-FLT_MAX),
+			m_maxY(-FLT_MAX)
+		{
 
-	Rectangle m_bounds;
+		}
+
+		NodeExtent(const Rectangle& size)
+			:m_minX(size.getMinX()),
+			m_minY(size.getMinY()),
+			m_maxX(size.getMaxX()),
+			m_maxY(size.getMaxY())
+		{
+
+		}
+
+		void add(const NodeExtent& extent)
+		{
+			fMin(m_minX, m_minX, extent.m_minX);
+			fMin(m_minY, m_minY, extent.m_minY);
+			fMax(m_maxX, m_maxX, extent.m_maxX);
+			fMax(m_maxY, m_maxY, extent.m_maxY);
+		}
+
+		float m_minX;
+		float m_minY;
+		float m_maxX;
+		float m_maxY;
+	};
+
+	// The work done by one search, or by every search in a chunk of
+	// a batch, before it's added to the totals.
+	struct QueryCounter
+	{
+		QueryCounter()
+			:m_queries(0),
+			m_nodesVisited(0),
+			m_entitiesTested(0),
+			m_entitiesReturned(0)
+		{
+
+		}
+
+		long long m_queries;
+		long long m_nodesVisited;
+		long long m_entitiesTested;
+		long long m_entitiesReturned;
+	};
+
+	// The start of a saved tree. It's followed by the node records and
+	// then the slot records. Every field is 4 bytes, so nothing is
+	// padded, and they're written in the machine's own byte order.
+	struct BlobHeader
+	{
+		unsigned int m_magic;
+		int m_version;
+		int m_maxObjects;
+		int m_maxLevels;
+		float m_looseness;
+		int m_nodeCount;
+		int m_slotCount;
+		int m_freeNode;
+		int m_freeEntity;
+	};
+
+	// A saved node. The loose bounds aren't saved since they're worked
+	// out from the bounds.
+	struct NodeRecord
+	{
+		float m_centerX;
+		float m_centerY;
+		int m_width;
+		int m_height;
+		int m_parent;
+		int m_firstChild;
+		int m_firstEntity;
+		int m_lastEntity;
+		int m_entityCount;
+		int m_totalCount;
+		int m_level;
+	};
+
+	// A saved slot, free or not, so the free list still lines up.
+	struct SlotRecord
+	{
+		int m_id;
+		unsigned int m_flags;
+		float m_centerX;
+		float m_centerY;
+		int m_width;
+		int m_height;
+		float m_rotation;
+		int m_node;
+		int m_previous;
+		int m_next;
+	};
+
+	struct MortonEntry
+	{
+		unsigned int m_code;
+		int m_index;
+	};
+
+	std::vector<QuadNode> m_nodes;
+	std::vector<EntitySlot> m_entities;
+	std::unordered_map<int, int> m_slotLookup;
+
+	// The corners of each slot's entity, indexed the same as the slab.
+	// They're only used when m_slotAligned is set for the slot.
+	std::vector<float> m_slotMinX;
+	std::vector<float> m_slotMinY;
+	std::vector<float> m_slotMaxX;
+	std::vector<float> m_slotMaxY;
+	std::vector<unsigned char> m_slotAligned;
+
+	int m_freeEntity;
+	int m_freeNode;
 
 	int m_maxObjects;
 	int m_maxLevels;
-	int m_level;
+	int m_mergeObjects;
+
+	float m_looseness;
+
+	// Searches are const and can run on several threads at once, so
+	// the totals are atomic. Batches count into a counter per chunk
+	// and add them once at the end.
+	mutable std::atomic<long long> m_queryCount;
+	mutable std::atomic<long long> m_nodesVisited;
+	mutable std::atomic<long long> m_entitiesTested;
+	mutable std::atomic<long long> m_entitiesReturned;
 
 	void cleanUp();
 
+	void recordQuery(const QueryCounter& counter) const;
+
 	void search(const Rectangle& searchArea,
-		std::vector<EntityData>& data) const;
+		ISpatialVisitor<EntityData>& visitor,
+		QueryCounter& counter) const;
+	const bool search(const int node,
+		const Rectangle& searchArea,
+		ISpatialVisitor<EntityData>& visitor,
+		QueryCounter& counter) const;
+
+	const bool search(const int node,
+		const Line& searchLine,
+		ISpatialVisitor<EntityData>& visitor,
+		QueryCounter& counter) const;
+
+	const bool searchEntities(const int node,
+		const Rectangle& searchArea,
+		const bool areaFirst,
+		ISpatialVisitor<EntityData>& visitor,
+		QueryCounter& counter) const;
+
+	const int getOverlapMask(const int *slots,
+		const int count,
+		const float minX,
+		const float minY,
+		const float maxX,
+		const float maxY) const;
+
+	const bool getData(const int node,
+		ISpatialVisitor<EntityData>& visitor,
+		QueryCounter& counter) const;
 
-	void search(const Line& searchLine,
-		std::vector<EntityData>& data) const;
+	void nearest(const int node,
+		const Vector2D& point,
+		const int count,
+		std::vector<EntityData>& nearest) const;
 
-	void getData(std::vector<EntityData>& data) const;
+	const bool withinRadius(const int node,
+		const Vector2D& point,
+		const float radiusSquared,
+		ISpatialVisitor<EntityData>& visitor) const;
 
-	void split();
+	const float getNodeDistance(const int node,
+		const Vector2D& point) const;
 
-	const int getChildIndex(const Vector2D& point) const;
-};
\ No newline at end of file
+	const bool findPairs(const int node,
+		const std::vector<NodeExtent>& extents,
+		ISpatialPairVisitor<EntityData>& visitor) const;
+	const bool findPairs(const int node,
+		const EntityData& entity,
+		const std::vector<NodeExtent>& extents,
+		ISpatialPairVisitor<EntityData>& visitor) const;
+	const bool findCrossPairs(const int first,
+		const int second,
+		const std::vector<NodeExtent>& extents,
+		ISpatialPairVisitor<EntityData>& visitor) const;
+
+	void findExtents(const int node,
+		std::vector<NodeExtent>& extents) const;
+
+	static bool extentsOverlap(const NodeExtent& a,
+		const NodeExtent& b);
+
+	void raycast(const int node,
+		const float enterTime,
+		const Line& ray,
+		const ISpatialFilter<EntityData> *filter,
+		RaycastHit& hit,
+		bool& found) const;
+
+	void insertEntity(const int node,
+		const int slot);
+
+	void linkEntity(const int node,
+		const int slot);
+	void appendEntity(const int node,
+		const int slot);
+	void unlinkEntity(const int slot);
+
+	const int createSlot(const EntityData& entity);
+	void releaseSlot(const int slot);
+	void setSlotBounds(const int slot);
+	void resizeSlot(const int slot,
+		const Rectangle& size);
+
+	void renderNode(const int node,
+		Renderer *renderer,
+		const Vector2D& offset,
+		const float xScale,
+		const float yScale) const;
+	void renderOccupancyNode(const int node,
+		Renderer *renderer,
+		const Vector2D& offset,
+		const float xScale,
+		const float yScale) const;
+
+	const Rectangle getScreenRect(const Rectangle& bounds,
+		const Vector2D& offset,
+		const float xScale,
+		const float yScale) const;
+
+	void writeOccupancyNode(const int node,
+		std::ostream& out) const;
+
+	const bool split(const int node);
+
+	void collapse(const int node);
+	void absorbNode(const int target,
+		const int node);
+	void releaseChildren(const int node);
+
+	void collectStats(const int node,
+		QuadtreeStats& stats) const;
+
+	void sortByMorton(const std::vector<EntityData>& entities,
+		std::vector<MortonEntry>& sorted,
+		ThreadPool *pool) const;
+
+	void buildNode(const int node,
+		const int begin,
+		const int end,
+		std::vector<int>& slots,
+		std::vector<int>& children,
+		std::vector<int>& scratch);
+
+	static bool mortonLess(const MortonEntry& a,
+		const MortonEntry& b);
+
+	static bool validIndex(const int index,
+		const int count);
+
+	const Rectangle getLooseBounds(const Rectangle& bounds) const;
+
+	const int getChildIndex(const int node,
+		const Rectangle& size) const;
+
+	const int getContainingNode(const int node,
+		const Rectangle& size) const;
+	const bool fitsLooseBounds(const int node,
+		const Rectangle& size) const;
+};
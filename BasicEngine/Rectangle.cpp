@@ -1,5 +1,5 @@
 #include "Rectangle.h"
-#include "Rotation.h"
+#include "BBMath.h"
 #include <cmath>
 
 Rectangle::Rectangle()
@@ -8,7 +8,7 @@ Rectangle::Rectangle()
 	m_height(0),
 	m_rotation(0.0f)
 {
-
+	updateCorners();
 }
 
 Rectangle::Rectangle(const Vector2D& center,
@@ -20,14 +20,22 @@ Rectangle::Rectangle(const Vector2D& center,
 {
 	m_center.m_x = center.m_x;
 	m_center.m_y = center.m_y;
+
+	updateCorners();
 }
 
 Rectangle::Rectangle(const Rectangle& rect)
-	:m_width(rect.getWidth()),
-	m_height(rect.getHeight()),
-	m_rotation(rect.getRotation())
+	:m_center(rect.m_center),
+	m_width(rect.m_width),
+	m_height(rect.m_height),
+	m_rotation(rect.m_rotation),
+	m_rotationVector(rect.m_rotationVector),
+	m_topLeft(rect.m_topLeft),
+	m_topRight(rect.m_topRight),
+	m_bottomLeft(rect.m_bottomLeft),
+	m_bottomRight(rect.m_bottomRight)
 {
-	m_center = rect.getCenter();
+
 }
 
 Rectangle::~Rectangle()
@@ -40,6 +48,12 @@ Rectangle& Rectangle::operator=(const Rectangle& rect)
 	m_width = rect.m_width;
 	m_height = rect.m_height;
 	m_rotation = rect.m_rotation;
+	m_rotationVector = rect.m_rotationVector;
+
+	m_topLeft = rect.m_topLeft;
+	m_topRight = rect.m_topRight;
+	m_bottomLeft = rect.m_bottomLeft;
+	m_bottomRight = rect.m_bottomRight;
 
 	return *this;
 }
@@ -67,18 +81,7 @@ const Vector2D& Rectangle::getCenter() const
 //=============================================================================
 const Vector2D Rectangle::getTopLeft() const
 {
-	Vector2D topLeft;
-
-	topLeft.m_x = round(m_center.m_x - ((float)m_width / 2.0f));
-	topLeft.m_y = round(m_center.m_y - ((float)m_height / 2.0f));
-
-	if (m_rotation != 0.0f)
-	{
-		topLeft =
-			rotatePoint(m_center, topLeft, m_rotation);
-	}
-
-	return topLeft;
+	return m_topLeft;
 }
 
 //=============================================================================
@@ -91,18 +94,7 @@ const Vector2D Rectangle::getTopLeft() const
 //=============================================================================
 const Vector2D Rectangle::getTopRight() const
 {
-	Vector2D topRight;
-
-	topRight.m_x = round(m_center.m_x + ((float)m_width / 2.0f));
-	topRight.m_y = round(m_center.m_y - ((float)m_height / 2.0f));
-	
-	if (m_rotation != 0.0f)
-	{
-		topRight =
-			rotatePoint(m_center, topRight, m_rotation);
-	}
-
-	return topRight;
+	return m_topRight;
 }
 
 //=============================================================================
@@ -115,18 +107,7 @@ const Vector2D Rectangle::getTopRight() const
 //=============================================================================
 const Vector2D Rectangle::getBottomLeft() const
 {
-	Vector2D bottomLeft;
-
-	bottomLeft.m_x = round(m_center.m_x - ((float)m_width / 2.0f));
-	bottomLeft.m_y = round(m_center.m_y + ((float)m_height / 2.0f));
-
-	if (m_rotation != 0.0f)
-	{
-		bottomLeft =
-			rotatePoint(m_center, bottomLeft, m_rotation);
-	}
-
-	return bottomLeft;
+	return m_bottomLeft;
 }
 
 //=============================================================================
@@ -139,18 +120,7 @@ const Vector2D Rectangle::getBottomLeft() const
 //=============================================================================
 const Vector2D Rectangle::getBottomRight() const
 {
-	Vector2D bottomRight;
-
-	bottomRight.m_x = round(m_center.m_x + ((float)m_width / 2.0f));
-	bottomRight.m_y = round(m_center.m_y + ((float)m_height / 2.0f));
-	
-	if (m_rotation != 0.0f)
-	{
-		bottomRight = 
-			rotatePoint(m_center, bottomRight, m_rotation);
-	}
-
-	return bottomRight;
+	return m_bottomRight;
 }
 
 //=============================================================================
@@ -192,6 +162,19 @@ const float Rectangle::getRotation() const
 	return m_rotation;
 }
 
+//=============================================================================
+// Function: const RotationVector& getRotationVector() const
+// Description:
+// Gets the sine and cosine of the rectangle's rotation.
+// Output:
+// const RotationVector&
+// Returns the rotation as a vector.
+//=============================================================================
+const RotationVector& Rectangle::getRotationVector() const
+{
+	return m_rotationVector;
+}
+
 //=============================================================================
 // Function: const float getMinX() const
 // Description:
@@ -206,30 +189,10 @@ const float Rectangle::getMinX() const
 
 	if (m_rotation != 0.0f)
 	{
-		Vector2D topLeft = getTopLeft();
-		Vector2D topRight = getTopRight();
-		Vector2D bottomLeft = getBottomLeft();
-		Vector2D bottomRight = getBottomRight();
-
-		if (topLeft.m_x < min)
-		{
-			min = topLeft.m_x;
-		}
-
-		if (topRight.m_x < min)
-		{
-			min = topRight.m_x;
-		}
-		
-		if (bottomLeft.m_x < min)
-		{
-			min = bottomLeft.m_x;
-		}
-
-		if (bottomRight.m_x < min)
-		{
-			min = bottomRight.m_x;
-		}
+		fMin(min, min, m_topLeft.m_x);
+		fMin(min, min, m_topRight.m_x);
+		fMin(min, min, m_bottomLeft.m_x);
+		fMin(min, min, m_bottomRight.m_x);
 	}
 
 	return min;
@@ -249,30 +212,10 @@ const float Rectangle::getMinY() const
 
 	if (m_rotation != 0.0f)
 	{
-		Vector2D topLeft = getTopLeft();
-		Vector2D topRight = getTopRight();
-		Vector2D bottomLeft = getBottomLeft();
-		Vector2D bottomRight = getBottomRight();
-
-		if (topLeft.m_y < min)
-		{
-			min = topLeft.m_y;
-		}
-
-		if (topRight.m_y < min)
-		{
-			min = topRight.m_y;
-		}
-
-		if (bottomLeft.m_y < min)
-		{
-			min = bottomLeft.m_y;
-		}
-
-		if (bottomRight.m_y < min)
-		{
-			min = bottomRight.m_y;
-		}
+		fMin(min, min, m_topLeft.m_y);
+		fMin(min, min, m_topRight.m_y);
+		fMin(min, min, m_bottomLeft.m_y);
+		fMin(min, min, m_bottomRight.m_y);
 	}
 
 	return min;
@@ -292,30 +235,10 @@ const float Rectangle::getMaxX() const
 
 	if (m_rotation != 0.0f)
 	{
-		Vector2D topLeft = getTopLeft();
-		Vector2D topRight = getTopRight();
-		Vector2D bottomLeft = getBottomLeft();
-		Vector2D bottomRight = getBottomRight();
-
-		if (max < topLeft.m_x)
-		{
-			max = topLeft.m_x;
-		}
-
-		if (max < topRight.m_x)
-		{
-			max = topRight.m_x;
-		}
-
-		if (max < bottomLeft.m_x)
-		{
-			max = bottomLeft.m_x;
-		}
-
-		if (max < bottomRight.m_x)
-		{
-			max = bottomRight.m_x;
-		}
+		fMax(max, max, m_topLeft.m_x);
+		fMax(max, max, m_topRight.m_x);
+		fMax(max, max, m_bottomLeft.m_x);
+		fMax(max, max, m_bottomRight.m_x);
 	}
 
 	return max;
@@ -335,30 +258,10 @@ const float Rectangle::getMaxY() const
 
 	if (m_rotation != 0.0f)
 	{
-		Vector2D topLeft = getTopLeft();
-		Vector2D topRight = getTopRight();
-		Vector2D bottomLeft = getBottomLeft();
-		Vector2D bottomRight = getBottomRight();
-
-		if (max < topLeft.m_y)
-		{
-			max = topLeft.m_y;
-		}
-
-		if (max < topRight.m_y)
-		{
-			max = topRight.m_y;
-		}
-
-		if (max < bottomLeft.m_y)
-		{
-			max = bottomLeft.m_y;
-		}
-
-		if (max < bottomRight.m_y)
-		{
-			max = bottomRight.m_y;
-		}
+		fMax(max, max, m_topLeft.m_y);
+		fMax(max, max, m_topRight.m_y);
+		fMax(max, max, m_bottomLeft.m_y);
+		fMax(max, max, m_bottomRight.m_y);
 	}
 
 	return max;
@@ -376,6 +279,8 @@ void Rectangle::setCenter(const float x, const float y)
 {
 	m_center.m_x = x;
 	m_center.m_y = y;
+
+	updateCorners();
 }
 
 //=============================================================================
@@ -388,6 +293,8 @@ void Rectangle::setCenter(const float x, const float y)
 void Rectangle::setCenter(const Vector2D& center)
 {
 	m_center = center;
+
+	updateCorners();
 }
 
 //=============================================================================
@@ -402,6 +309,8 @@ void Rectangle::setWidth(const int width)
 	if (0 < width)
 	{
 		m_width = width;
+
+		updateCorners();
 	}
 }
 
@@ -417,6 +326,8 @@ void Rectangle::setHeight(const int height)
 	if (0 < height)
 	{
 		m_height = height;
+
+		updateCorners();
 	}
 }
 
@@ -430,4 +341,40 @@ void Rectangle::setHeight(const int height)
 void Rectangle::setRotation(const float rotation)
 {
 	m_rotation = rotation;
-}
\ No newline at end of file
+	m_rotationVector = RotationVector(rotation);
+
+	updateCorners();
+}
+
+//=============================================================================
+// Function: void updateCorners()
+// Description:
+// Works out the corners again. Rotated corners are rotated together
+// with the stored rotation, rounded the same way rotatePoint does it.
+//=============================================================================
+void Rectangle::updateCorners()
+{
+	float left = round(m_center.m_x - ((float)m_width / 2.0f));
+	float right = round(m_center.m_x + ((float)m_width / 2.0f));
+	float top = round(m_center.m_y - ((float)m_height / 2.0f));
+	float bottom = round(m_center.m_y + ((float)m_height / 2.0f));
+
+	m_topLeft = Vector2D(left, top);
+	m_topRight = Vector2D(right, top);
+	m_bottomLeft = Vector2D(left, bottom);
+	m_bottomRight = Vector2D(right, bottom);
+
+	if (m_rotation != 0.0f)
+	{
+		const int CORNER_COUNT = 4;
+
+		Vector2D corners[CORNER_COUNT]{ m_topLeft, m_topRight, m_bottomLeft, m_bottomRight };
+
+		rotatePoints(m_center, m_rotationVector, corners, corners, CORNER_COUNT);
+
+		m_topLeft = corners[0];
+		m_topRight = corners[1];
+		m_bottomLeft = corners[2];
+		m_bottomRight = corners[3];
+	}
+}
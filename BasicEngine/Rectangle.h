@@ -6,8 +6,12 @@
 // Purpose: 
 // Holds rectangle information, such as the center location,
 // rotation information, and corner location.
+// The rounded corners are worked out whenever the center, size or
+// rotation changes, since they're read far more often than they're
+// set. The box around them is cheap to work out on each read.
 //==========================================================================================
 #include "Vector2D.h"
+#include "Rotation.h"
 
 class Rectangle
 {
@@ -29,6 +33,7 @@ public:
 	const int getWidth() const;
 	const int getHeight() const;
 	const float getRotation() const;
+	const RotationVector& getRotationVector() const;
 
 	const float getMinX() const;
 	const float getMinY() const;
@@ -48,5 +53,13 @@ private:
 	int m_height;
 
 	float m_rotation;
+	RotationVector m_rotationVector;
+
+	Vector2D m_topLeft;
+	Vector2D m_topRight;
+	Vector2D m_bottomLeft;
+	Vector2D m_bottomRight;
+
+	void updateCorners();
 };
 
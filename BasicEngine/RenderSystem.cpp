@@ -8,20 +8,17 @@
 
 RenderSystem::RenderSystem(const Rectangle& gridBounds,
 	const int maxItems,
-	const int maxLevels)
+	const int maxLevels,
+	const SpatialIndexType indexType,
+	const int cellSize)
 	:m_renderGrid(NULL),
 	m_cameras(NULL),
 	m_cameraCount(0),
-	m_activeCamera(-1)
+	m_activeCamera(-1),
+	m_bulkLoading(false)
 {
-
-	m_renderGrid = new Quadtree*[LAYER_TOTAL];
-
-	for (int i = 0; i < (int)LAYER_TOTAL; i++)
-	{
-		m_renderGrid[i] = 
-			new Quadtree(maxItems, maxLevels, 0, gridBounds, NULL);
-	}
+	m_renderGrid = 
+		createSpatialIndex(indexType, gridBounds, maxItems, maxLevels, cellSize);
 }
 
 RenderSystem::~RenderSystem()
@@ -79,6 +76,51 @@ const Sprite* RenderSystem::getSprite(const int spriteID) const
 	return sprite;
 }
 
+//=============================================================================
+// Function: const ISpatialIndex<EntityData>* getRenderGrid() const
+// Description:
+// Gets the spatial index holding the sprites of every layer, so
+// other systems can run queries like nearest or withinRadius on it.
+// Output:
+// const ISpatialIndex<EntityData>*
+// Returns the index.
+//=============================================================================
+const ISpatialIndex<EntityData>* RenderSystem::getRenderGrid() const
+{
+	return m_renderGrid;
+}
+
+//=============================================================================
+// Function: void searchLayers(const Rectangle&,
+// const unsigned int,
+// vector<VisibleSprite> (&)[LAYER_TOTAL]) const
+// Description:
+// Finds the sprites inside the area on any of the layers in the
+// mask with a single search, putting each one in its layer's list.
+// Parameters:
+// const Rectangle& searchArea - The area to search inside.
+// const unsigned int layerMask - The layers to keep, with bit n set
+// for layer n.
+// vector<VisibleSprite> (&visible)[LAYER_TOTAL] - The list for each
+// layer. They're all cleared first.
+//=============================================================================
+void RenderSystem::searchLayers(const Rectangle& searchArea,
+	const unsigned int layerMask,
+	std::vector<VisibleSprite> (&visible)[LAYER_TOTAL]) const
+{
+	for (int i = 0; i < (int)LAYER_TOTAL; i++)
+	{
+		visible[i].clear();
+	}
+
+	if (m_renderGrid)
+	{
+		LayerVisitor visitor(*this, layerMask, visible);
+
+		m_renderGrid->search(searchArea, visitor);
+	}
+}
+
 //=============================================================================
 // Function: Camera2D* getCamera(const int) const
 // Description:
@@ -209,9 +251,11 @@ const Sprite* RenderSystem::createSprite(const int spriteID,
 			sprite = 
 				new Sprite(texture, size, clip, anchor, workingLayer);
 
-			if (m_renderGrid[workingLayer])
+			if (m_renderGrid && !m_bulkLoading)
 			{
-				m_renderGrid[workingLayer]->addEntity(EntityData(spriteID, sprite->getSize()));
+				m_renderGrid->addEntity(EntityData(spriteID,
+					sprite->getSize(),
+					1 << workingLayer));
 			}
 
 			m_sprites.insert(std::make_pair(spriteID, sprite));
@@ -224,8 +268,9 @@ const Sprite* RenderSystem::createSprite(const int spriteID,
 //=============================================================================
 // Function: void setSpriteLayer(const int, const int)
 // Description:
-// Removes the sprite from it's previous layer and moves the
-// sprite to the new layer.
+// Moves the sprite to the new layer. Every layer shares the render
+// grid, so the sprite stays where it is in it and only its entry's
+// layer bit changes.
 // Parameters:
 // const int spriteID - The id of the sprite.
 // const int layer - The new sprite layer.
@@ -252,17 +297,58 @@ void RenderSystem::setSpriteLayer(const int spriteID,
 				workingLayer = (int)LAYER_TOTAL - 1;
 			}
 
-			if (sprite->getLayer() != workingLayer)
-			{
-				m_renderGrid[sprite->getLayer()]->removeEntity(EntityData(spriteID, sprite->getSize()));
-				m_renderGrid[workingLayer]->addEntity(EntityData(spriteID, sprite->getSize()));
+			sprite->setLayer(workingLayer);
 
-				sprite->setLayer(workingLayer);
+			if (m_renderGrid && !m_bulkLoading)
+			{
+				m_renderGrid->moveEntity(EntityData(spriteID, sprite->getSize(), 1 << workingLayer),
+					sprite->getSize());
 			}
 		}
 	}
 }
 
+//=============================================================================
+// Function: void beginBulkLoad()
+// Description:
+// Starts loading a batch of sprites. Sprites created until
+// endBulkLoad is called aren't added to the render grids one at a
+// time.
+//=============================================================================
+void RenderSystem::beginBulkLoad()
+{
+	m_bulkLoading = true;
+}
+
+//=============================================================================
+// Function: void endBulkLoad(ThreadPool*)
+// Description:
+// Finishes loading by building the render grid from every sprite
+// in one pass.
+// Parameters:
+// ThreadPool *pool - A pool to spread the build across, or NULL.
+//=============================================================================
+void RenderSystem::endBulkLoad(ThreadPool *pool)
+{
+	if (m_bulkLoading)
+	{
+		std::vector<EntityData> entities;
+
+		entities.reserve(m_sprites.size());
+
+		for (auto mit = m_sprites.begin(); mit != m_sprites.end(); mit++)
+		{
+			entities.emplace_back(EntityData(mit->first,
+				mit->second->getSize(),
+				1 << mit->second->getLayer()));
+		}
+
+		m_renderGrid->build(entities, pool);
+
+		m_bulkLoading = false;
+	}
+}
+
 //=============================================================================
 // Function: void addCamera(Camera2D *camera)
 // Description:
@@ -361,94 +447,92 @@ void RenderSystem::renderSprites()
 {
 	Renderer *renderer = ResourceManager::getRenderer();
 
-	if (renderer)
+	if (renderer && m_renderGrid)
 	{
-		for (int i = 0; i < (int)LAYER_UI_BACKGROUND; i++)
+		Vector2D offset(0.0f, 0.0f);
+		float xScale = 1.0f;
+		float yScale = 1.0f;
+
+		Rectangle viewPort(Vector2D(0.0f, 0.0f), 1000, 1000);
+
+		if (m_activeCamera != -1)
 		{
-			if (m_renderGrid[i])
-			{
-				Vector2D offset(0.0f, 0.0f);
-				float xScale = 1.0f;
-				float yScale = 1.0f;
+			Camera2D *camera = m_cameras[m_activeCamera];
 
-				Rectangle viewPort(Vector2D(0.0f, 0.0f), 1000, 1000);
+			if (camera)
+			{
+				offset = camera->getPosition();
 
-				if (m_activeCamera != -1)
-				{
-					Camera2D *camera = m_cameras[m_activeCamera];
+				xScale = camera->getCurrentScaleX();
+				yScale = camera->getCurrentScaleY();
+				
+				offset.m_x *= xScale;
+				offset.m_y *= yScale;
 
-					if (camera)
-					{
-						offset = camera->getPosition();
+				offset.m_x -= camera->getSize().getWidth() / 2;
+				offset.m_y -= camera->getSize().getHeight() / 2;
 
-						xScale = camera->getCurrentScaleX();
-						yScale = camera->getCurrentScaleY();
-						
-						offset.m_x *= xScale;
-						offset.m_y *= yScale;
+				viewPort.setWidth((camera->getSize().getWidth()) / xScale);
+				viewPort.setHeight((camera->getSize().getHeight()) / yScale);
 
-						offset.m_x -= camera->getSize().getWidth() / 2;
-						offset.m_y -= camera->getSize().getHeight() / 2;
+				viewPort.setCenter(camera->getPosition().m_x, camera->getPosition().m_y);
+			}
+		}
+		else if (ResourceManager::getWindow())
+		{
+			viewPort.setWidth(ResourceManager::getWindow()->getWidth());
+			viewPort.setHeight(ResourceManager::getWindow()->getHeight());
 
- 						viewPort.setWidth((camera->getSize().getWidth()) / xScale);
-						viewPort.setHeight((camera->getSize().getHeight()) / yScale);
+			viewPort.setCenter((float)(viewPort.getWidth() / 2), (float)(viewPort.getHeight() / 2));
+		}
 
-						viewPort.setCenter(camera->getPosition().m_x, camera->getPosition().m_y);
-					}
-				}
-				else if (ResourceManager::getWindow())
-				{
-					viewPort.setWidth(ResourceManager::getWindow()->getWidth());
-					viewPort.setHeight(ResourceManager::getWindow()->getHeight());
+		viewPort.setWidth(viewPort.getWidth() + 32);
+		viewPort.setHeight(viewPort.getHeight() + 32);
 
-					viewPort.setCenter((float)(viewPort.getWidth() / 2), (float)(viewPort.getHeight() / 2));
-				}
+		searchLayers(viewPort, WORLD_LAYERS, m_visibleSprites);
 
-				viewPort.setWidth(viewPort.getWidth() + 32);
-				viewPort.setHeight(viewPort.getHeight() + 32);
+		for (int layer = 0; layer < (int)LAYER_UI_BACKGROUND; layer++)
+		{
+			const std::vector<VisibleSprite>& visible = m_visibleSprites[layer];
 
-				std::vector<EntityData> renderItems
-					= m_renderGrid[i]->search(viewPort);
+			for (unsigned int i = 0; i < visible.size(); i++)
+			{
+				const Sprite *sprite = visible[i].m_sprite;
 
-				for (unsigned int i = 0; i < renderItems.size(); i++)
+				if (sprite)
 				{
-					const Sprite *sprite = getSprite(renderItems[i].m_id);
-
-					if (sprite)
-					{
-						Rectangle dest = sprite->getSize();
-						
-						dest.setWidth(dest.getWidth() * xScale);
-						dest.setHeight(dest.getHeight() * yScale);
-						
-						float centerX = round(dest.getCenter().m_x * xScale - offset.m_x);
-						float centerY = round(dest.getCenter().m_y * yScale - offset.m_y);
+					Rectangle dest = sprite->getSize();
+					
+					dest.setWidth(dest.getWidth() * xScale);
+					dest.setHeight(dest.getHeight() * yScale);
+					
+					float centerX = round(dest.getCenter().m_x * xScale - offset.m_x);
+					float centerY = round(dest.getCenter().m_y * yScale - offset.m_y);
 
-						dest.setCenter(centerX, centerY);
+					dest.setCenter(centerX, centerY);
 
-						Rectangle clip = sprite->getClip();
+					Rectangle clip = sprite->getClip();
 
-						Animator *animator = getAnimator(renderItems[i].m_id);
+					Animator *animator = getAnimator(visible[i].m_id);
 
-						if (animator)
+					if (animator)
+					{
+						if (animator->getFrame())
 						{
-							if (animator->getFrame())
-							{
-								clip = *animator->getFrame();
+							clip = *animator->getFrame();
 
-								if (!m_animatorsPaused &&
-									animator->getActive())
-								{
-									animator++;
-								}
+							if (!m_animatorsPaused &&
+								animator->getActive())
+							{
+								animator++;
 							}
 						}
-
-						renderer->drawTexture(*sprite->getTexture(),
-							clip,
-							dest,
-							sprite->getAnchor());
 					}
+
+					renderer->drawTexture(*sprite->getTexture(),
+						clip,
+						dest,
+						sprite->getAnchor());
 				}
 			}
 		}
@@ -464,68 +548,66 @@ void RenderSystem::renderUI()
 {
 	Renderer *renderer = ResourceManager::getRenderer();
 
-	if (renderer)
+	if (renderer && m_renderGrid)
 	{
-		for (int i = (int)LAYER_UI_BACKGROUND; i < (int)LAYER_TOTAL; i++)
+		Rectangle viewPort;
+
+		if (0 < m_cameraCount)
 		{
-			if (m_renderGrid[i])
-			{
-				Rectangle viewPort;
+			Camera2D *camera = m_cameras[m_activeCamera];
 
-				if (0 < m_cameraCount)
-				{
-					Camera2D *camera = m_cameras[m_activeCamera];
+			int width = (int)round(camera->getSize().getWidth() / camera->getCurrentScaleX());
+			int height = (int)round(camera->getSize().getHeight() / camera->getCurrentScaleY());
 
-					int width = (int)round(camera->getSize().getWidth() / camera->getCurrentScaleX());
-					int height = (int)round(camera->getSize().getHeight() / camera->getCurrentScaleY());
+			viewPort.setCenter(camera->getPosition());
+			viewPort.setWidth(width);
+			viewPort.setHeight(height);
+		}
+		else
+		{
+			Window *window = ResourceManager::getWindow();
 
-					viewPort.setCenter(camera->getPosition());
-					viewPort.setWidth(width);
-					viewPort.setHeight(height);
-				}
-				else
-				{
-					Window *window = ResourceManager::getWindow();
+			Vector2D center((float)window->getWidth() / 2.0f,
+				(float)window->getHeight() / 2.0f);
 
-					Vector2D center((float)window->getWidth() / 2.0f,
-						(float)window->getHeight() / 2.0f);
+			viewPort.setWidth(window->getWidth());
+			viewPort.setHeight(window->getHeight());
+			viewPort.setCenter(center);
+		}
 
-					viewPort.setWidth(window->getWidth());
-					viewPort.setHeight(window->getHeight());
-					viewPort.setCenter(center);
-				}
+		searchLayers(viewPort, UI_LAYERS, m_visibleSprites);
 
-				std::vector<EntityData> data =
-					m_renderGrid[i]->search(viewPort);
+		for (int layer = (int)LAYER_UI_BACKGROUND; layer < (int)LAYER_TOTAL; layer++)
+		{
+			const std::vector<VisibleSprite>& visible = m_visibleSprites[layer];
 
-				for (unsigned int i = 0; i < data.size(); i++)
-				{
-					const Sprite *sprite = getSprite(data[i].m_id);
+			for (unsigned int i = 0; i < visible.size(); i++)
+			{
+				const Sprite *sprite = visible[i].m_sprite;
 
-					if (sprite)
-					{
-						Rectangle clip = sprite->getClip();
+				if (sprite)
+				{
+					Rectangle clip = sprite->getClip();
 
-						Animator *animator = getAnimator(data[i].m_id);
+					Animator *animator = getAnimator(visible[i].m_id);
 
-						if (animator)
+					if (animator)
+					{
+						if (animator->getFrame())
 						{
-							if (animator->getFrame())
-							{
-								clip = *animator->getFrame();
+							clip = *animator->getFrame();
 
-								if (animator->getActive())
-								{
-									animator++;
-								}
+							if (animator->getActive())
+							{
+								animator++;
 							}
 						}
-
-						renderer->drawTexture(*sprite->getTexture(),
-							clip,
-							sprite->getSize(),
-							sprite->getAnchor());
 					}
+
+					renderer->drawTexture(*sprite->getTexture(),
+						clip,
+						sprite->getSize(),
+						sprite->getAnchor());
 				}
 			}
 		}
@@ -568,7 +650,8 @@ void RenderSystem::cleanUp()
 {
 	if (m_renderGrid)
 	{
-		delete[] m_renderGrid;
+		delete m_renderGrid;
+		m_renderGrid = NULL;
 	}
 
 	if (m_cameras)
@@ -604,4 +687,30 @@ void RenderSystem::cleanUp()
 			animatorIt++;
 		}
 	}
-}
\ No newline at end of file
+}
+
+//=============================================================================
+// Function: bool visit(const EntityData&)
+// Description:
+// Adds the sprite to its layer's list if the layer is in the mask.
+// The sprite is only found once its entry's layer bit has passed.
+// Parameters:
+// const EntityData& entity - The sprite's entry in the render grid.
+// Output:
+// bool
+// Returns true so the search carries on.
+//=============================================================================
+bool RenderSystem::LayerVisitor::visit(const EntityData& entity)
+{
+	if ((m_layerMask & entity.m_flags) != 0)
+	{
+		const Sprite *sprite = m_system.getSprite(entity.m_id);
+
+		if (sprite)
+		{
+			m_visible[sprite->getLayer()].emplace_back(VisibleSprite(entity.m_id, sprite));
+		}
+	}
+
+	return true;
+}
@@ -5,11 +5,13 @@
 // Date Created: 10/25/2019
 // Purpose: 
 // Handles all the rendering and resource management for render
-// items.
+// items. Every sprite lives in one spatial index whatever its layer,
+// and a search takes a mask of the layers it wants and hands back
+// the visible sprites already split up by layer.
 //==========================================================================================
 #include <map>
 #include <string>
-#include "Quadtree.h"
+#include "SpatialIndex.h"
 #include "Rectangle.h"
 
 typedef std::string string;
@@ -36,9 +38,32 @@ public:
 		LAYER_TOTAL
 	};
 
+	// Masks of layers to search, with bit n set for layer n.
+	static const unsigned int WORLD_LAYERS = (1 << LAYER_UI_BACKGROUND) - 1;
+	static const unsigned int UI_LAYERS = ((1 << LAYER_TOTAL) - 1) & ~WORLD_LAYERS;
+	static const unsigned int ALL_LAYERS = (1 << LAYER_TOTAL) - 1;
+
+	// A sprite found by searchLayers. The id is kept for finding its
+	// animator.
+	struct VisibleSprite
+	{
+		VisibleSprite(const int id,
+			const Sprite *sprite)
+			:m_id(id),
+			m_sprite(sprite)
+		{
+
+		}
+
+		int m_id;
+		const Sprite *m_sprite;
+	};
+
 	RenderSystem(const Rectangle& gridBounds,
 		const int maxItems,
-		const int maxLevels);
+		const int maxLevels,
+		const SpatialIndexType indexType = INDEX_QUADTREE,
+		const int cellSize = 256);
 	~RenderSystem();
 
 	const Animator* getAnimator(const int animatorID) const;
@@ -46,6 +71,12 @@ public:
 
 	Camera2D* getCamera(const int index) const;
 
+	const ISpatialIndex<EntityData>* getRenderGrid() const;
+
+	void searchLayers(const Rectangle& searchArea,
+		const unsigned int layerMask,
+		std::vector<VisibleSprite> (&visible)[LAYER_TOTAL]) const;
+
 	const Animator* createAnimator(const int animatorID,
 		const string animationSetName,
 		const string animationName,
@@ -61,6 +92,9 @@ public:
 	void setSpriteLayer(const int spriteID, 
 		const RenderLayer layer);
 
+	void beginBulkLoad();
+	void endBulkLoad(ThreadPool *pool = NULL);
+
 	void addCamera(Camera2D *camera);
 
 	void clear();
@@ -71,10 +105,38 @@ public:
 	void renderUI();
 
 private:
+	// Sorts the sprites it visits into their layer's list. Each entry
+	// in the render grid carries its layer's bit in its flags, so the
+	// layers that aren't in the mask are skipped without finding the
+	// sprite.
+	class LayerVisitor : public ISpatialVisitor<EntityData>
+	{
+	public:
+		LayerVisitor(const RenderSystem& system,
+			const unsigned int layerMask,
+			std::vector<VisibleSprite> (&visible)[LAYER_TOTAL])
+			:m_system(system),
+			m_layerMask(layerMask),
+			m_visible(visible)
+		{
+
+		}
+
+		virtual bool visit(const EntityData& entity);
+
+	private:
+		const RenderSystem& m_system;
+		unsigned int m_layerMask;
+		std::vector<VisibleSprite> (&m_visible)[LAYER_TOTAL];
+	};
+
 	std::map<int, Animator*> m_animators;
 	std::map<int, Sprite*> m_sprites;
 
-	Quadtree **m_renderGrid;
+	ISpatialIndex<EntityData> *m_renderGrid;
+
+	// Reused by every search so rendering doesn't allocate.
+	std::vector<VisibleSprite> m_visibleSprites[LAYER_TOTAL];
 	Camera2D **m_cameras;
 
 	int m_cameraCount;
@@ -82,6 +144,10 @@ private:
 	
 	bool m_animatorsPaused;
 
+	// While loading, new sprites are left out of the render grids
+	// until they're all built at the end.
+	bool m_bulkLoading;
+
 	Animator* getAnimator(const int animatorID);
 	void cleanUp();
 };
@@ -1,6 +1,27 @@
 #include "Rotation.h"
 #include <cmath>
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define ROTATION_SSE
+#include <emmintrin.h>
+#endif
+
+//=============================================================================
+// Function: RotationVector(const float)
+// Description:
+// Works out the sine and cosine of a rotation.
+// Parameters:
+// const float percent - The rotation, as a percent of a full turn.
+//=============================================================================
+RotationVector::RotationVector(const float percent)
+{
+	float degrees = percentToDegrees(percent);
+	float radians = degreesToRadians(degrees);
+
+	m_sine = sin(radians);
+	m_cosine = cos(radians);
+}
+
 //=============================================================================
 // Function: float radiansToDegrees(const float)
 // Description:
@@ -105,6 +126,7 @@ float angleToDegrees(const Vector2D& origin,
 // Parameters:
 // const Vector2D& origin - The origin point to rotate around.
 // const Vector2D& point - The point to rotate.
+// const float percent - The rotation, as a percent of a full turn.
 // Output:
 // Vector2D
 // Returns a vector containing the rotated point.
@@ -112,18 +134,139 @@ float angleToDegrees(const Vector2D& origin,
 Vector2D rotatePoint(const Vector2D& origin,
 	const Vector2D& point,
 	const float percent)
+{
+	return rotatePoint(origin, point, RotationVector(percent));
+}
+
+//=============================================================================
+// Function: Vector2D rotatePoint(const Vector2D&,
+//								  const Vector2D&,
+//								  const RotationVector&,
+//								  const RotationAccuracy)
+// Description:
+// Rotates a point around the origin with a rotation that's already
+// been worked out.
+// Parameters:
+// const Vector2D& origin - The origin point to rotate around.
+// const Vector2D& point - The point to rotate.
+// const RotationVector& rotation - The rotation to use.
+// const RotationAccuracy accuracy - Whether to round the result.
+// Output:
+// Vector2D
+// Returns a vector containing the rotated point.
+//=============================================================================
+Vector2D rotatePoint(const Vector2D& origin,
+	const Vector2D& point,
+	const RotationVector& rotation,
+	const RotationAccuracy accuracy)
 {
 	float tempX = point.m_x - origin.m_x;
 	float tempY = point.m_y - origin.m_y;
 
-	float degrees = percentToDegrees(percent);
-	float radians = degreesToRadians(degrees);
-
-	float radSine = sin(radians);
-	float radCosine = cos(radians);
+	float rotatedX = (tempX * rotation.m_cosine) - (tempY * rotation.m_sine);
+	float rotatedY = (tempX * rotation.m_sine) + (tempY * rotation.m_cosine);
 
-	float rotatedX = round((tempX * radCosine) - (tempY * radSine));
-	float rotatedY = round((tempX * radSine) + (tempY * radCosine));
+	if (accuracy == ROTATE_ROUNDED)
+	{
+		rotatedX = round(rotatedX);
+		rotatedY = round(rotatedY);
+	}
 
 	return Vector2D(origin.m_x + rotatedX, origin.m_y + rotatedY);
-}
\ No newline at end of file
+}
+
+#ifdef ROTATION_SSE
+// rotatePoints loads two points at a time as four floats.
+static_assert(sizeof(Vector2D) == 2 * sizeof(float), "Vector2D must be two packed floats");
+
+//=============================================================================
+// Function: __m128 roundAway(const __m128)
+// Description:
+// Rounds four floats to the nearest whole number with halves going
+// away from 0, the same as round. SSE's own conversion rounds halves
+// to even, so the whole part is cut off and the fraction checked
+// instead. Values too big to have a fraction are left alone.
+// Parameters:
+// const __m128 values - The values to round.
+// Output:
+// __m128
+// Returns the rounded values.
+//=============================================================================
+static __m128 roundAway(const __m128 values)
+{
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 noFraction = _mm_set1_ps(8388608.0f);
+
+	__m128 sign = _mm_and_ps(values, signMask);
+	__m128 magnitude = _mm_andnot_ps(signMask, values);
+
+	__m128 whole = _mm_cvtepi32_ps(_mm_cvttps_epi32(magnitude));
+	__m128 fraction = _mm_sub_ps(magnitude, whole);
+
+	whole = _mm_add_ps(whole, _mm_and_ps(_mm_cmpge_ps(fraction, half), one));
+
+	__m128 big = _mm_cmpge_ps(magnitude, noFraction);
+	__m128 rounded = _mm_or_ps(_mm_and_ps(big, magnitude), _mm_andnot_ps(big, whole));
+
+	return _mm_or_ps(rounded, sign);
+}
+#endif
+
+//=============================================================================
+// Function: void rotatePoints(const Vector2D&,
+//							   const RotationVector&,
+//							   const Vector2D*,
+//							   Vector2D*,
+//							   const int,
+//							   const RotationAccuracy)
+// Description:
+// Rotates a run of points around the same origin. With SSE, two
+// points are rotated at once, and the results match rotatePoint
+// exactly. Points and rotated can be the same array.
+// Parameters:
+// const Vector2D& origin - The origin point to rotate around.
+// const RotationVector& rotation - The rotation to use.
+// const Vector2D *points - The points to rotate.
+// Vector2D *rotated - Where to put the rotated points.
+// const int count - How many points there are.
+// const RotationAccuracy accuracy - Whether to round the results.
+//=============================================================================
+void rotatePoints(const Vector2D& origin,
+	const RotationVector& rotation,
+	const Vector2D *points,
+	Vector2D *rotated,
+	const int count,
+	const RotationAccuracy accuracy)
+{
+	int i = 0;
+
+#ifdef ROTATION_SSE
+	const __m128 origins = _mm_setr_ps(origin.m_x, origin.m_y, origin.m_x, origin.m_y);
+	const __m128 cosines = _mm_set1_ps(rotation.m_cosine);
+
+	// x * cos - y * sin and y * cos + x * sin, once x and y are swapped.
+	const __m128 sines = _mm_setr_ps(-rotation.m_sine, rotation.m_sine, -rotation.m_sine, rotation.m_sine);
+
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128 offsets = _mm_sub_ps(_mm_loadu_ps(&points[i].m_x), origins);
+		__m128 swapped = _mm_shuffle_ps(offsets, offsets, _MM_SHUFFLE(2, 3, 0, 1));
+
+		__m128 turned = _mm_add_ps(_mm_mul_ps(offsets, cosines), _mm_mul_ps(swapped, sines));
+
+		if (accuracy == ROTATE_ROUNDED)
+		{
+			turned = roundAway(turned);
+		}
+
+		_mm_storeu_ps(&rotated[i].m_x, _mm_add_ps(origins, turned));
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		rotated[i] = rotatePoint(origin, points[i], rotation, accuracy);
+	}
+}
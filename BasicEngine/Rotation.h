@@ -5,12 +5,52 @@
 // Date Created: 10/18/2019
 // Purpose: 
 // Holds functions for rotating points around a point.
+// A rotation can be kept as a RotationVector, its sine and cosine,
+// so they're only worked out when it changes rather than for every
+// point. Runs of points can be rotated together, two at a time with
+// SSE where it's there.
 //==========================================================================================
 #include "Vector2D.h"
 
 #define _PI 3.14159
 #define _CIRCLE_DEGREES 360
 
+// How a rotated point is rounded. ROTATE_ROUNDED rounds its offset
+// from the origin to whole pixels, the way rotatePoint always has, so
+// rotated corners stay on the pixel grid. ROTATE_EXACT keeps the
+// fractions, for physics that needs the true position.
+enum RotationAccuracy
+{
+	ROTATE_ROUNDED,
+	ROTATE_EXACT
+};
+
+// A rotation as the sine and cosine of its angle.
+struct RotationVector
+{
+	RotationVector()
+		:m_sine(0.0f), m_cosine(1.0f)
+	{
+
+	}
+
+	RotationVector(const float percent);
+
+	// The same rotation the other way.
+	const RotationVector inverse() const
+	{
+		RotationVector inverted;
+
+		inverted.m_sine = -m_sine;
+		inverted.m_cosine = m_cosine;
+
+		return inverted;
+	}
+
+	float m_sine;
+	float m_cosine;
+};
+
 float radiansToDegrees(const float radians);
 float degreesToRadians(const float degrees);
 float percentToDegrees(const float percent);
@@ -19,4 +59,15 @@ float angleToDegrees(const Vector2D& origin,
 
 Vector2D rotatePoint(const Vector2D& origin,
 	const Vector2D& point,
-	const float percent);
\ No newline at end of file
+	const float percent);
+Vector2D rotatePoint(const Vector2D& origin,
+	const Vector2D& point,
+	const RotationVector& rotation,
+	const RotationAccuracy accuracy = ROTATE_ROUNDED);
+
+void rotatePoints(const Vector2D& origin,
+	const RotationVector& rotation,
+	const Vector2D *points,
+	Vector2D *rotated,
+	const int count,
+	const RotationAccuracy accuracy = ROTATE_ROUNDED);
\ No newline at end of file
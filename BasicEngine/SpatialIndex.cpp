@@ -0,0 +1,76 @@
+#include "SpatialIndex.h"
+#include "Quadtree.h"
+#include "Grid.h"
+#include "SweepAndPrune.h"
+#include "AABBTree.h"
+#include "HashedQuadtree.h"
+
+//=============================================================================
+// Function: ISpatialIndex<EntityData>* createSpatialIndex(
+// const SpatialIndexType,
+// const Rectangle&,
+// const int,
+// const int,
+// const int)
+// Description:
+// Creates the requested spatial index. The quad trees use the
+// object and level limits, the grid uses the cell size. The hashed
+// quad tree uses all three and ignores the bounds. Sweep and prune
+// and the AABB tree don't need any of them.
+// Parameters:
+// const SpatialIndexType type - The kind of index to create.
+// const Rectangle& bounds - The area the index covers.
+// const int maxObjects - The objects a quad tree node holds before
+// splitting.
+// const int maxLevels - The deepest a quad tree can split.
+// const int cellSize - The width and height of a grid cell, or of
+// the smallest cells of a hashed quad tree.
+// Output:
+// ISpatialIndex<EntityData>*
+// Returns the created index. The caller owns it.
+//=============================================================================
+ISpatialIndex<EntityData>* createSpatialIndex(const SpatialIndexType type,
+	const Rectangle& bounds,
+	const int maxObjects,
+	const int maxLevels,
+	const int cellSize)
+{
+	ISpatialIndex<EntityData> *index = NULL;
+
+	switch (type)
+	{
+	case INDEX_GRID:
+	{
+		index = new Grid<EntityData>(bounds, cellSize, cellSize);
+		break;
+	}
+	case INDEX_SWEEP_AND_PRUNE:
+	{
+		index = new SweepAndPrune();
+		break;
+	}
+	case INDEX_AABB_TREE:
+	{
+		index = new AABBTree();
+		break;
+	}
+	case INDEX_HASHED_QUADTREE:
+	{
+		index = new HashedQuadtree(cellSize, maxObjects, maxLevels);
+		break;
+	}
+	case INDEX_LOOSE_QUADTREE:
+	{
+		index = new Quadtree(maxObjects, maxLevels, bounds, Quadtree::LOOSE);
+		break;
+	}
+	case INDEX_QUADTREE:
+	default:
+	{
+		index = new Quadtree(maxObjects, maxLevels, bounds);
+		break;
+	}
+	}
+
+	return index;
+}
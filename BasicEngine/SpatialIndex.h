@@ -0,0 +1,25 @@
+#pragma once
+//==========================================================================================
+// File Name: SpatialIndex.h
+// Author: Brian Blackmon
+// Date Created: 11/4/2019
+// Purpose:
+// Creates the spatial storage the systems use for their entities.
+//==========================================================================================
+#include "ISpatialIndex.h"
+
+enum SpatialIndexType
+{
+	INDEX_QUADTREE,
+	INDEX_LOOSE_QUADTREE,
+	INDEX_GRID,
+	INDEX_SWEEP_AND_PRUNE,
+	INDEX_AABB_TREE,
+	INDEX_HASHED_QUADTREE
+};
+
+ISpatialIndex<EntityData>* createSpatialIndex(const SpatialIndexType type,
+	const Rectangle& bounds,
+	const int maxObjects,
+	const int maxLevels,
+	const int cellSize);
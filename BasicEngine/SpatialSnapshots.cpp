@@ -0,0 +1,148 @@
+#include "SpatialSnapshots.h"
+#include <thread>
+
+SpatialSnapshots::SpatialSnapshots(const ISpatialIndex<EntityData>& index)
+	:m_front(0),
+	m_epoch(0)
+{
+	for (int i = 0; i < BUFFER_COUNT; i++)
+	{
+		m_buffers[i] = index.createSnapshot();
+		m_readers[i] = 0;
+	}
+}
+
+SpatialSnapshots::~SpatialSnapshots()
+{
+	cleanUp();
+}
+
+//=============================================================================
+// Function: const bool isSupported() const
+// Description:
+// Checks if the index could be copied into snapshots.
+// Output:
+// const bool
+// Returns true if snapshots are available.
+//=============================================================================
+const bool SpatialSnapshots::isSupported() const
+{
+	return m_buffers[0] != NULL && m_buffers[1] != NULL;
+}
+
+//=============================================================================
+// Function: const unsigned int getEpoch() const
+// Description:
+// Gets how many snapshots have been published, so readers can tell
+// if a newer one is out.
+// Output:
+// const unsigned int
+// Returns the epoch.
+//=============================================================================
+const unsigned int SpatialSnapshots::getEpoch() const
+{
+	return m_epoch;
+}
+
+//=============================================================================
+// Function: void publish(const ISpatialIndex<EntityData>&)
+// Description:
+// Copies the index into the back buffer and makes it the one
+// readers are given. Waits for any readers still using the back
+// buffer from two publishes ago. Only the thread that owns the
+// index should call this.
+// Parameters:
+// const ISpatialIndex<EntityData>& index - The index the snapshots
+// were created from.
+//=============================================================================
+void SpatialSnapshots::publish(const ISpatialIndex<EntityData>& index)
+{
+	if (isSupported())
+	{
+		int back = 1 - m_front;
+
+		while (m_readers[back] != 0)
+		{
+			std::this_thread::yield();
+		}
+
+		index.updateSnapshot(*m_buffers[back]);
+
+		m_front = back;
+		m_epoch++;
+	}
+}
+
+//=============================================================================
+// Function: const ISpatialIndex<EntityData>* acquire()
+// Description:
+// Gets the last published snapshot and holds it until release is
+// called. Safe to call from any thread while the index changes.
+// Output:
+// const ISpatialIndex<EntityData>*
+// On success - Returns the snapshot to search.
+// On failure - Returns NULL if snapshots aren't supported.
+//=============================================================================
+const ISpatialIndex<EntityData>* SpatialSnapshots::acquire()
+{
+	const ISpatialIndex<EntityData> *snapshot = NULL;
+
+	if (isSupported())
+	{
+		int front = m_front;
+
+		m_readers[front]++;
+
+		// A publish can land between reading the front and holding
+		// it, in which case the buffer may be getting written, so
+		// let go and try the new front.
+		while (front != m_front)
+		{
+			m_readers[front]--;
+
+			front = m_front;
+
+			m_readers[front]++;
+		}
+
+		snapshot = m_buffers[front];
+	}
+
+	return snapshot;
+}
+
+//=============================================================================
+// Function: void release(const ISpatialIndex<EntityData>*)
+// Description:
+// Lets go of a snapshot from acquire so it can be written again.
+// Parameters:
+// const ISpatialIndex<EntityData> *snapshot - The snapshot to
+// release. NULL is ignored.
+//=============================================================================
+void SpatialSnapshots::release(const ISpatialIndex<EntityData> *snapshot)
+{
+	for (int i = 0; i < BUFFER_COUNT; i++)
+	{
+		if (snapshot != NULL && snapshot == m_buffers[i])
+		{
+			m_readers[i]--;
+		}
+	}
+}
+
+//=============================================================================
+// Function: void cleanUp()
+// Description:
+// Deletes the snapshot buffers.
+//=============================================================================
+void SpatialSnapshots::cleanUp()
+{
+	for (int i = 0; i < BUFFER_COUNT; i++)
+	{
+		if (m_buffers[i])
+		{
+			delete m_buffers[i];
+			m_buffers[i] = NULL;
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+//==========================================================================================
+// File Name: SpatialSnapshots.h
+// Author: Brian Blackmon
+// Date Created: 11/9/2019
+// Purpose:
+// Double buffered read-only copies of a spatial index. The thread
+// that owns the index publishes a copy once it's done changing it,
+// and other threads search the last published copy without locking
+// while the owner works on the next one. Each buffer counts the
+// readers using it, and the owner waits for a buffer to empty
+// before copying over it.
+//==========================================================================================
+#include "ISpatialIndex.h"
+#include <atomic>
+
+class SpatialSnapshots
+{
+public:
+	SpatialSnapshots(const ISpatialIndex<EntityData>& index);
+	~SpatialSnapshots();
+
+	const bool isSupported() const;
+	const unsigned int getEpoch() const;
+
+	void publish(const ISpatialIndex<EntityData>& index);
+
+	const ISpatialIndex<EntityData>* acquire();
+	void release(const ISpatialIndex<EntityData> *snapshot);
+
+private:
+	static const int BUFFER_COUNT = 2;
+
+	ISpatialIndex<EntityData> *m_buffers[BUFFER_COUNT];
+	std::atomic<int> m_readers[BUFFER_COUNT];
+
+	// The buffer readers are given.
+	std::atomic<int> m_front;
+
+	// How many times a snapshot has been published.
+	std::atomic<unsigned int> m_epoch;
+
+	void cleanUp();
+};
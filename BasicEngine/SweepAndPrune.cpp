@@ -0,0 +1,847 @@
+#include "SweepAndPrune.h"
+#include "Collision.h"
+#include "BBMath.h"
+#include <algorithm>
+#include <cfloat>
+
+SweepAndPrune::SweepAndPrune()
+	:m_freeEntry(NO_INDEX),
+	m_count(0),
+	m_maxWidth(0.0f)
+{
+
+}
+
+SweepAndPrune::~SweepAndPrune()
+{
+	clear();
+}
+
+//=============================================================================
+// Function: const int getCount() const
+// Description:
+// Gets the number of entities stored.
+// Output:
+// const int
+// Returns the entity count.
+//=============================================================================
+const int SweepAndPrune::getCount() const
+{
+	return m_count;
+}
+
+//=============================================================================
+// Function: void search(const Rectangle&,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Walks the x endpoints that could belong to an entity inside the
+// area and visits the entities that collide with it. The area is
+// padded like the entries, so entities whose rounded corners only
+// just reach it aren't skipped.
+// Parameters:
+// const Rectangle& searchArea - The area to search inside.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call. The
+// search stops as soon as it returns false.
+//=============================================================================
+void SweepAndPrune::search(const Rectangle& searchArea,
+	ISpatialVisitor<EntityData>& visitor) const
+{
+	float minX = searchArea.getMinX() - PADDING;
+	float minY = searchArea.getMinY() - PADDING;
+	float maxX = searchArea.getMaxX() + PADDING;
+	float maxY = searchArea.getMaxY() + PADDING;
+
+	const std::vector<Endpoint>& endpoints = m_endpoints[AXIS_X];
+
+	for (int i = findFirstEndpoint(minX - m_maxWidth);
+		i < (int)endpoints.size() && endpoints[i].m_value <= maxX;
+		i++)
+	{
+		int entry = endpoints[i].m_entry;
+
+		if (!endpoints[i].m_isMax &&
+			overlapsArea(entry, minX, minY, maxX, maxY) &&
+			rectIntersectRect(searchArea, m_entries[entry].m_data.m_size) &&
+			!visitor.visit(m_entries[entry].m_data))
+		{
+			return;
+		}
+	}
+}
+
+//=============================================================================
+// Function: void search(const Line&,
+// ISpatialVisitor<EntityData>&) const
+// Description:
+// Walks the x endpoints that could belong to an entity under the
+// line and visits the entities the line touches.
+// Parameters:
+// const Line& searchLine - The line to search along.
+// ISpatialVisitor<EntityData>& visitor - The visitor to call. The
+// search stops as soon as it returns false.
+//=============================================================================
+void SweepAndPrune::search(const Line& searchLine,
+	ISpatialVisitor<EntityData>& visitor) const
+{
+	float minX = 0.0f;
+	float minY = 0.0f;
+	float maxX = 0.0f;
+	float maxY = 0.0f;
+
+	fMin(minX, searchLine.m_start.m_x, searchLine.m_end.m_x);
+	fMin(minY, searchLine.m_start.m_y, searchLine.m_end.m_y);
+	fMax(maxX, searchLine.m_start.m_x, searchLine.m_end.m_x);
+	fMax(maxY, searchLine.m_start.m_y, searchLine.m_end.m_y);
+
+	minX -= PADDING;
+	minY -= PADDING;
+	maxX += PADDING;
+	maxY += PADDING;
+
+	const std::vector<Endpoint>& endpoints = m_endpoints[AXIS_X];
+
+	for (int i = findFirstEndpoint(minX - m_maxWidth);
+		i < (int)endpoints.size() && endpoints[i].m_value <= maxX;
+		i++)
+	{
+		int entry = endpoints[i].m_entry;
+
+		if (!endpoints[i].m_isMax &&
+			overlapsArea(entry, minX, minY, maxX, maxY) &&
+			lineInRect(m_entries[entry].m_data.m_size, searchLine) &&
+			!visitor.visit(m_entries[entry].m_data))
+		{
+			return;
+		}
+	}
+}
+
+//=============================================================================
+// Function: void addEntity(const EntityData&)
+// Description:
+// Adds the entity's endpoints to the end of each axis and sorts
+// them into place, picking up its overlapping pairs on the way.
+// Parameters:
+// const EntityData& entity - The entity to add.
+//=============================================================================
+void SweepAndPrune::addEntity(const EntityData& entity)
+{
+	int entry = createEntry(entity);
+
+	m_entryLookup[entity.m_id] = entry;
+	m_count++;
+
+	setBounds(entry, entity.m_size);
+
+	for (int axis = 0; axis < AXIS_COUNT; axis++)
+	{
+		std::vector<Endpoint>& endpoints = m_endpoints[axis];
+
+		endpoints.emplace_back(Endpoint(m_entries[entry].m_min[axis], entry, false));
+		setEndpointIndex(axis, (int)endpoints.size() - 1);
+
+		endpoints.emplace_back(Endpoint(m_entries[entry].m_max[axis], entry, true));
+		setEndpointIndex(axis, (int)endpoints.size() - 1);
+
+		sortDown(axis, m_entries[entry].m_minEndpoint[axis]);
+		sortDown(axis, m_entries[entry].m_maxEndpoint[axis]);
+	}
+}
+
+//=============================================================================
+// Function: void removeEntity(const EntityData&)
+// Description:
+// Sorts the entity's endpoints past everything else, which drops
+// its pairs, then takes them off the end of each axis.
+// Parameters:
+// const EntityData& entity - The entity to remove.
+//=============================================================================
+void SweepAndPrune::removeEntity(const EntityData& entity)
+{
+	auto lookup = m_entryLookup.find(entity.m_id);
+
+	if (lookup != m_entryLookup.end())
+	{
+		int entry = lookup->second;
+
+		m_entryLookup.erase(lookup);
+
+		SweepEntry& sweepEntry = m_entries[entry];
+
+		for (int axis = 0; axis < AXIS_COUNT; axis++)
+		{
+			sweepEntry.m_min[axis] = FLT_MAX;
+			sweepEntry.m_max[axis] = FLT_MAX;
+
+			m_endpoints[axis][sweepEntry.m_minEndpoint[axis]].m_value = FLT_MAX;
+			m_endpoints[axis][sweepEntry.m_maxEndpoint[axis]].m_value = FLT_MAX;
+
+			sortUp(axis, sweepEntry.m_maxEndpoint[axis]);
+			sortUp(axis, sweepEntry.m_minEndpoint[axis]);
+
+			eraseEndpoint(axis, sweepEntry.m_maxEndpoint[axis]);
+			eraseEndpoint(axis, sweepEntry.m_minEndpoint[axis]);
+		}
+
+		releaseEntry(entry);
+
+		m_count--;
+	}
+}
+
+//=============================================================================
+// Function: void moveEntity(const EntityData&, const Rectangle&)
+// Description:
+// Moves an entity to a new size by sorting its endpoints from
+// where they were. Pairs start and stop as endpoints pass each
+// other. The old size isn't needed.
+// Parameters:
+// const EntityData& entity - The entity at its old size.
+// const Rectangle& size - The new size.
+//=============================================================================
+void SweepAndPrune::moveEntity(const EntityData& entity,
+	const Rectangle& size)
+{
+	auto lookup = m_entryLookup.find(entity.m_id);
+
+	if (lookup != m_entryLookup.end())
+	{
+		int entry = lookup->second;
+
+		SweepEntry& sweepEntry = m_entries[entry];
+
+		sweepEntry.m_data.m_size = size;
+		sweepEntry.m_data.m_flags = entity.m_flags;
+
+		setBounds(entry, size);
+
+		for (int axis = 0; axis < AXIS_COUNT; axis++)
+		{
+			std::vector<Endpoint>& endpoints = m_endpoints[axis];
+
+			endpoints[sweepEntry.m_minEndpoint[axis]].m_value = sweepEntry.m_min[axis];
+			endpoints[sweepEntry.m_maxEndpoint[axis]].m_value = sweepEntry.m_max[axis];
+
+			// The leading endpoint goes first in each direction so the
+			// other one never gets stuck behind where it used to be.
+			sortUp(axis, sweepEntry.m_maxEndpoint[axis]);
+			sortUp(axis, sweepEntry.m_minEndpoint[axis]);
+
+			sortDown(axis, sweepEntry.m_minEndpoint[axis]);
+			sortDown(axis, sweepEntry.m_maxEndpoint[axis]);
+		}
+	}
+}
+
+//=============================================================================
+// Function: void nearest(const Vector2D&,
+// const int,
+// vector<EntityData>&) const
+// Description:
+// Finds the entities whose centers are closest to the point by
+// walking the x endpoints outwards from it. Each side stops once
+// an entry that far along x can't be closer than what's kept.
+// Parameters:
+// const Vector2D& point - The point to search from.
+// const int count - The most entities to find.
+// vector<EntityData>& nearest - Filled with the entities, closest
+// first. It's cleared first.
+//=============================================================================
+void SweepAndPrune::nearest(const Vector2D& point,
+	const int count,
+	std::vector<EntityData>& nearest) const
+{
+	nearest.clear();
+
+	if (0 < count)
+	{
+		const std::vector<Endpoint>& endpoints = m_endpoints[AXIS_X];
+
+		int start = findFirstEndpoint(point.m_x);
+
+		// A center is never left of its entry's min.
+		for (int i = start; i < (int)endpoints.size(); i++)
+		{
+			if (!endpoints[i].m_isMax)
+			{
+				float gap = endpoints[i].m_value - point.m_x;
+
+				if (!canBeNearer(gap * gap, point, count, nearest))
+				{
+					break;
+				}
+
+				keepNearest(m_entries[endpoints[i].m_entry].m_data, point, count, nearest);
+			}
+		}
+
+		// And never further right of it than the widest entry.
+		for (int i = start - 1; 0 <= i; i--)
+		{
+			if (!endpoints[i].m_isMax)
+			{
+				float gap = point.m_x - (endpoints[i].m_value + m_maxWidth);
+
+				if (0.0f < gap &&
+					!canBeNearer(gap * gap, point, count, nearest))
+				{
+					break;
+				}
+
+				keepNearest(m_entries[endpoints[i].m_entry].m_data, point, count, nearest);
+			}
+		}
+
+		sortNearest(point, nearest);
+	}
+}
+
+//=============================================================================
+// Function: void forEachOverlappingPair(ISpatialPairVisitor<EntityData>&) const
+// Description:
+// Visits every pair of overlapping entities. The pairs whose boxes
+// overlap are already known, so only they get the exact test.
+// Parameters:
+// ISpatialPairVisitor<EntityData>& visitor - The visitor to call.
+// The search stops as soon as it returns false.
+//=============================================================================
+void SweepAndPrune::forEachOverlappingPair(ISpatialPairVisitor<EntityData>& visitor) const
+{
+	for (auto sit = m_pairs.begin(); sit != m_pairs.end(); sit++)
+	{
+		const EntityData& first = m_entries[(int)(*sit >> 32)].m_data;
+		const EntityData& second = m_entries[(int)(*sit & 0xFFFFFFFF)].m_data;
+
+		if (pairOverlaps(first, second) &&
+			!visitor.visit(first, second))
+		{
+			return;
+		}
+	}
+}
+
+//=============================================================================
+// Function: void clear()
+// Description:
+// Removes every entity and pair, and forgets the pair changes.
+//=============================================================================
+void SweepAndPrune::clear()
+{
+	m_entries.clear();
+	m_entryLookup.clear();
+	m_pairs.clear();
+	m_pairChanges.clear();
+
+	for (int axis = 0; axis < AXIS_COUNT; axis++)
+	{
+		m_endpoints[axis].clear();
+	}
+
+	m_freeEntry = NO_INDEX;
+	m_count = 0;
+	m_maxWidth = 0.0f;
+}
+
+//=============================================================================
+// Function: void build(const vector<EntityData>&, ThreadPool*)
+// Description:
+// Replaces everything with a new set of entities. The endpoints
+// are sorted once, then a single sweep along x finds the pairs.
+// Every pair found is reported as added.
+// Parameters:
+// const vector<EntityData>& entities - The entities to store.
+// ThreadPool *pool - Not used, the sort is already cheap next to
+// adding one at a time.
+//=============================================================================
+void SweepAndPrune::build(const std::vector<EntityData>& entities,
+	ThreadPool * /*pool*/)
+{
+	clear();
+
+	m_entries.reserve(entities.size());
+
+	for (unsigned int i = 0; i < entities.size(); i++)
+	{
+		int entry = createEntry(entities[i]);
+
+		m_entryLookup[entities[i].m_id] = entry;
+		m_count++;
+
+		setBounds(entry, entities[i].m_size);
+	}
+
+	for (int axis = 0; axis < AXIS_COUNT; axis++)
+	{
+		std::vector<Endpoint>& endpoints = m_endpoints[axis];
+
+		endpoints.reserve(m_entries.size() * 2);
+
+		for (unsigned int i = 0; i < m_entries.size(); i++)
+		{
+			endpoints.emplace_back(Endpoint(m_entries[i].m_min[axis], (int)i, false));
+			endpoints.emplace_back(Endpoint(m_entries[i].m_max[axis], (int)i, true));
+		}
+
+		std::sort(endpoints.begin(), endpoints.end(), endpointLess);
+
+		for (unsigned int i = 0; i < endpoints.size(); i++)
+		{
+			setEndpointIndex(axis, (int)i);
+		}
+	}
+
+	// Sweep along x keeping the entries that are open, and test each
+	// entry that opens against them on y.
+	std::vector<int> active;
+	std::vector<int> activeIndex(m_entries.size(), (int)NO_INDEX);
+
+	const std::vector<Endpoint>& endpoints = m_endpoints[AXIS_X];
+
+	for (unsigned int i = 0; i < endpoints.size(); i++)
+	{
+		int entry = endpoints[i].m_entry;
+
+		if (!endpoints[i].m_isMax)
+		{
+			for (unsigned int j = 0; j < active.size(); j++)
+			{
+				if (boundsOverlap(active[j], entry))
+				{
+					addPair(active[j], entry);
+				}
+			}
+
+			activeIndex[entry] = (int)active.size();
+			active.push_back(entry);
+		}
+		else
+		{
+			int index = activeIndex[entry];
+
+			active[index] = active.back();
+			activeIndex[active[index]] = index;
+			active.pop_back();
+		}
+	}
+}
+
+//=============================================================================
+// Function: void collectPairChanges(vector<SweepPair>&,
+// vector<SweepPair>&)
+// Description:
+// Gets the pairs whose boxes started or stopped overlapping since
+// the last time this was called, usually once a frame. A pair that
+// starts and stops again in between isn't reported. Removing an
+// entity stops all of its pairs.
+// Parameters:
+// vector<SweepPair>& added - Filled with the pairs that started.
+// It's cleared first.
+// vector<SweepPair>& removed - Filled with the pairs that stopped.
+// It's cleared first.
+//=============================================================================
+void SweepAndPrune::collectPairChanges(std::vector<SweepPair>& added,
+	std::vector<SweepPair>& removed)
+{
+	added.clear();
+	removed.clear();
+
+	for (auto mit = m_pairChanges.begin(); mit != m_pairChanges.end(); mit++)
+	{
+		int first = (int)(unsigned int)(mit->first >> 32);
+		int second = (int)(unsigned int)(mit->first & 0xFFFFFFFF);
+
+		bool paired = false;
+
+		auto firstLookup = m_entryLookup.find(first);
+		auto secondLookup = m_entryLookup.find(second);
+
+		if (firstLookup != m_entryLookup.end() &&
+			secondLookup != m_entryLookup.end())
+		{
+			paired = m_pairs.count(getPairKey(firstLookup->second, secondLookup->second)) != 0;
+		}
+
+		if (paired && !mit->second)
+		{
+			added.emplace_back(SweepPair(first, second));
+		}
+		else if (!paired && mit->second)
+		{
+			removed.emplace_back(SweepPair(first, second));
+		}
+	}
+
+	m_pairChanges.clear();
+}
+
+//=============================================================================
+// Function: const int createEntry(const EntityData&)
+// Description:
+// Stores the entity in an entry, reusing a released one if possible.
+// Parameters:
+// const EntityData& entity - The entity to store.
+// Output:
+// const int
+// Returns the index of the entry.
+//=============================================================================
+const int SweepAndPrune::createEntry(const EntityData& entity)
+{
+	int entry = m_freeEntry;
+
+	if (entry != NO_INDEX)
+	{
+		m_freeEntry = m_entries[entry].m_nextFree;
+
+		m_entries[entry] = SweepEntry(entity);
+	}
+	else
+	{
+		entry = (int)m_entries.size();
+
+		m_entries.emplace_back(SweepEntry(entity));
+	}
+
+	return entry;
+}
+
+//=============================================================================
+// Function: void releaseEntry(const int)
+// Description:
+// Puts an entry on the free list so it can be reused.
+// Parameters:
+// const int entry - The entry to release.
+//=============================================================================
+void SweepAndPrune::releaseEntry(const int entry)
+{
+	m_entries[entry].m_nextFree = m_freeEntry;
+	m_freeEntry = entry;
+}
+
+//=============================================================================
+// Function: void setBounds(const int, const Rectangle&)
+// Description:
+// Stores the padded bounding box of a size in an entry.
+// Parameters:
+// const int entry - The entry to update.
+// const Rectangle& size - The entity's size.
+//=============================================================================
+void SweepAndPrune::setBounds(const int entry,
+	const Rectangle& size)
+{
+	SweepEntry& sweepEntry = m_entries[entry];
+
+	sweepEntry.m_min[AXIS_X] = size.getMinX() - PADDING;
+	sweepEntry.m_min[AXIS_Y] = size.getMinY() - PADDING;
+	sweepEntry.m_max[AXIS_X] = size.getMaxX() + PADDING;
+	sweepEntry.m_max[AXIS_Y] = size.getMaxY() + PADDING;
+
+	fMax(m_maxWidth, m_maxWidth, sweepEntry.m_max[AXIS_X] - sweepEntry.m_min[AXIS_X]);
+}
+
+//=============================================================================
+// Function: void sortDown(const int, const int)
+// Description:
+// Moves an endpoint towards the start of its axis until it's in
+// order.
+// Parameters:
+// const int axis - The axis the endpoint is on.
+// const int index - Where the endpoint is.
+//=============================================================================
+void SweepAndPrune::sortDown(const int axis,
+	const int index)
+{
+	const std::vector<Endpoint>& endpoints = m_endpoints[axis];
+
+	int current = index;
+
+	while (0 < current &&
+		endpointLess(endpoints[current], endpoints[current - 1]))
+	{
+		swapEndpoints(axis, current - 1);
+		current--;
+	}
+}
+
+//=============================================================================
+// Function: void sortUp(const int, const int)
+// Description:
+// Moves an endpoint towards the end of its axis until it's in
+// order.
+// Parameters:
+// const int axis - The axis the endpoint is on.
+// const int index - Where the endpoint is.
+//=============================================================================
+void SweepAndPrune::sortUp(const int axis,
+	const int index)
+{
+	const std::vector<Endpoint>& endpoints = m_endpoints[axis];
+
+	int current = index;
+
+	while (current < (int)endpoints.size() - 1 &&
+		endpointLess(endpoints[current + 1], endpoints[current]))
+	{
+		swapEndpoints(axis, current);
+		current++;
+	}
+}
+
+//=============================================================================
+// Function: void swapEndpoints(const int, const int)
+// Description:
+// Swaps an endpoint with the one after it. A min passing back over
+// another entry's max means the two now overlap on this axis, so
+// they become a pair if they overlap on the other axis too. A max
+// passing back over a min means they've separated.
+// Parameters:
+// const int axis - The axis to swap on.
+// const int index - The first of the two endpoints.
+//=============================================================================
+void SweepAndPrune::swapEndpoints(const int axis,
+	const int index)
+{
+	std::vector<Endpoint>& endpoints = m_endpoints[axis];
+
+	const Endpoint& left = endpoints[index];
+	const Endpoint& right = endpoints[index + 1];
+
+	if (left.m_entry != right.m_entry)
+	{
+		if (left.m_isMax && !right.m_isMax)
+		{
+			if (boundsOverlap(left.m_entry, right.m_entry))
+			{
+				addPair(left.m_entry, right.m_entry);
+			}
+		}
+		else if (!left.m_isMax && right.m_isMax)
+		{
+			removePair(left.m_entry, right.m_entry);
+		}
+	}
+
+	std::swap(endpoints[index], endpoints[index + 1]);
+
+	setEndpointIndex(axis, index);
+	setEndpointIndex(axis, index + 1);
+}
+
+//=============================================================================
+// Function: void setEndpointIndex(const int, const int)
+// Description:
+// Tells an endpoint's entry where the endpoint now is.
+// Parameters:
+// const int axis - The axis the endpoint is on.
+// const int index - Where the endpoint is.
+//=============================================================================
+void SweepAndPrune::setEndpointIndex(const int axis,
+	const int index)
+{
+	const Endpoint& endpoint = m_endpoints[axis][index];
+
+	if (endpoint.m_isMax)
+	{
+		m_entries[endpoint.m_entry].m_maxEndpoint[axis] = index;
+	}
+	else
+	{
+		m_entries[endpoint.m_entry].m_minEndpoint[axis] = index;
+	}
+}
+
+//=============================================================================
+// Function: void eraseEndpoint(const int, const int)
+// Description:
+// Takes an endpoint out of its axis and shifts the ones after it
+// down. Removed endpoints are sorted to the end first, so there's
+// rarely anything to shift.
+// Parameters:
+// const int axis - The axis the endpoint is on.
+// const int index - Where the endpoint is.
+//=============================================================================
+void SweepAndPrune::eraseEndpoint(const int axis,
+	const int index)
+{
+	std::vector<Endpoint>& endpoints = m_endpoints[axis];
+
+	endpoints.erase(endpoints.begin() + index);
+
+	for (int i = index; i < (int)endpoints.size(); i++)
+	{
+		setEndpointIndex(axis, i);
+	}
+}
+
+//=============================================================================
+// Function: const bool boundsOverlap(const int, const int) const
+// Description:
+// Checks if the bounding boxes of two entries overlap.
+// Parameters:
+// const int a - The first entry.
+// const int b - The second entry.
+// Output:
+// const bool
+// Returns true if the boxes overlap on both axes.
+//=============================================================================
+const bool SweepAndPrune::boundsOverlap(const int a,
+	const int b) const
+{
+	const SweepEntry& first = m_entries[a];
+
+	return overlapsArea(b,
+		first.m_min[AXIS_X],
+		first.m_min[AXIS_Y],
+		first.m_max[AXIS_X],
+		first.m_max[AXIS_Y]);
+}
+
+//=============================================================================
+// Function: const bool overlapsArea(const int,
+// const float,
+// const float,
+// const float,
+// const float) const
+// Description:
+// Checks if the bounding box of an entry overlaps an area.
+// Parameters:
+// const int entry - The entry to check.
+// const float minX - The left of the area.
+// const float minY - The top of the area.
+// const float maxX - The right of the area.
+// const float maxY - The bottom of the area.
+// Output:
+// const bool
+// Returns true if they overlap.
+//=============================================================================
+const bool SweepAndPrune::overlapsArea(const int entry,
+	const float minX,
+	const float minY,
+	const float maxX,
+	const float maxY) const
+{
+	const SweepEntry& sweepEntry = m_entries[entry];
+
+	return sweepEntry.m_min[AXIS_X] <= maxX &&
+		minX <= sweepEntry.m_max[AXIS_X] &&
+		sweepEntry.m_min[AXIS_Y] <= maxY &&
+		minY <= sweepEntry.m_max[AXIS_Y];
+}
+
+//=============================================================================
+// Function: const int findFirstEndpoint(const float) const
+// Description:
+// Finds the first x endpoint at or after a position.
+// Parameters:
+// const float minX - The position to look from.
+// Output:
+// const int
+// Returns the index of the endpoint, or the endpoint count if
+// they're all before it.
+//=============================================================================
+const int SweepAndPrune::findFirstEndpoint(const float minX) const
+{
+	const std::vector<Endpoint>& endpoints = m_endpoints[AXIS_X];
+
+	auto found = std::lower_bound(endpoints.begin(),
+		endpoints.end(),
+		Endpoint(minX, NO_INDEX, false),
+		endpointLess);
+
+	return (int)(found - endpoints.begin());
+}
+
+//=============================================================================
+// Function: void addPair(const int, const int)
+// Description:
+// Starts a pair between two entries if it isn't already known.
+// Parameters:
+// const int a - The first entry.
+// const int b - The second entry.
+//=============================================================================
+void SweepAndPrune::addPair(const int a,
+	const int b)
+{
+	if (m_pairs.insert(getPairKey(a, b)).second)
+	{
+		recordPairChange(a, b, false);
+	}
+}
+
+//=============================================================================
+// Function: void removePair(const int, const int)
+// Description:
+// Ends a pair between two entries if it's known.
+// Parameters:
+// const int a - The first entry.
+// const int b - The second entry.
+//=============================================================================
+void SweepAndPrune::removePair(const int a,
+	const int b)
+{
+	if (m_pairs.erase(getPairKey(a, b)) != 0)
+	{
+		recordPairChange(a, b, true);
+	}
+}
+
+//=============================================================================
+// Function: void recordPairChange(const int, const int, const bool)
+// Description:
+// Notes that a pair changed, keeping what it was the first time it
+// changed since changes were last collected.
+// Parameters:
+// const int a - The first entry.
+// const int b - The second entry.
+// const bool wasPaired - Whether they were a pair before the change.
+//=============================================================================
+void SweepAndPrune::recordPairChange(const int a,
+	const int b,
+	const bool wasPaired)
+{
+	m_pairChanges.emplace(getPairKey(m_entries[a].m_data.m_id, m_entries[b].m_data.m_id), wasPaired);
+}
+
+//=============================================================================
+// Function: unsigned long long getPairKey(const int, const int)
+// Description:
+// Packs two entries or entity ids into a key, lowest first, so
+// either order finds the same pair.
+// Parameters:
+// const int a - The first entry or id.
+// const int b - The second entry or id.
+// Output:
+// unsigned long long
+// Returns the key.
+//=============================================================================
+unsigned long long SweepAndPrune::getPairKey(const int a,
+	const int b)
+{
+	unsigned long long low = (unsigned long long)(unsigned int)a;
+	unsigned long long high = (unsigned long long)(unsigned int)b;
+
+	if (high < low)
+	{
+		std::swap(low, high);
+	}
+
+	return (low << 32) | high;
+}
+
+//=============================================================================
+// Function: bool endpointLess(const Endpoint&, const Endpoint&)
+// Description:
+// Orders endpoints by value. At the same value mins come first, so
+// boxes that only touch still count as overlapping.
+// Parameters:
+// const Endpoint& a - The first endpoint.
+// const Endpoint& b - The second endpoint.
+// Output:
+// bool
+// Returns true if a comes before b.
+//=============================================================================
+bool SweepAndPrune::endpointLess(const Endpoint& a,
+	const Endpoint& b)
+{
+	return a.m_value < b.m_value ||
+		(a.m_value == b.m_value && !a.m_isMax && b.m_isMax);
+}
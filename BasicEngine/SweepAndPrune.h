@@ -0,0 +1,184 @@
+#pragma once
+//==========================================================================================
+// File Name: SweepAndPrune.h
+// Author: Brian Blackmon
+// Date Created: 11/10/2019
+// Purpose:
+// A sweep and prune broadphase. The bounding box of every entity
+// is kept as a pair of endpoints in one sorted array per axis, and
+// the pairs whose boxes overlap are kept as they change. Moving an
+// entity insertion sorts its endpoints from where they were, so
+// entities that only move a little each frame cost very little,
+// and every swap of two endpoints is where a pair starts or stops
+// overlapping. The pairs that started and stopped overlapping since
+// the last call to collectPairChanges are tracked for the caller.
+//==========================================================================================
+#include "ISpatialIndex.h"
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+struct SweepPair
+{
+	SweepPair(const int first,
+		const int second)
+		:m_first(first),
+		m_second(second)
+	{
+
+	}
+
+	int m_first;
+	int m_second;
+};
+
+class SweepAndPrune : public ISpatialIndex<EntityData>
+{
+public:
+	SweepAndPrune();
+	virtual ~SweepAndPrune();
+
+	const int getCount() const;
+
+	using ISpatialIndex<EntityData>::search;
+
+	virtual void search(const Rectangle& searchArea,
+		ISpatialVisitor<EntityData>& visitor) const;
+	virtual void search(const Line& searchLine,
+		ISpatialVisitor<EntityData>& visitor) const;
+
+	virtual void addEntity(const EntityData& entity);
+	virtual void removeEntity(const EntityData& entity);
+	virtual void moveEntity(const EntityData& entity,
+		const Rectangle& size);
+
+	virtual void nearest(const Vector2D& point,
+		const int count,
+		std::vector<EntityData>& nearest) const;
+
+	virtual void forEachOverlappingPair(ISpatialPairVisitor<EntityData>& visitor) const;
+
+	virtual void clear();
+	virtual void build(const std::vector<EntityData>& entities,
+		ThreadPool *pool = NULL);
+
+	void collectPairChanges(std::vector<SweepPair>& added,
+		std::vector<SweepPair>& removed);
+
+private:
+	static const int NO_INDEX = -1;
+	static const int AXIS_X = 0;
+	static const int AXIS_Y = 1;
+	static const int AXIS_COUNT = 2;
+
+	// getMinX and friends can sit inside the rounded corners the
+	// collision checks use, so entries and searches are both padded by
+	// this much.
+	static constexpr float PADDING = 1.0f;
+
+	struct SweepEntry
+	{
+		SweepEntry(const EntityData& data)
+			:m_data(data),
+			m_nextFree(NO_INDEX)
+		{
+			for (int i = 0; i < AXIS_COUNT; i++)
+			{
+				m_min[i] = 0.0f;
+				m_max[i] = 0.0f;
+				m_minEndpoint[i] = NO_INDEX;
+				m_maxEndpoint[i] = NO_INDEX;
+			}
+		}
+
+		EntityData m_data;
+
+		// The bounding box on each axis, padded to cover corner
+		// rounding.
+		float m_min[AXIS_COUNT];
+		float m_max[AXIS_COUNT];
+
+		// Where the endpoints are in each axis' array.
+		int m_minEndpoint[AXIS_COUNT];
+		int m_maxEndpoint[AXIS_COUNT];
+
+		// Links to the next free entry once this one is released.
+		int m_nextFree;
+	};
+
+	struct Endpoint
+	{
+		Endpoint(const float value,
+			const int entry,
+			const bool isMax)
+			:m_value(value),
+			m_entry(entry),
+			m_isMax(isMax)
+		{
+
+		}
+
+		float m_value;
+		int m_entry;
+		bool m_isMax;
+	};
+
+	std::vector<SweepEntry> m_entries;
+	std::vector<Endpoint> m_endpoints[AXIS_COUNT];
+	std::unordered_map<int, int> m_entryLookup;
+
+	// Keyed by both entries, lowest first.
+	std::unordered_set<unsigned long long> m_pairs;
+
+	// The pairs that changed since changes were last collected, keyed
+	// by entity ids, and whether each was a pair before that.
+	std::unordered_map<unsigned long long, bool> m_pairChanges;
+
+	int m_freeEntry;
+	int m_count;
+
+	// The widest any entry has been on x. Searches start this far
+	// before the area so they don't miss wide entries.
+	float m_maxWidth;
+
+	const int createEntry(const EntityData& entity);
+	void releaseEntry(const int entry);
+
+	void setBounds(const int entry,
+		const Rectangle& size);
+
+	void sortDown(const int axis,
+		const int index);
+	void sortUp(const int axis,
+		const int index);
+	void swapEndpoints(const int axis,
+		const int index);
+	void setEndpointIndex(const int axis,
+		const int index);
+	void eraseEndpoint(const int axis,
+		const int index);
+
+	const bool boundsOverlap(const int a,
+		const int b) const;
+	const bool overlapsArea(const int entry,
+		const float minX,
+		const float minY,
+		const float maxX,
+		const float maxY) const;
+
+	const int findFirstEndpoint(const float minX) const;
+
+	void addPair(const int a,
+		const int b);
+	void removePair(const int a,
+		const int b);
+	void recordPairChange(const int a,
+		const int b,
+		const bool wasPaired);
+
+	static unsigned long long getPairKey(const int a,
+		const int b);
+
+	static bool endpointLess(const Endpoint& a,
+		const Endpoint& b);
+};
@@ -0,0 +1,158 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(const int workerCount)
+	:m_task(NULL),
+	m_taskCount(0),
+	m_nextTask(0),
+	m_busyWorkers(0),
+	m_job(0),
+	m_running(true)
+{
+	int workers = workerCount;
+
+	// By default use every hardware thread, counting the caller.
+	if (workers < 0)
+	{
+		workers = (int)std::thread::hardware_concurrency() - 1;
+	}
+
+	for (int i = 0; i < workers; i++)
+	{
+		m_workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_running = false;
+	}
+
+	m_jobReady.notify_all();
+
+	for (unsigned int i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+}
+
+//=============================================================================
+// Function: const int getThreadCount() const
+// Description:
+// Gets the number of threads that work on a job, including the
+// thread that calls run.
+// Output:
+// const int
+// Returns the thread count.
+//=============================================================================
+const int ThreadPool::getThreadCount() const
+{
+	return (int)m_workers.size() + 1;
+}
+
+//=============================================================================
+// Function: void run(const int, const Task&)
+// Description:
+// Calls the task once for every index from 0 to taskCount - 1,
+// spread across the workers and the calling thread. Returns once
+// every task has finished. Tasks must not call run themselves.
+// Parameters:
+// const int taskCount - The number of tasks to run.
+// const Task& task - The task to call with each index.
+//=============================================================================
+void ThreadPool::run(const int taskCount,
+	const Task& task)
+{
+	if (0 < taskCount)
+	{
+		std::lock_guard<std::mutex> runLock(m_runMutex);
+
+		if (m_workers.empty() || taskCount == 1)
+		{
+			for (int i = 0; i < taskCount; i++)
+			{
+				task(i);
+			}
+		}
+		else
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				m_task = &task;
+				m_taskCount = taskCount;
+				m_nextTask = 0;
+				m_busyWorkers = (int)m_workers.size();
+				m_job++;
+			}
+
+			m_jobReady.notify_all();
+
+			doTasks();
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			while (m_busyWorkers != 0)
+			{
+				m_jobDone.wait(lock);
+			}
+
+			m_task = NULL;
+		}
+	}
+}
+
+//=============================================================================
+// Function: void workerLoop()
+// Description:
+// Waits for a job, works on its tasks and then waits for the next
+// one, until the pool shuts down.
+//=============================================================================
+void ThreadPool::workerLoop()
+{
+	unsigned int lastJob = 0;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (m_running)
+	{
+		if (m_job != lastJob)
+		{
+			lastJob = m_job;
+
+			lock.unlock();
+			doTasks();
+			lock.lock();
+
+			m_busyWorkers--;
+
+			if (m_busyWorkers == 0)
+			{
+				m_jobDone.notify_one();
+			}
+		}
+		else
+		{
+			m_jobReady.wait(lock);
+		}
+	}
+}
+
+//=============================================================================
+// Function: void doTasks()
+// Description:
+// Takes tasks from the current job until there are none left.
+//=============================================================================
+void ThreadPool::doTasks()
+{
+	int index = m_nextTask++;
+
+	while (index < m_taskCount)
+	{
+		(*m_task)(index);
+
+		index = m_nextTask++;
+	}
+}
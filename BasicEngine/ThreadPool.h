@@ -0,0 +1,51 @@
+#pragma once
+//==========================================================================================
+// File Name: ThreadPool.h
+// Author: Brian Blackmon
+// Date Created: 11/8/2019
+// Purpose:
+// A small pool of worker threads for splitting a job into tasks.
+// The thread that calls run works on the tasks too and doesn't
+// return until all of them are finished.
+//==========================================================================================
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+class ThreadPool
+{
+public:
+	typedef std::function<void(const int)> Task;
+
+	ThreadPool(const int workerCount = -1);
+	~ThreadPool();
+
+	const int getThreadCount() const;
+
+	void run(const int taskCount,
+		const Task& task);
+
+private:
+	std::vector<std::thread> m_workers;
+
+	// Only one job runs at a time.
+	std::mutex m_runMutex;
+
+	std::mutex m_mutex;
+	std::condition_variable m_jobReady;
+	std::condition_variable m_jobDone;
+
+	const Task *m_task;
+	int m_taskCount;
+	std::atomic<int> m_nextTask;
+
+	int m_busyWorkers;
+	unsigned int m_job;
+	bool m_running;
+
+	void workerLoop();
+	void doTasks();
+};
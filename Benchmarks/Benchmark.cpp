@@ -0,0 +1,190 @@
+#include "Benchmark.h"
+
+//=============================================================================
+// Function: BenchmarkTimer()
+// Description:
+// Creates a timer, started from now.
+//=============================================================================
+BenchmarkTimer::BenchmarkTimer()
+	:m_start(std::chrono::high_resolution_clock::now())
+{
+
+}
+
+//=============================================================================
+// Function: void start()
+// Description:
+// Starts timing again from now.
+//=============================================================================
+void BenchmarkTimer::start()
+{
+	m_start = std::chrono::high_resolution_clock::now();
+}
+
+//=============================================================================
+// Function: const double getMilliseconds() const
+// Description:
+// Gets how long it's been since the timer was started.
+// Output:
+// const double
+// Returns the time passed in milliseconds.
+//=============================================================================
+const double BenchmarkTimer::getMilliseconds() const
+{
+	std::chrono::duration<double, std::milli> passed =
+		std::chrono::high_resolution_clock::now() - m_start;
+
+	return passed.count();
+}
+
+//=============================================================================
+// Function: const string getLayoutName(const LayoutType)
+// Description:
+// Gets the name to print for a layout.
+// Parameters:
+// const LayoutType layout - The layout to name.
+// Output:
+// const string
+// Returns the layout's name.
+//=============================================================================
+const std::string getLayoutName(const LayoutType layout)
+{
+	std::string name = "unknown";
+
+	switch (layout)
+	{
+	case LAYOUT_UNIFORM:
+	{
+		name = "uniform";
+		break;
+	}
+	case LAYOUT_CLUSTERED:
+	{
+		name = "clustered";
+		break;
+	}
+	case LAYOUT_MIXED:
+	{
+		name = "mixed";
+		break;
+	}
+	default:
+	{
+		break;
+	}
+	}
+
+	return name;
+}
+
+//=============================================================================
+// Function: void createLayout(const LayoutType,
+// const int,
+// const unsigned int,
+// vector<EntityData>&)
+// Description:
+// Fills a buffer with entities laid out across the world. The same
+// seed always gives the same layout, so runs can be compared.
+// Parameters:
+// const LayoutType layout - How to lay the entities out.
+// const int count - How many entities to create.
+// const unsigned int seed - The seed for the random layout.
+// vector<EntityData>& entities - Set to the entities, with ids from 0.
+//=============================================================================
+void createLayout(const LayoutType layout,
+	const int count,
+	const unsigned int seed,
+	std::vector<EntityData>& entities)
+{
+	const int TOWN_COUNT = 20;
+	const float TOWN_RADIUS = 400.0f;
+
+	// One in twenty entities in the mixed layout is large.
+	const int LARGE_EVERY = 20;
+
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> position(0.0f, (float)BENCHMARK_WORLD_SIZE);
+	std::uniform_int_distribution<int> smallSize(16, 64);
+	std::uniform_int_distribution<int> largeSize(256, 1024);
+	std::normal_distribution<float> spread(0.0f, TOWN_RADIUS);
+
+	std::vector<Vector2D> towns;
+
+	for (int i = 0; i < TOWN_COUNT; i++)
+	{
+		towns.push_back(Vector2D(position(random), position(random)));
+	}
+
+	entities.clear();
+	entities.reserve(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		Vector2D center(position(random), position(random));
+
+		int width = smallSize(random);
+		int height = smallSize(random);
+
+		if (layout == LAYOUT_CLUSTERED)
+		{
+			const Vector2D& town = towns[i % TOWN_COUNT];
+
+			center = Vector2D(town.m_x + spread(random), town.m_y + spread(random));
+		}
+		else if (layout == LAYOUT_MIXED && i % LARGE_EVERY == 0)
+		{
+			width = largeSize(random);
+			height = largeSize(random);
+		}
+
+		entities.push_back(EntityData(i, Rectangle(center, width, height)));
+	}
+}
+
+//=============================================================================
+// Function: void createSearchAreas(const int,
+// const int,
+// const int,
+// const unsigned int,
+// vector<Rectangle>&)
+// Description:
+// Fills a buffer with search areas of one size spread over the world.
+// Parameters:
+// const int count - How many areas to create.
+// const int width - The width of every area.
+// const int height - The height of every area.
+// const unsigned int seed - The seed for the random positions.
+// vector<Rectangle>& areas - Set to the areas.
+//=============================================================================
+void createSearchAreas(const int count,
+	const int width,
+	const int height,
+	const unsigned int seed,
+	std::vector<Rectangle>& areas)
+{
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> position(0.0f, (float)BENCHMARK_WORLD_SIZE);
+
+	areas.clear();
+	areas.reserve(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		areas.push_back(Rectangle(Vector2D(position(random), position(random)), width, height));
+	}
+}
+
+//=============================================================================
+// Function: const Rectangle getWorldBounds()
+// Description:
+// Gets the area the layouts are spread across.
+// Output:
+// const Rectangle
+// Returns the world's bounds.
+//=============================================================================
+const Rectangle getWorldBounds()
+{
+	return Rectangle(Vector2D(BENCHMARK_WORLD_SIZE / 2.0f, BENCHMARK_WORLD_SIZE / 2.0f),
+		BENCHMARK_WORLD_SIZE,
+		BENCHMARK_WORLD_SIZE);
+}
@@ -0,0 +1,62 @@
+#pragma once
+//==========================================================================================
+// File Name: Benchmark.h
+// Author: Brian Blackmon
+// Date Created: 11/14/2019
+// Purpose:
+// Timing and entity layouts shared by the benchmark runs.
+//==========================================================================================
+#include "ISpatialIndex.h"
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+// The world every layout is spread across, matching the size the
+// systems were built with before they went unbounded.
+const int BENCHMARK_WORLD_SIZE = 10000;
+
+enum LayoutType
+{
+	// Small entities spread evenly over the world.
+	LAYOUT_UNIFORM,
+
+	// Small entities packed around a few towns.
+	LAYOUT_CLUSTERED,
+
+	// Mostly small entities, with some buildings and terrain pieces
+	// big enough to straddle the tree's split lines.
+	LAYOUT_MIXED,
+
+	LAYOUT_TOTAL
+};
+
+class BenchmarkTimer
+{
+public:
+	BenchmarkTimer();
+
+	void start();
+	const double getMilliseconds() const;
+
+private:
+	std::chrono::high_resolution_clock::time_point m_start;
+};
+
+const std::string getLayoutName(const LayoutType layout);
+
+void createLayout(const LayoutType layout,
+	const int count,
+	const unsigned int seed,
+	std::vector<EntityData>& entities);
+
+void createSearchAreas(const int count,
+	const int width,
+	const int height,
+	const unsigned int seed,
+	std::vector<Rectangle>& areas);
+
+const Rectangle getWorldBounds();
+
+void runQuadtreeBenchmark();
+void runBroadphaseBenchmark();
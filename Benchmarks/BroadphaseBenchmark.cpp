@@ -0,0 +1,209 @@
+#include "Benchmark.h"
+#include "Quadtree.h"
+#include "SweepAndPrune.h"
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+// The limits Game builds its trees with.
+static const int MAX_OBJECTS = 10;
+static const int MAX_LEVELS = 10;
+
+static const int FRAME_COUNT = 200;
+static const int MOVER_SIZE = 24;
+
+// How much room each mover gets in the arena, so every crowd is
+// packed about as tightly.
+static const float AREA_PER_MOVER = 40.0f * 40.0f;
+
+struct CrowdResult
+{
+	CrowdResult()
+		:m_moveTime(0.0),
+		m_pairTime(0.0),
+		m_searchTime(0.0),
+		m_pairs(0),
+		m_found(0)
+	{
+
+	}
+
+	double m_moveTime;
+	double m_pairTime;
+	double m_searchTime;
+
+	long long m_pairs;
+	long long m_found;
+};
+
+class PairCounter : public ISpatialPairVisitor<EntityData>
+{
+public:
+	PairCounter()
+		:m_count(0)
+	{
+
+	}
+
+	virtual bool visit(const EntityData& /*first*/,
+		const EntityData& /*second*/)
+	{
+		m_count++;
+
+		return true;
+	}
+
+	long long m_count;
+};
+
+//=============================================================================
+// Function: CrowdResult runCrowd(ISpatialIndex<EntityData>&,
+// const int,
+// const float)
+// Description:
+// Runs a crowd through an index for a number of frames. Every mover
+// walks a little each frame and turns back at the edge of the arena.
+// Each frame the index is updated with every move, the overlapping
+// pairs are collected, and every mover searches its own box the way
+// PhysicsSystem does.
+// Parameters:
+// ISpatialIndex<EntityData>& index - The index to run the crowd in.
+// const int count - How many movers are in the crowd.
+// const float arenaSize - The width and height of the arena.
+// Output:
+// CrowdResult
+// Returns the time each part took and what was found.
+//=============================================================================
+static CrowdResult runCrowd(ISpatialIndex<EntityData>& index,
+	const int count,
+	const float arenaSize)
+{
+	CrowdResult result;
+
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> position(0.0f, arenaSize);
+	std::uniform_real_distribution<float> speed(-3.0f, 3.0f);
+
+	std::vector<Rectangle> movers;
+	std::vector<Vector2D> velocities;
+	std::vector<int> ids;
+
+	for (int i = 0; i < count; i++)
+	{
+		movers.push_back(Rectangle(Vector2D(position(random), position(random)), MOVER_SIZE, MOVER_SIZE));
+		velocities.push_back(Vector2D(speed(random), speed(random)));
+
+		index.addEntity(EntityData(i, movers[i]));
+	}
+
+	BenchmarkTimer timer;
+
+	for (int frame = 0; frame < FRAME_COUNT; frame++)
+	{
+		timer.start();
+
+		for (int i = 0; i < count; i++)
+		{
+			Rectangle moved = movers[i];
+			Vector2D center = moved.getCenter() + velocities[i];
+
+			if (center.m_x < 0.0f || arenaSize < center.m_x)
+			{
+				velocities[i].m_x = -velocities[i].m_x;
+			}
+
+			if (center.m_y < 0.0f || arenaSize < center.m_y)
+			{
+				velocities[i].m_y = -velocities[i].m_y;
+			}
+
+			moved.setCenter(center);
+
+			index.moveEntity(EntityData(i, movers[i]), moved);
+
+			movers[i] = moved;
+		}
+
+		result.m_moveTime += timer.getMilliseconds();
+		timer.start();
+
+		PairCounter counter;
+
+		index.forEachOverlappingPair(counter);
+
+		result.m_pairs += counter.m_count;
+		result.m_pairTime += timer.getMilliseconds();
+		timer.start();
+
+		for (int i = 0; i < count; i++)
+		{
+			index.searchIDs(movers[i], ids);
+
+			result.m_found += ids.size();
+		}
+
+		result.m_searchTime += timer.getMilliseconds();
+	}
+
+	return result;
+}
+
+//=============================================================================
+// Function: void runBroadphaseBenchmark()
+// Description:
+// Pits the sweep and prune broadphase against the quad trees on
+// crowds of movers that only travel a few pixels a frame. Prints the
+// time per frame to move everything, to collect the overlapping pairs
+// and to search around every mover, and how many pairs and entities
+// were found so the indexes can be checked against each other.
+//=============================================================================
+void runBroadphaseBenchmark()
+{
+	const int CROWD_SIZES[3] = { 1000, 5000, 10000 };
+
+	printf("Broadphase: sweep and prune against quad trees, %d frames\n", FRAME_COUNT);
+
+	for (int crowd = 0; crowd < 3; crowd++)
+	{
+		int count = CROWD_SIZES[crowd];
+		float arenaSize = sqrt(count * AREA_PER_MOVER);
+
+		Rectangle arena(Vector2D(arenaSize / 2.0f, arenaSize / 2.0f),
+			(int)arenaSize + MOVER_SIZE * 2,
+			(int)arenaSize + MOVER_SIZE * 2);
+
+		printf("  %d movers\n", count);
+
+		for (int type = 0; type < 3; type++)
+		{
+			std::unique_ptr<ISpatialIndex<EntityData>> index;
+			const char *name = "";
+
+			if (type == 0)
+			{
+				index.reset(new SweepAndPrune());
+				name = "sweep";
+			}
+			else if (type == 1)
+			{
+				index.reset(new Quadtree(MAX_OBJECTS, MAX_LEVELS, arena));
+				name = "quadtree";
+			}
+			else
+			{
+				index.reset(new Quadtree(MAX_OBJECTS, MAX_LEVELS, arena, Quadtree::LOOSE));
+				name = "loose";
+			}
+
+			CrowdResult result = runCrowd(*index, count, arenaSize);
+
+			printf("    %-9s move %7.3f ms  pairs %7.3f ms  searches %7.3f ms  per frame, %8.1f pairs %9.1f found\n",
+				name,
+				result.m_moveTime / FRAME_COUNT,
+				result.m_pairTime / FRAME_COUNT,
+				result.m_searchTime / FRAME_COUNT,
+				(double)result.m_pairs / FRAME_COUNT,
+				(double)result.m_found / FRAME_COUNT);
+		}
+	}
+}
@@ -0,0 +1,193 @@
+#include "Benchmark.h"
+#include "Quadtree.h"
+#include "Collision.h"
+#include <cstdio>
+
+// The limits Game builds its trees with.
+static const int MAX_OBJECTS = 10;
+static const int MAX_LEVELS = 10;
+
+static const int ENTITY_COUNT = 10000;
+static const int VIEWPORT_COUNT = 2000;
+
+struct QueryResult
+{
+	QueryResult()
+		:m_milliseconds(0.0),
+		m_found(0)
+	{
+
+	}
+
+	double m_milliseconds;
+	long long m_found;
+	QuadtreeQueryStats m_stats;
+};
+
+//=============================================================================
+// Function: QueryResult runQueries(Quadtree&, const vector<Rectangle>&)
+// Description:
+// Searches the tree with every area and times it.
+// Parameters:
+// Quadtree& tree - The tree to search.
+// const vector<Rectangle>& areas - The areas to search with.
+// Output:
+// QueryResult
+// Returns the time taken, the entities found and the tree's counts.
+//=============================================================================
+static QueryResult runQueries(Quadtree& tree,
+	const std::vector<Rectangle>& areas)
+{
+	QueryResult result;
+	std::vector<int> ids;
+
+	tree.resetQueryStats();
+
+	BenchmarkTimer timer;
+
+	for (unsigned int i = 0; i < areas.size(); i++)
+	{
+		tree.searchIDs(areas[i], ids);
+
+		result.m_found += ids.size();
+	}
+
+	result.m_milliseconds = timer.getMilliseconds();
+	result.m_stats = tree.getQueryStats();
+
+	return result;
+}
+
+//=============================================================================
+// Function: long long countOverlaps(const vector<EntityData>&,
+// const vector<Rectangle>&)
+// Description:
+// Checks every area against every entity, to know how many entities
+// the searches should find.
+// Parameters:
+// const vector<EntityData>& entities - The entities to check.
+// const vector<Rectangle>& areas - The areas to check them against.
+// Output:
+// long long
+// Returns how many entity and area pairs collide.
+//=============================================================================
+static long long countOverlaps(const std::vector<EntityData>& entities,
+	const std::vector<Rectangle>& areas)
+{
+	long long found = 0;
+
+	for (unsigned int i = 0; i < areas.size(); i++)
+	{
+		for (unsigned int j = 0; j < entities.size(); j++)
+		{
+			if (rectIntersectRect(areas[i], entities[j].m_size))
+			{
+				found++;
+			}
+		}
+	}
+
+	return found;
+}
+
+//=============================================================================
+// Function: void printQueries(const char*,
+// const QueryResult&,
+// const long long)
+// Description:
+// Prints one line of query results, per query where it makes sense.
+// Parameters:
+// const char *name - What was searched.
+// const QueryResult& result - The results to print.
+// const long long expected - How many entities should have been found.
+//=============================================================================
+static void printQueries(const char *name,
+	const QueryResult& result,
+	const long long expected)
+{
+	double queries = (double)result.m_stats.m_queries;
+
+	if (queries < 1.0)
+	{
+		queries = 1.0;
+	}
+
+	printf("    %-10s %9.2f ms %9.2f us/query %8.1f nodes %8.1f tested %8.1f found %8lld missed\n",
+		name,
+		result.m_milliseconds,
+		(result.m_milliseconds * 1000.0) / queries,
+		(double)result.m_stats.m_nodesVisited / queries,
+		(double)result.m_stats.m_entitiesTested / queries,
+		(double)result.m_stats.m_entitiesReturned / queries,
+		expected - result.m_found);
+}
+
+//=============================================================================
+// Function: void runQuadtreeBenchmark()
+// Description:
+// Compares the loose quad tree against the regular one on 10000
+// entity layouts. Each tree is filled one entity at a time, the way
+// the systems fill it, then searched with screen sized areas, the way
+// RenderSystem does, and with every entity's own box, the way
+// PhysicsSystem does. The regular tree places entities by their
+// center alone, so it misses the ones hanging past their node. How
+// many each tree misses is printed beside what the searches cost.
+//=============================================================================
+void runQuadtreeBenchmark()
+{
+	const float LOOSENESS[2] = { 1.0f, Quadtree::LOOSE };
+	const char *TREE_NAMES[2] = { "regular", "loose" };
+
+	std::vector<EntityData> entities;
+	std::vector<Rectangle> viewports;
+	std::vector<Rectangle> boxes;
+
+	createSearchAreas(VIEWPORT_COUNT, 1280, 720, 2, viewports);
+
+	printf("Quadtree: regular against loose, %d entities\n", ENTITY_COUNT);
+
+	for (int layout = 0; layout < LAYOUT_TOTAL; layout++)
+	{
+		createLayout((LayoutType)layout, ENTITY_COUNT, 1, entities);
+
+		boxes.clear();
+
+		for (unsigned int i = 0; i < entities.size(); i++)
+		{
+			boxes.push_back(entities[i].m_size);
+		}
+
+		printf("  %s\n", getLayoutName((LayoutType)layout).c_str());
+
+		long long viewportOverlaps = countOverlaps(entities, viewports);
+		long long boxOverlaps = countOverlaps(entities, boxes);
+
+		for (int tree = 0; tree < 2; tree++)
+		{
+			Quadtree quadtree(MAX_OBJECTS, MAX_LEVELS, getWorldBounds(), LOOSENESS[tree]);
+
+			BenchmarkTimer timer;
+
+			for (unsigned int i = 0; i < entities.size(); i++)
+			{
+				quadtree.addEntity(entities[i]);
+			}
+
+			double buildTime = timer.getMilliseconds();
+
+			QuadtreeStats stats = quadtree.getStats();
+
+			printf("   %s: %.2f ms to add, %d nodes, depth %d\n",
+				TREE_NAMES[tree],
+				buildTime,
+				stats.m_nodeCount,
+				stats.m_depth);
+
+			QueryResult viewportResult = runQueries(quadtree, viewports);
+			QueryResult boxResult = runQueries(quadtree, boxes);
+
+			printQueries("viewports", viewportResult, viewportOverlaps);
+			printQueries("boxes", boxResult, boxOverlaps);
+		}
+	}
+}
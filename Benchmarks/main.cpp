@@ -0,0 +1,9 @@
+#include "Benchmark.h"
+
+int main()
+{
+	runQuadtreeBenchmark();
+	runBroadphaseBenchmark();
+
+	return 0;
+}
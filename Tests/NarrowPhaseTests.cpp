@@ -0,0 +1,239 @@
+#include "Tests.h"
+#include "NarrowPhase.h"
+#include "Collision.h"
+#include <cmath>
+#include <random>
+#include <string>
+
+static const int PAIR_COUNT = 100003;
+
+// How far the batched and exact answers can drift apart. They work
+// from the same rounded corners, so any real difference is whole
+// pixels.
+static const float TOLERANCE = 0.001f;
+
+//=============================================================================
+// Function: void createPairs(const unsigned int,
+// const bool,
+// vector<Rectangle>&,
+// vector<Rectangle>&)
+// Description:
+// Fills two lists with random boxes to check against each other. Some
+// pairs share a center so their depths tie, and some are placed to
+// touch edge to edge, since those are where the kernels are most
+// likely to disagree. The count isn't a multiple of eight, so the
+// SIMD kernels have a leftover group to finish.
+// Parameters:
+// const unsigned int seed - The seed for the random boxes.
+// const bool rotated - Whether to rotate some of the boxes.
+// vector<Rectangle>& first - Set to the first box of each pair.
+// vector<Rectangle>& second - Set to the second box of each pair.
+//=============================================================================
+static void createPairs(const unsigned int seed,
+	const bool rotated,
+	std::vector<Rectangle>& first,
+	std::vector<Rectangle>& second)
+{
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> position(0, 300);
+	std::uniform_int_distribution<int> size(1, 80);
+	std::uniform_int_distribution<int> quarter(0, 3);
+	std::uniform_int_distribution<int> kind(0, 9);
+	std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+
+	first.clear();
+	second.clear();
+
+	for (int i = 0; i < PAIR_COUNT; i++)
+	{
+		Rectangle a(Vector2D(position(random) + (quarter(random) * 0.25f), (float)position(random)),
+			size(random),
+			size(random));
+		Rectangle b(Vector2D((float)position(random), position(random) + (quarter(random) * 0.5f)),
+			size(random),
+			size(random));
+
+		int pairKind = kind(random);
+
+		if (pairKind == 0)
+		{
+			b = Rectangle(a.getCenter(), a.getWidth() + quarter(random), a.getHeight());
+		}
+		else if (pairKind == 1)
+		{
+			// Even sizes on whole pixels, so the sides meet exactly.
+			a = Rectangle(Vector2D((float)position(random), (float)position(random)), 2 * size(random), 2 * size(random));
+			b = Rectangle(Vector2D(a.getCenter().m_x + (float)((a.getWidth() / 2) + 10), a.getCenter().m_y), 20, a.getHeight());
+		}
+
+		if (rotated && pairKind == 2)
+		{
+			a.setRotation(angle(random));
+		}
+
+		first.push_back(a);
+		second.push_back(b);
+	}
+}
+
+//=============================================================================
+// Function: const bool sameResults(const BoxPairResults&,
+// const BoxPairResults&)
+// Description:
+// Checks that two kernels gave exactly the same answers.
+// Parameters:
+// const BoxPairResults& a - The first kernel's answers.
+// const BoxPairResults& b - The second kernel's answers.
+// Output:
+// const bool
+// Returns true if every flag and penetration matches to the bit.
+//=============================================================================
+static const bool sameResults(const BoxPairResults& a,
+	const BoxPairResults& b)
+{
+	return a.m_overlaps == b.m_overlaps &&
+		a.m_penetrationX == b.m_penetrationX &&
+		a.m_penetrationY == b.m_penetrationY;
+}
+
+//=============================================================================
+// Function: const bool depthsTie(const Rectangle&, const Rectangle&)
+// Description:
+// Checks whether a pair is pushed apart just as far along x as along
+// y. The separating axis test and the kernels can each pick either
+// axis then, and both are right.
+// Parameters:
+// const Rectangle& a - The box being moved out.
+// const Rectangle& b - The box it's moved out of.
+// Output:
+// const bool
+// Returns true if the shortest pushes on x and y are the same.
+//=============================================================================
+static const bool depthsTie(const Rectangle& a,
+	const Rectangle& b)
+{
+	Vector2D aTopLeft = a.getTopLeft();
+	Vector2D aBottomRight = a.getBottomRight();
+	Vector2D bTopLeft = b.getTopLeft();
+	Vector2D bBottomRight = b.getBottomRight();
+
+	float depthX = fmin(bBottomRight.m_x - aTopLeft.m_x, aBottomRight.m_x - bTopLeft.m_x);
+	float depthY = fmin(bBottomRight.m_y - aTopLeft.m_y, aBottomRight.m_y - bTopLeft.m_y);
+
+	return depthX == depthY;
+}
+
+//=============================================================================
+// Function: const bool runNarrowPhaseTests()
+// Description:
+// Checks the batched narrow phase against the exact checks. Every
+// kernel has to give the plain loop's answers to the bit, rotated
+// boxes included. The plain loop has to agree with rectIntersectRect,
+// overlapAmount and getManifold on every unrotated pair, except the
+// direction of the push when the x and y depths tie.
+// Output:
+// const bool
+// Returns true if every check passed.
+//=============================================================================
+const bool runNarrowPhaseTests()
+{
+	const int KERNEL_COUNT = 3;
+	const char *KERNEL_NAMES[KERNEL_COUNT] = { "scalar", "sse2", "avx2" };
+
+	std::vector<Rectangle> first;
+	std::vector<Rectangle> second;
+
+	BoxArrays firstBoxes;
+	BoxArrays secondBoxes;
+	BoxPairResults results[KERNEL_COUNT];
+
+	bool passed = true;
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		bool rotated = pass == 1;
+		std::string boxes = rotated ? "rotated boxes" : "boxes";
+
+		createPairs(pass + 1, rotated, first, second);
+
+		firstBoxes.clear();
+		secondBoxes.clear();
+
+		for (unsigned int i = 0; i < first.size(); i++)
+		{
+			firstBoxes.add(first[i]);
+			secondBoxes.add(second[i]);
+		}
+
+		for (int kernel = 0; kernel < KERNEL_COUNT; kernel++)
+		{
+			overlapBoxPairs(firstBoxes, secondBoxes, results[kernel], (NarrowPhaseKernel)kernel);
+		}
+
+		for (int kernel = 1; kernel < KERNEL_COUNT; kernel++)
+		{
+			passed = checkResult(sameResults(results[KERNEL_SCALAR], results[kernel]),
+				std::string("narrow phase: ") + KERNEL_NAMES[kernel] + " kernel matches the plain loop on " + boxes) && passed;
+		}
+	}
+
+	createPairs(3, false, first, second);
+
+	firstBoxes.clear();
+	secondBoxes.clear();
+
+	for (unsigned int i = 0; i < first.size(); i++)
+	{
+		firstBoxes.add(first[i]);
+		secondBoxes.add(second[i]);
+	}
+
+	overlapBoxPairs(firstBoxes, secondBoxes, results[KERNEL_SCALAR], KERNEL_SCALAR);
+
+	const BoxPairResults& scalar = results[KERNEL_SCALAR];
+
+	int flagMismatches = 0;
+	int overlapMismatches = 0;
+	int manifoldMismatches = 0;
+
+	for (unsigned int i = 0; i < first.size(); i++)
+	{
+		bool overlaps = scalar.m_overlaps[i] != 0;
+
+		CollisionManifold manifold;
+
+		getManifold(first[i], second[i], manifold);
+
+		if (overlaps != rectIntersectRect(first[i], second[i]) ||
+			overlaps != manifold.m_colliding)
+		{
+			flagMismatches++;
+		}
+		else if (!depthsTie(first[i], second[i]))
+		{
+			Vector2D overlap = overlapAmount(first[i], second[i]);
+			Vector2D translation = manifold.getTranslation();
+
+			if (TOLERANCE < fabs(overlap.m_x - scalar.m_penetrationX[i]) ||
+				TOLERANCE < fabs(overlap.m_y - scalar.m_penetrationY[i]))
+			{
+				overlapMismatches++;
+			}
+
+			if (TOLERANCE < fabs(translation.m_x - scalar.m_penetrationX[i]) ||
+				TOLERANCE < fabs(translation.m_y - scalar.m_penetrationY[i]))
+			{
+				manifoldMismatches++;
+			}
+		}
+	}
+
+	passed = checkResult(flagMismatches == 0,
+		"narrow phase: overlaps match rectIntersectRect and getManifold") && passed;
+	passed = checkResult(overlapMismatches == 0,
+		"narrow phase: penetrations match overlapAmount") && passed;
+	passed = checkResult(manifoldMismatches == 0,
+		"narrow phase: penetrations match getManifold") && passed;
+
+	return passed;
+}
@@ -0,0 +1,157 @@
+#include "Tests.h"
+#include "PhysicsSystem.h"
+#include <cmath>
+#include <string>
+
+// A floor of solid tiles along y = FLOOR_Y, with a small box resting
+// on top of it.
+static const int TILE_SIZE = 32;
+static const int TILE_COUNT = 20;
+static const float FLOOR_Y = 200.0f;
+static const int BOX_SIZE = 16;
+static const float RESTING_Y = FLOOR_Y - (TILE_SIZE / 2) - (BOX_SIZE / 2);
+
+// The tile the wall scenario puts on top of the floor.
+static const int WALL_TILE = 10;
+
+static const int BOX_ID = 1;
+static const int FIRST_TILE_ID = 100;
+
+// Boxes collide by their rounded corners, so a box can come to rest
+// up to half a pixel from where its sides meet.
+static const float PIXEL_TOLERANCE = 0.5f;
+
+static const int FRAME_COUNT = 60;
+static const float FRAME_TIME = 1.0f / 60.0f;
+
+//=============================================================================
+// Function: const Vector2D runScenario(const SpatialIndexType,
+// const Vector2D&,
+// const Vector2D&,
+// const bool)
+// Description:
+// Builds the floor in a physics system using the index type, starts
+// the box off with a velocity and runs a second of updates.
+// Parameters:
+// const SpatialIndexType type - The index the system stores boxes in.
+// const Vector2D& start - Where the box's center starts.
+// const Vector2D& velocity - The box's starting velocity.
+// const bool wall - Whether to stand a wall tile on the floor in the
+// box's way.
+// Output:
+// const Vector2D
+// Returns where the box's center ends up.
+//=============================================================================
+static const Vector2D runScenario(const SpatialIndexType type,
+	const Vector2D& start,
+	const Vector2D& velocity,
+	const bool wall)
+{
+	const float WORLD_SIZE = 1024.0f;
+
+	PhysicsSystem physics(10,
+		10,
+		Rectangle(Vector2D(WORLD_SIZE / 2.0f, WORLD_SIZE / 2.0f), (int)WORLD_SIZE, (int)WORLD_SIZE),
+		type,
+		TILE_SIZE * 2);
+
+	for (int i = 0; i < TILE_COUNT; i++)
+	{
+		float x = (float)((TILE_SIZE / 2) + (TILE_SIZE * i));
+
+		physics.createCollisionBox(FIRST_TILE_ID + i,
+			Rectangle(Vector2D(x, FLOOR_Y), TILE_SIZE, TILE_SIZE),
+			true);
+	}
+
+	if (wall)
+	{
+		float x = (float)((TILE_SIZE / 2) + (TILE_SIZE * WALL_TILE));
+
+		physics.createCollisionBox(FIRST_TILE_ID + TILE_COUNT,
+			Rectangle(Vector2D(x, FLOOR_Y - TILE_SIZE), TILE_SIZE, TILE_SIZE),
+			true);
+	}
+
+	physics.createCollisionBox(BOX_ID, Rectangle(start, BOX_SIZE, BOX_SIZE), true);
+	physics.getVelocity(BOX_ID)->addVelocity(velocity);
+
+	for (int i = 0; i < FRAME_COUNT; i++)
+	{
+		physics.update(FRAME_TIME);
+	}
+
+	return physics.getCollisionBox(BOX_ID)->getBox().getCenter();
+}
+
+//=============================================================================
+// Function: const bool runPhysicsTests()
+// Description:
+// Runs the movement scenarios against every index type. A box
+// sliding along the floor has to cross the seams between tiles it
+// only touches edge to edge, while a wall standing on the floor
+// still has to stop it.
+// Output:
+// const bool
+// Returns true if every check passed.
+//=============================================================================
+const bool runPhysicsTests()
+{
+	const int INDEX_COUNT = 6;
+	const SpatialIndexType INDEX_TYPES[INDEX_COUNT] = { INDEX_QUADTREE,
+		INDEX_LOOSE_QUADTREE,
+		INDEX_GRID,
+		INDEX_SWEEP_AND_PRUNE,
+		INDEX_AABB_TREE,
+		INDEX_HASHED_QUADTREE };
+	const char *INDEX_NAMES[INDEX_COUNT] = { "quadtree",
+		"loose quadtree",
+		"grid",
+		"sweep and prune",
+		"aabb tree",
+		"hashed quadtree" };
+
+	// Starting on the first tile, touching the seam to the second.
+	const float START_X = (float)(TILE_SIZE - (BOX_SIZE / 2));
+
+	// Far enough to cross several seams after friction.
+	const float SLIDE_DISTANCE = 150.0f;
+
+	const float WALL_X = (float)((TILE_SIZE * WALL_TILE) - (BOX_SIZE / 2));
+
+	bool passed = true;
+
+	for (int i = 0; i < INDEX_COUNT; i++)
+	{
+		std::string name = INDEX_NAMES[i];
+
+		Vector2D end = runScenario(INDEX_TYPES[i],
+			Vector2D(START_X, RESTING_Y),
+			Vector2D(200.0f, 0.0f),
+			false);
+
+		passed = checkResult(START_X + SLIDE_DISTANCE < end.m_x &&
+			fabs(end.m_y - RESTING_Y) <= PIXEL_TOLERANCE,
+			name + ": box slides across the tile seams") && passed;
+
+		end = runScenario(INDEX_TYPES[i],
+			Vector2D(START_X, RESTING_Y),
+			Vector2D(400.0f, 0.0f),
+			true);
+
+		passed = checkResult(fabs(end.m_x - WALL_X) <= PIXEL_TOLERANCE &&
+			fabs(end.m_y - RESTING_Y) <= PIXEL_TOLERANCE,
+			name + ": box stops at a wall on the floor") && passed;
+
+		end = runScenario(INDEX_TYPES[i],
+			Vector2D(START_X, RESTING_Y - 56.0f),
+			Vector2D(200.0f, 200.0f),
+			false);
+
+		passed = checkResult(START_X + SLIDE_DISTANCE < end.m_x &&
+			fabs(end.m_y - RESTING_Y) <= PIXEL_TOLERANCE,
+			name + ": box lands on the floor and slides") && passed;
+	}
+
+	return passed;
+}
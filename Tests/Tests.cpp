@@ -0,0 +1,21 @@
+#include "Tests.h"
+#include <cstdio>
+
+//=============================================================================
+// Function: const bool checkResult(const bool, const string&)
+// Description:
+// Prints whether a check passed.
+// Parameters:
+// const bool passed - Whether the check passed.
+// const string& name - What was checked.
+// Output:
+// const bool
+// Returns passed, so the results can be and'ed together.
+//=============================================================================
+const bool checkResult(const bool passed,
+	const std::string& name)
+{
+	printf("%s %s\n", passed ? "PASS" : "FAIL", name.c_str());
+
+	return passed;
+}
@@ -0,0 +1,15 @@
+#pragma once
+//==========================================================================================
+// File Name: Tests.h
+// Author: Brian Blackmon
+// Date Created: 11/14/2019
+// Purpose:
+// Reporting shared by the regression tests.
+//==========================================================================================
+#include <string>
+
+const bool checkResult(const bool passed,
+	const std::string& name);
+
+const bool runPhysicsTests();
+const bool runNarrowPhaseTests();
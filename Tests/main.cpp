@@ -0,0 +1,11 @@
+#include "Tests.h"
+
+int main()
+{
+	bool passed = true;
+
+	passed = runPhysicsTests() && passed;
+	passed = runNarrowPhaseTests() && passed;
+
+	return passed ? 0 : 1;
+}